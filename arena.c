@@ -0,0 +1,82 @@
+/**
+ * @file arena.c
+ * @brief Implementação do alocador por arena.
+ */
+
+#include "include/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+void arena_init(Arena *arena, size_t block_size) {
+  arena->head = NULL;
+  arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+}
+
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t alignment) {
+  ArenaBlock *block = arena->head;
+  size_t offset = 0;
+
+  if (block != NULL) {
+    offset = (block->used + alignment - 1) & ~(alignment - 1);
+  }
+  if (block == NULL || offset + size > block->capacity) {
+    // Pedidos maiores que o bloco padrão recebem um bloco exclusivo.
+    size_t capacity = size > arena->block_size ? size : arena->block_size;
+    block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + capacity);
+    if (block == NULL) {
+      fprintf(stderr, "Falha na alocação de memória para a arena.\n");
+      exit(EXIT_FAILURE);
+    }
+    block->capacity = capacity;
+    block->next = arena->head;
+    arena->head = block;
+    offset = 0;
+  }
+
+  block->used = offset + size;
+  return block->data + offset;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  return arena_alloc_aligned(arena, size, alignof(max_align_t));
+}
+
+char *arena_strndup(Arena *arena, const char *s, size_t length) {
+  // Strings não precisam de alinhamento; mantê-las contíguas economiza espaço.
+  char *copy = (char *)arena_alloc_aligned(arena, length + 1, 1);
+  memcpy(copy, s, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+void arena_adopt(Arena *destination, Arena *source) {
+  if (source->head == NULL) {
+    return;
+  }
+  // Os blocos de origem entram depois do bloco atual do destino, que continua
+  // sendo usado para as próximas alocações.
+  ArenaBlock *tail = source->head;
+  while (tail->next != NULL) {
+    tail = tail->next;
+  }
+  if (destination->head == NULL) {
+    destination->head = source->head;
+  } else {
+    tail->next = destination->head->next;
+    destination->head->next = source->head;
+  }
+  source->head = NULL;
+}
+
+void arena_free(Arena *arena) {
+  ArenaBlock *block = arena->head;
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->head = NULL;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file alloc_count.c
+ * @brief Contagem de chamadas de alocação para os benchmarks.
+ *
+ * Intercepta malloc, calloc e realloc (inclusive as chamadas internas da libc,
+ * como strdup) e repassa às implementações da glibc.
+ */
+
+#include "alloc_count.h"
+#include <stddef.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+size_t bench_allocations = 0;
+
+void *malloc(size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  __atomic_fetch_add(&bench_allocations, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
@@ -0,0 +1,14 @@
+/**
+ * @file alloc_count.h
+ * @brief Contador global de alocações dos benchmarks (somente glibc).
+ */
+
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+#include <stddef.h>
+
+/** Número de chamadas a malloc, calloc e realloc desde o início. */
+extern size_t bench_allocations;
+
+#endif // ALLOC_COUNT_H
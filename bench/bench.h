@@ -0,0 +1,95 @@
+/**
+ * @file bench.h
+ * @brief Utilitários compartilhados pelos programas de benchmark.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Retorna o tempo de um relógio monotônico de alta resolução.
+ * @return Tempo em segundos.
+ */
+static inline double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Gerador pseudoaleatório xorshift64* (determinístico por semente).
+ * @param state Estado do gerador (não pode ser zero).
+ * @return O próximo número pseudoaleatório.
+ */
+static inline uint64_t bench_random(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 2685821657736338717ULL;
+}
+
+/**
+ * @brief Sorteia uma palavra de 3 a 12 letras minúsculas.
+ * @param state Estado do gerador.
+ * @param word Recebe a palavra (ao menos 13 bytes).
+ */
+static inline void bench_random_word(uint64_t *state, char *word) {
+  size_t length = 3 + bench_random(state) % 10;
+  for (size_t i = 0; i < length; i++) {
+    word[i] = 'a' + bench_random(state) % 26;
+  }
+  word[length] = '\0';
+}
+
+/**
+ * @brief Distribuição acumulada de Zipf sobre n posições (expoente s; 0 é a
+ * distribuição uniforme).
+ * @return O array de n probabilidades acumuladas, liberado com free.
+ */
+static inline double *bench_zipf_distribution(size_t n, double s) {
+  double *cumulative = (double *)malloc(n * sizeof(double));
+  if (cumulative == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a distribuição.\n");
+    exit(EXIT_FAILURE);
+  }
+  double total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += s == 0 ? 1.0 : pow((double)(i + 1), -s);
+    cumulative[i] = total;
+  }
+  for (size_t i = 0; i < n; i++) {
+    cumulative[i] /= total;
+  }
+  return cumulative;
+}
+
+/**
+ * @brief Sorteia uma posição em [0, n) com probabilidade proporcional a
+ * 1 / (posição + 1)^s, por busca binária na distribuição acumulada.
+ * @param cumulative A distribuição de bench_zipf_distribution.
+ * @param n O número de posições.
+ * @param state Estado do gerador.
+ */
+static inline size_t bench_sample_zipf(const double *cumulative, size_t n,
+                                       uint64_t *state) {
+  double u = (bench_random(state) >> 11) * 0x1.0p-53;
+  size_t low = 0, high = n - 1;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (cumulative[mid] < u)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+#endif // BENCH_H
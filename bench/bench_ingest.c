@@ -0,0 +1,188 @@
+/**
+ * @file bench_ingest.c
+ * @brief Benchmark da leitura e tokenização dos arquivos de música.
+ *
+ * Compara o leitor original (fgets em buffer de 256 bytes, strdup por linha e
+ * strtok) com scan_music_file (arquivo mapeado e tokenizado no lugar).
+ * Ambos contam as palavras no mesmo WordCounter; o benchmark mede MB/s e o
+ * número de alocações por arquivo, sem a inserção nas árvores.
+ *
+ * Uso: bench_ingest [arquivo...]
+ */
+
+#include "../include/repository.h"
+#include "alloc_count.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t words_seen;
+
+static void count_word(const char *word, unsigned int count,
+                       const uint32_t *positions, unsigned int song_id,
+                       unsigned int verse_line, void *context) {
+  words_seen += count;
+}
+
+/**
+ * @brief Leitor original: fgets, strdup por linha e strtok.
+ */
+static bool legacy_scan(const char *filepath, Repository *repo,
+                        SongWordHandler handler, void *context) {
+  FILE *file = fopen(filepath, "r");
+  if (file == NULL) {
+    return false;
+  }
+
+  char line_buffer[256];
+  char song_title[256] = "";
+  char song_author[256] = "";
+  WordCounter word_counts;
+  init_word_counter(&word_counts);
+  char **verses = NULL;
+  int num_verses = 0, verses_capacity = 0;
+  unsigned int length = 0;
+
+  if (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
+    line_buffer[strcspn(line_buffer, "\n")] = '\0';
+    snprintf(song_title, sizeof(song_title), "%s", line_buffer);
+  }
+  if (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
+    line_buffer[strcspn(line_buffer, "\n")] = '\0';
+    snprintf(song_author, sizeof(song_author), "%s", line_buffer);
+  }
+
+  while (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
+    char *line_copy = strdup(line_buffer);
+    bool verse_saved = false;
+    char *save_ptr;
+    for (char *token = strtok_r(line_copy, " \t\n\r", &save_ptr); token;
+         token = strtok_r(NULL, " \t\n\r", &save_ptr)) {
+      char word_copy[256];
+      strncpy(word_copy, token, sizeof(word_copy) - 1);
+      word_copy[sizeof(word_copy) - 1] = '\0';
+      remove_punctuation(word_copy);
+      to_lowercase(word_copy);
+      if (strlen(word_copy) >= 3) {
+        WordCount *wc = find_or_create_word_count(&word_counts, word_copy);
+        if (wc->count == 0) {
+          if (!verse_saved) {
+            if (num_verses == verses_capacity) {
+              verses_capacity = verses_capacity ? verses_capacity * 2 : 16;
+              verses = realloc(verses, verses_capacity * sizeof(char *));
+            }
+            verses[num_verses++] = arena_strndup(
+                &repo->strings, line_buffer, strcspn(line_buffer, "\n"));
+            verse_saved = true;
+          }
+          wc->verse_line = num_verses - 1;
+        }
+        wc->count++;
+        length++;
+      }
+    }
+    free(line_copy);
+  }
+
+  size_t title_length = strlen(song_title);
+  size_t author_length = strlen(song_author);
+  unsigned int song_id =
+      add_song(repo, arena_strndup(&repo->strings, song_title, title_length),
+               arena_strndup(&repo->strings, song_author, author_length),
+               verses, num_verses, length);
+  free(verses);
+
+  // O leitor original não registrava as posições das palavras.
+  for (size_t i = 0; i < word_counts.size; i++) {
+    WordCount *current = &word_counts.entries[i];
+    handler(current->word, current->count, NULL, song_id,
+            current->verse_line, context);
+  }
+  free_word_counter(&word_counts);
+  fclose(file);
+  return true;
+}
+
+typedef bool (*ScanFunction)(const char *, Repository *, SongWordHandler,
+                             void *);
+
+static void run_case(const char *name, ScanFunction scan, char **files,
+                     int num_files, int repetitions) {
+  size_t bytes = 0;
+  for (int i = 0; i < num_files; i++) {
+    struct stat info;
+    if (stat(files[i], &info) == 0) {
+      bytes += (size_t)info.st_size;
+    }
+  }
+
+  words_seen = 0;
+  Repository *repo = create_repository();
+  size_t allocations_before = bench_allocations;
+  double start = bench_now();
+  for (int r = 0; r < repetitions; r++) {
+    for (int i = 0; i < num_files; i++) {
+      scan(files[i], repo, count_word, NULL);
+    }
+  }
+  double elapsed = bench_now() - start;
+  size_t allocations = bench_allocations - allocations_before;
+  free_repository(repo);
+
+  printf("%-10s %9.1f MB/s | %10.1f alocações/arquivo | %zu palavras\n",
+         name, bytes * (double)repetitions / elapsed / 1e6,
+         (double)allocations / ((double)num_files * repetitions),
+         words_seen / repetitions);
+}
+
+/**
+ * @brief Escreve uma música sintética grande em um arquivo temporário.
+ *
+ * Os versos sorteiam palavras de um vocabulário fixo, com maiúsculas e
+ * pontuação, e algumas linhas passam de 256 bytes.
+ */
+static void write_synthetic_song(char *path, size_t lines,
+                                 size_t vocabulary) {
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  char(*words)[12] = malloc(vocabulary * sizeof(*words));
+  for (size_t i = 0; i < vocabulary; i++) {
+    size_t length = 2 + bench_random(&state) % 9;
+    for (size_t c = 0; c < length; c++) {
+      words[i][c] = (c == 0 ? 'A' : 'a') + bench_random(&state) % 26;
+    }
+    words[i][length] = '\0';
+  }
+
+  int fd = mkstemp(path);
+  FILE *file = fdopen(fd, "w");
+  fprintf(file, "Música Sintética\nGerador\n");
+  for (size_t l = 0; l < lines; l++) {
+    size_t count = l % 50 == 0 ? 60 : 4 + bench_random(&state) % 10;
+    for (size_t w = 0; w < count; w++) {
+      fputs(words[bench_random(&state) % vocabulary], file);
+      fputs(w + 1 < count ? (w % 5 == 4 ? ", " : " ") : "!\n", file);
+    }
+  }
+  fclose(file);
+  free(words);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    printf("acervo (%d arquivos)\n", argc - 1);
+    run_case("fgets", legacy_scan, argv + 1, argc - 1, 200);
+    run_case("mmap", scan_music_file, argv + 1, argc - 1, 200);
+  }
+
+  char path[] = "/tmp/bench_ingest_XXXXXX";
+  write_synthetic_song(path, 200000, 5000);
+  char *files[] = {path};
+  printf("música sintética (200000 versos)\n");
+  run_case("fgets", legacy_scan, files, 1, 3);
+  run_case("mmap", scan_music_file, files, 1, 3);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file bench_intersect.c
+ * @brief Benchmark da interseção de listas de ocorrências.
+ *
+ * Sorteia pares de listas de músicas com tamanhos desproporcionais (a
+ * menor com o tamanho dado e a maior de 1 a 1000 vezes maior, como uma
+ * palavra rara e uma comum) e mede, para cada razão de tamanhos:
+ *
+ * - sobre arrays já decodificados, cada implementação vetorial suportada
+ *   (escalar, SSE2, AVX2), a busca exponencial e intersect_sorted,
+ *   conferindo que todas produzem a mesma interseção;
+ * - sobre listas de ocorrências comprimidas, match_terms (que salta pela
+ *   lista maior com os pontos de salto quando a razão passa de
+ *   INTERSECT_GALLOP_RATIO) contra a decodificação completa das duas listas
+ *   seguida de intersect_sorted.
+ *
+ * A vazão é dada em milhões de identificadores de entrada por segundo
+ * (a soma dos dois tamanhos), além do tempo por interseção.
+ *
+ * Uso: bench_intersect [-s tamanho da lista menor] [razão...]
+ */
+
+#include "../include/arena.h"
+#include "../include/intersect.h"
+#include "../include/postings.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Sorteia size identificadores distintos, em ordem crescente, entre
+ * 0 e universe - 1 (cada um entra com probabilidade size / universe).
+ */
+static size_t random_sorted(uint64_t *state, uint32_t *out, size_t size,
+                            uint32_t universe) {
+  uint64_t threshold = (uint64_t)((double)size / universe * 0x1.0p64);
+  size_t n = 0;
+  for (uint32_t id = 0; id < universe && n < size; id++) {
+    if (bench_random(state) <= threshold)
+      out[n++] = id;
+  }
+  return n;
+}
+
+static void build_list(PostingList *list, Arena *arena, const uint32_t *ids,
+                       size_t size) {
+  memset(list, 0, sizeof(*list));
+  for (size_t i = 0; i < size; i++) {
+    uint32_t position = (uint32_t)(ids[i] % 200);
+    add_posting(list, arena, ids[i], 1, &position);
+  }
+}
+
+static bool same_result(const uint32_t *result, size_t size,
+                        const uint32_t *expected, size_t expected_size) {
+  return size == expected_size &&
+         memcmp(result, expected, size * sizeof(uint32_t)) == 0;
+}
+
+static void print_rate(const char *name, size_t input, int repetitions,
+                       double elapsed, bool correct) {
+  printf("  %-22s %9.1f M ids/s | %10.1f us/interseção | %s\n", name,
+         input * (double)repetitions / elapsed / 1e6,
+         elapsed / repetitions * 1e6,
+         correct ? "ok" : "RESULTADO DIFERENTE");
+}
+
+/**
+ * @brief Interseção das listas comprimidas decodificando as duas por
+ * inteiro, sem os pontos de salto.
+ */
+static size_t decode_and_intersect(const PostingList *a, const PostingList *b,
+                                   uint32_t *a_ids, uint32_t *b_ids,
+                                   uint32_t *out) {
+  PostingCursor cursor;
+  size_t a_size = 0, b_size = 0;
+  open_posting_list(&cursor, a);
+  while (posting_cursor_next(&cursor))
+    a_ids[a_size++] = cursor.song_id;
+  open_posting_list(&cursor, b);
+  while (posting_cursor_next(&cursor))
+    b_ids[b_size++] = cursor.song_id;
+  return intersect_sorted(a_ids, a_size, b_ids, b_size, out);
+}
+
+static void run_ratio(size_t small_size, size_t ratio) {
+  uint64_t state = 0x9E3779B97F4A7C15ULL ^ (small_size * 1000 + ratio);
+  size_t large_size = small_size * ratio;
+  // O universo tem o dobro da lista maior: a maior cobre metade das
+  // músicas e a interseção tem cerca de metade da lista menor.
+  uint32_t universe = (uint32_t)(2 * large_size);
+  uint32_t *small = malloc(small_size * sizeof(uint32_t));
+  uint32_t *large = malloc(large_size * sizeof(uint32_t));
+  uint32_t *expected = malloc(small_size * sizeof(uint32_t));
+  uint32_t *out = malloc(small_size * sizeof(uint32_t));
+  small_size = random_sorted(&state, small, small_size, universe);
+  large_size = random_sorted(&state, large, large_size, universe);
+  size_t input = small_size + large_size;
+  int repetitions = (int)(100000000 / input) + 1;
+
+  size_t num_expected = intersect_kernels[0].intersect(
+      small, small_size, large, large_size, expected);
+  printf("razão 1:%zu | %zu e %zu músicas, %zu em comum, %d repetições\n",
+         ratio, small_size, large_size, num_expected, repetitions);
+
+  for (size_t k = 0; k < num_intersect_kernels; k++) {
+    const IntersectKernel *kernel = &intersect_kernels[k];
+    if (!kernel->supported()) {
+      printf("  %-22s (não suportado)\n", kernel->name);
+      continue;
+    }
+    size_t n = 0;
+    double start = bench_now();
+    for (int r = 0; r < repetitions; r++)
+      n = kernel->intersect(small, small_size, large, large_size, out);
+    double elapsed = bench_now() - start;
+    print_rate(kernel->name, input, repetitions, elapsed,
+               same_result(out, n, expected, num_expected));
+  }
+
+  size_t n = 0;
+  double start = bench_now();
+  for (int r = 0; r < repetitions; r++)
+    n = intersect_galloping(small, small_size, large, large_size, out);
+  print_rate("busca exponencial", input, repetitions, bench_now() - start,
+             same_result(out, n, expected, num_expected));
+
+  start = bench_now();
+  for (int r = 0; r < repetitions; r++)
+    n = intersect_sorted(small, small_size, large, large_size, out);
+  print_rate("intersect_sorted", input, repetitions, bench_now() - start,
+             same_result(out, n, expected, num_expected));
+
+  // Listas comprimidas: menos repetições, pois a decodificação domina.
+  Arena arena;
+  arena_init(&arena, 1 << 20);
+  PostingList small_list, large_list;
+  build_list(&small_list, &arena, small, small_size);
+  build_list(&large_list, &arena, large, large_size);
+  repetitions = repetitions / 4 + 1;
+
+  bool correct = true;
+  start = bench_now();
+  for (int r = 0; r < repetitions; r++) {
+    QueryTerm terms[2];
+    open_posting_list(&terms[0].cursor, &small_list);
+    open_posting_list(&terms[1].cursor, &large_list);
+    terms[0].offset = terms[1].offset = 0;
+    uint32_t *songs;
+    n = match_terms(terms, 2, false, &songs);
+    if (r == 0)
+      correct = same_result(songs, n, expected, num_expected);
+    free(songs);
+  }
+  print_rate("match_terms (saltos)", input, repetitions, bench_now() - start,
+             correct);
+
+  // Os arrays já não são necessários e servem de destino da decodificação.
+  start = bench_now();
+  for (int r = 0; r < repetitions; r++)
+    n = decode_and_intersect(&small_list, &large_list, small, large, out);
+  print_rate("decodificação completa", input, repetitions,
+             bench_now() - start, same_result(out, n, expected, num_expected));
+  printf("  %.2f bytes/ocorrência na lista maior\n",
+         (double)posting_list_size(&large_list) / large_size);
+
+  arena_free(&arena);
+  free(small);
+  free(large);
+  free(expected);
+  free(out);
+}
+
+int main(int argc, char **argv) {
+  size_t small_size = 10000;
+  int first_ratio = 1;
+  if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+    small_size = strtoul(argv[2], NULL, 10);
+    first_ratio = 3;
+  }
+  if (small_size == 0) {
+    small_size = 1;
+  }
+
+  if (first_ratio < argc) {
+    for (int i = first_ratio; i < argc; i++) {
+      size_t ratio = strtoul(argv[i], NULL, 10);
+      run_ratio(small_size, ratio > 0 ? ratio : 1);
+    }
+  } else {
+    run_ratio(small_size, 1);
+    run_ratio(small_size, 10);
+    run_ratio(small_size, 100);
+    run_ratio(small_size, 1000);
+  }
+  return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file bench_latency.c
+ * @brief Benchmark da latência por busca, com percentis.
+ *
+ * Carrega os arquivos ou diretórios informados (ou, sem argumentos, um
+ * vocabulário sintético de 100 mil palavras) e executa milhões de buscas na
+ * BST, na AVL, no array ordenado e no array em ordem de Eytzinger, com
+ * palavras presentes e ausentes sorteadas de modo uniforme ou segundo uma
+ * distribuição de Zipf. Para cada combinação informa a vazão (buscas sem
+ * medição individual) e os percentis 50, 99 e 99,9 da latência, medida com
+ * o relógio monotônico em cada busca e descontado o custo da própria
+ * medição.
+ *
+ * Uso: bench_latency [-n buscas] [-s expoente de Zipf] [caminho...]
+ */
+
+#include "../include/ingest.h"
+#include "../include/repository.h"
+#include "../include/structures.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MAX_WORD 64
+
+typedef WordEntry *(*LookupFunction)(const char *word);
+
+static WordEntry *lookup_bst(const char *word) {
+  return search_bst(bin_tree->root, word);
+}
+
+static WordEntry *lookup_avl(const char *word) {
+  return search_avl(avl_tree->root, word);
+}
+
+static WordEntry *lookup_array(const char *word) {
+  return binary_search_array(sorted_word_array, word);
+}
+
+static WordEntry *lookup_eytzinger(const char *word) {
+  return search_eytzinger(eytzinger_array, word);
+}
+
+static const struct {
+  const char *name;
+  LookupFunction lookup;
+} engines[] = {{"BST", lookup_bst},
+               {"AVL", lookup_avl},
+               {"array", lookup_array},
+               {"Eytzinger", lookup_eytzinger}};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Monta um vocabulário sintético diretamente no dicionário global.
+ */
+static void build_synthetic(size_t vocabulary) {
+  uint64_t state = 0x9E3779B97F4A7C15ULL ^ vocabulary;
+  char word[MAX_WORD];
+
+  song_repository = create_repository();
+  const char *name = "Sintética";
+  char *title = arena_strndup(&song_repository->strings, name, strlen(name));
+  char *verse = arena_strndup(&song_repository->strings, "", 0);
+  unsigned int song_id = add_song(song_repository, title, title, &verse, 1, 1);
+  SongOccurrence occurrence = {song_id, 0, 1};
+
+  while (song_repository->dictionary.size < vocabulary) {
+    bench_random_word(&state, word);
+    bool created;
+    WordEntry *entry = add_word_occurrence(&song_repository->dictionary, word,
+                                           1, &occurrence, &created);
+    if (created) {
+      insert_word(&song_repository->nodes, entry);
+      insert_word_avl(&song_repository->nodes, entry);
+    }
+  }
+}
+
+static void load_path(const char *path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  if (S_ISDIR(info.st_mode)) {
+    process_music_directory(path, 0);
+  } else {
+    process_music_file_for_word_count(path, NULL, NULL);
+  }
+}
+
+/**
+ * @brief Mede uma carga de consultas em uma estrutura.
+ *
+ * A vazão vem de uma passada sem medição individual; os percentis, de uma
+ * segunda passada que mede cada busca.
+ */
+static void run_workload(const char *engine, LookupFunction lookup,
+                         char (*queries)[MAX_WORD], size_t num_queries,
+                         bool expect_found, uint32_t *latencies,
+                         uint64_t timer_overhead) {
+  size_t found = 0;
+  double start = bench_now();
+  for (size_t i = 0; i < num_queries; i++) {
+    found += lookup(queries[i]) != NULL;
+  }
+  double elapsed = bench_now() - start;
+
+  for (size_t i = 0; i < num_queries; i++) {
+    uint64_t before = now_ns();
+    found += lookup(queries[i]) != NULL;
+    uint64_t after = now_ns();
+    uint64_t latency = after - before;
+    latencies[i] = latency > timer_overhead
+                       ? (uint32_t)(latency - timer_overhead)
+                       : 0;
+  }
+  qsort(latencies, num_queries, sizeof(uint32_t), compare_u32);
+
+  bool correct = found == (expect_found ? 2 * num_queries : 0);
+  printf("    %-10s %7.2f M buscas/s | p50 %6u ns | p99 %6u ns | "
+         "p99,9 %6u ns%s\n",
+         engine, num_queries / elapsed / 1e6,
+         latencies[num_queries / 2], latencies[num_queries * 99 / 100],
+         latencies[num_queries * 999 / 1000], correct ? "" : " [ERRO]");
+}
+
+int main(int argc, char **argv) {
+  size_t num_queries = 1000000;
+  double zipf_exponent = 1.0;
+  int first_path = 1;
+  for (; first_path < argc; first_path++) {
+    if (strcmp(argv[first_path], "-n") == 0 && first_path + 1 < argc) {
+      num_queries = strtoul(argv[++first_path], NULL, 10);
+    } else if (strcmp(argv[first_path], "-s") == 0 &&
+               first_path + 1 < argc) {
+      zipf_exponent = strtod(argv[++first_path], NULL);
+    } else {
+      break;
+    }
+  }
+  if (num_queries == 0) {
+    num_queries = 1;
+  }
+
+  initialize_tree(bin_tree);
+  initialize_tree(avl_tree);
+  if (first_path < argc) {
+    for (int i = first_path; i < argc; i++) {
+      load_path(argv[i]);
+    }
+  } else {
+    build_synthetic(100000);
+  }
+  if (song_repository == NULL || song_repository->dictionary.size == 0) {
+    fprintf(stderr, "Nenhuma palavra carregada.\n");
+    return 1;
+  }
+  update_search_structures(song_repository);
+  eytzinger_array = build_eytzinger_array(sorted_word_array);
+
+  // A popularidade (posição na distribuição de Zipf) é atribuída às
+  // palavras em ordem de criação, que não tem relação com a ordem
+  // alfabética. As ausentes são palavras aleatórias fora do dicionário.
+  const Dictionary *dictionary = &song_repository->dictionary;
+  size_t vocabulary = dictionary->size;
+  uint64_t state = 0x853C49E6748FEA9BULL;
+  char(*misses)[MAX_WORD] = malloc(vocabulary * sizeof(*misses));
+  for (size_t i = 0; i < vocabulary; i++) {
+    do {
+      bench_random_word(&state, misses[i]);
+    } while (find_word(dictionary, misses[i]) != NULL);
+  }
+
+  double *zipf = bench_zipf_distribution(vocabulary, zipf_exponent);
+  char(*queries)[MAX_WORD] = malloc(num_queries * sizeof(*queries));
+  uint32_t *latencies = malloc(num_queries * sizeof(uint32_t));
+
+  // Custo de uma medição vazia (mediana de pares de leituras do relógio).
+  for (size_t i = 0; i < num_queries && i < 100000; i++) {
+    uint64_t before = now_ns();
+    latencies[i] = (uint32_t)(now_ns() - before);
+  }
+  size_t samples = num_queries < 100000 ? num_queries : 100000;
+  qsort(latencies, samples, sizeof(uint32_t), compare_u32);
+  uint64_t timer_overhead = latencies[samples / 2];
+
+  printf("%zu palavras, %zu buscas por carga, Zipf s = %.2f, custo da "
+         "medição descontado: %llu ns\n",
+         vocabulary, num_queries, zipf_exponent,
+         (unsigned long long)timer_overhead);
+
+  static const char *workloads[] = {"presentes, uniforme", "presentes, Zipf",
+                                    "ausentes, uniforme", "ausentes, Zipf"};
+  for (int w = 0; w < 4; w++) {
+    bool hits = w < 2, skewed = w % 2 == 1;
+    for (size_t i = 0; i < num_queries; i++) {
+      // As consultas são cópias das palavras, fora das estruturas
+      // indexadas; palavras longas demais para a cópia são sorteadas de novo.
+      const char *word;
+      do {
+        size_t k = skewed ? bench_sample_zipf(zipf, vocabulary, &state)
+                          : bench_random(&state) % vocabulary;
+        word = hits ? dictionary->entries[k]->word : misses[k];
+      } while (strlen(word) >= MAX_WORD);
+      strcpy(queries[i], word);
+    }
+    printf("  %s\n", workloads[w]);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+      run_workload(engines[e].name, engines[e].lookup, queries, num_queries,
+                   hits, latencies, timer_overhead);
+    }
+  }
+
+  free(queries);
+  free(latencies);
+  free(misses);
+  free(zipf);
+  return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file bench_live.c
+ * @brief Teste de estresse das consultas concorrentes à carga (LiveIndex).
+ *
+ * Uma thread escritora carrega músicas sintéticas, uma a uma, nas
+ * estruturas globais e publica uma versão do índice a cada lote, enquanto
+ * as threads leitoras fazem buscas de palavras sem parar na versão
+ * publicada. A rodada é repetida com 1, 2, 4... leitoras, até o número
+ * pedido (o número de núcleos, por padrão), a partir de um índice vazio.
+ *
+ * Cada música s tem duas vezes a palavra "refrao" e uma vez a palavra
+ * "unica" seguida de s escrito em letras. As leitoras conferem, em cada
+ * consulta de conferência, que a versão é coerente: com n músicas, "refrao"
+ * está em n músicas com 2n ocorrências, a palavra única da música n - 1
+ * existe e a da música n, ainda não publicada, não; e que o número da
+ * versão nunca diminui. Uma versão parcialmente carregada, ou liberada
+ * durante a consulta, quebra essas igualdades.
+ *
+ * Informa a vazão das buscas (total e por leitora), as versões publicadas
+ * e o tempo médio de publicação, as versões liberadas e as violações
+ * encontradas.
+ *
+ * Uso: bench_live [-s músicas] [-b músicas por versão] [-r leitoras]
+ */
+
+#include "../include/live.h"
+#include "../include/repository.h"
+#include "bench.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Vocabulário das músicas sintéticas. */
+#define VOCABULARY 20000
+
+/** Uma a cada CHECK_INTERVAL consultas de uma leitora é de conferência. */
+#define CHECK_INTERVAL 64
+
+/**
+ * @struct ReaderState
+ * @brief Estado e resultados de uma thread leitora.
+ */
+typedef struct {
+  pthread_t thread;      /**< Identificador da thread. */
+  LiveIndex *index;      /**< O índice compartilhado. */
+  const int *done;       /**< Fim da carga (acesso atômico). */
+  uint64_t seed;         /**< Semente do gerador. */
+  size_t lookups;        /**< Buscas feitas. */
+  size_t found;          /**< Buscas com a palavra encontrada. */
+  size_t checks;         /**< Consultas de conferência. */
+  size_t violations;     /**< Conferências que falharam. */
+  uint64_t last_version; /**< Última versão vista. */
+} ReaderState;
+
+/** Escreve s em letras (base 26), depois de "unica". */
+static void unique_word(char *out, unsigned int s) {
+  char *p = out + sprintf(out, "unica");
+  do {
+    *p++ = (char)('a' + s % 26);
+    s /= 26;
+  } while (s > 0);
+  *p = '\0';
+}
+
+static void vocabulary_word(char *out, uint64_t id) {
+  sprintf(out, "pal%c%c%llu", 'a' + (int)(id % 26), 'a' + (int)(id / 26 % 26),
+          (unsigned long long)id);
+}
+
+/**
+ * @brief Grava músicas sintéticas em um diretório temporário.
+ *
+ * @param directory Modelo do diretório (alterado por mkdtemp).
+ * @param num_songs Número de músicas.
+ * @return Os caminhos dos arquivos, na ordem das músicas.
+ */
+static char **write_synthetic_songs(char *directory, int num_songs) {
+  uint64_t state = 0x853C49E6748FEA9BULL;
+  char **paths = malloc(num_songs * sizeof(char *));
+  char word[32];
+
+  if (mkdtemp(directory) == NULL) {
+    perror(directory);
+    exit(EXIT_FAILURE);
+  }
+  for (int s = 0; s < num_songs; s++) {
+    paths[s] = malloc(strlen(directory) + 32);
+    sprintf(paths[s], "%s/%d.txt", directory, s);
+    FILE *file = fopen(paths[s], "w");
+    if (file == NULL) {
+      perror(paths[s]);
+      exit(EXIT_FAILURE);
+    }
+    unique_word(word, (unsigned int)s);
+    fprintf(file, "Canção Sintética %d\nIntérprete Sintético %d\n\n", s,
+            s % 97);
+    fprintf(file, "refrao %s refrao\n", word);
+    for (int w = 0; w < 200; w++) {
+      vocabulary_word(word, bench_random(&state) % VOCABULARY);
+      fprintf(file, "%s%s", word, w % 8 == 7 ? "\n" : " ");
+    }
+    fclose(file);
+  }
+  return paths;
+}
+
+/**
+ * @brief Confere a coerência de uma versão.
+ * @return true se a versão está coerente.
+ */
+static bool check_version(const Snapshot *snapshot) {
+  uint32_t n = snapshot->num_songs;
+  const SnapshotWord *chorus = snapshot_find_word(snapshot, "refrao");
+  if (n == 0)
+    return chorus == NULL && snapshot->num_words == 0;
+  if (chorus == NULL || chorus->num_songs != n ||
+      chorus->total_word_count != 2 * n)
+    return false;
+  char word[32];
+  unique_word(word, n - 1);
+  if (snapshot_find_word(snapshot, word) == NULL)
+    return false;
+  unique_word(word, n);
+  return snapshot_find_word(snapshot, word) == NULL;
+}
+
+static void *reader_run(void *argument) {
+  ReaderState *state = (ReaderState *)argument;
+  LiveReader *reader = live_index_register(state->index);
+  if (reader == NULL) {
+    fprintf(stderr, "Posições de leitora esgotadas.\n");
+    exit(EXIT_FAILURE);
+  }
+  char word[32];
+  while (!__atomic_load_n(state->done, __ATOMIC_ACQUIRE)) {
+    for (int i = 0; i < CHECK_INTERVAL; i++) {
+      vocabulary_word(word, bench_random(&state->seed) % (2 * VOCABULARY));
+      const LiveVersion *version = live_index_begin(state->index, reader);
+      if (snapshot_find_word(version->snapshot, word) != NULL)
+        state->found++;
+      live_index_end(reader);
+    }
+    state->lookups += CHECK_INTERVAL;
+
+    const LiveVersion *version = live_index_begin(state->index, reader);
+    bool consistent = check_version(version->snapshot) &&
+                      version->number >= state->last_version;
+    state->last_version = version->number;
+    live_index_end(reader);
+    state->checks++;
+    if (!consistent)
+      state->violations++;
+  }
+  live_index_unregister(reader);
+  return NULL;
+}
+
+static void reset_index(void) {
+  free_count_index(count_index);
+  count_index = NULL;
+  free_eytzinger_array(eytzinger_array);
+  eytzinger_array = NULL;
+  free_word_array(sorted_word_array);
+  sorted_word_array = NULL;
+  bin_tree->root = NULL;
+  avl_tree->root = NULL;
+  if (avl_frequency_tree != NULL)
+    avl_frequency_tree->root = NULL;
+  free_repository(song_repository);
+  song_repository = NULL;
+}
+
+static void run_round(char **paths, int num_songs, int batch,
+                      int num_readers) {
+  int done = 0;
+  LiveIndex *index = create_live_index();
+  ReaderState *readers = calloc(num_readers, sizeof(ReaderState));
+  for (int r = 0; r < num_readers; r++) {
+    readers[r].index = index;
+    readers[r].done = &done;
+    readers[r].seed = 0x9E3779B97F4A7C15ULL * (r + 1);
+    if (pthread_create(&readers[r].thread, NULL, reader_run, &readers[r]) !=
+        0) {
+      perror("pthread_create");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // A escritora: carga arquivo a arquivo e uma versão a cada lote.
+  double publishing = 0;
+  double start = bench_now();
+  for (int s = 0; s < num_songs; s++) {
+    process_music_file_for_word_count(paths[s], NULL, NULL);
+    if ((s + 1) % batch == 0 || s + 1 == num_songs) {
+      double publish_start = bench_now();
+      live_index_refresh(index);
+      publishing += bench_now() - publish_start;
+    }
+  }
+  double elapsed = bench_now() - start;
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+
+  size_t lookups = 0, found = 0, checks = 0, violations = 0;
+  for (int r = 0; r < num_readers; r++) {
+    pthread_join(readers[r].thread, NULL);
+    lookups += readers[r].lookups;
+    found += readers[r].found;
+    checks += readers[r].checks;
+    violations += readers[r].violations;
+  }
+  // A versão final tem todas as músicas.
+  if (index->current->snapshot->num_songs != (uint32_t)num_songs ||
+      !check_version(index->current->snapshot))
+    violations++;
+
+  uint64_t published = index->num_published;
+  live_index_synchronize(index);
+  uint64_t reclaimed = index->num_reclaimed;
+  printf("%3d leitora(s) | %9.0f buscas/s (%8.0f por leitora, %2.0f%% "
+         "encontradas) | %4llu versões, %6.2f ms/publicação, %4llu "
+         "liberadas | carga %.2f s | %zu conferências, %zu violações\n",
+         num_readers, lookups / elapsed, lookups / elapsed / num_readers,
+         lookups > 0 ? 100.0 * found / lookups : 0.0,
+         (unsigned long long)published, publishing / published * 1e3,
+         (unsigned long long)reclaimed, elapsed, checks, violations);
+
+  free_live_index(index);
+  free(readers);
+  reset_index();
+}
+
+int main(int argc, char **argv) {
+  int num_songs = 2000, batch = 50;
+  int max_readers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-s") == 0) {
+      num_songs = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "-b") == 0) {
+      batch = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "-r") == 0) {
+      max_readers = atoi(argv[i + 1]);
+    }
+  }
+  if (num_songs < 1)
+    num_songs = 1;
+  if (batch < 1)
+    batch = 1;
+  if (max_readers < 1)
+    max_readers = 1;
+  if (max_readers > LIVE_MAX_READERS)
+    max_readers = LIVE_MAX_READERS;
+
+  char directory[] = "/tmp/bench_live_XXXXXX";
+  char **paths = write_synthetic_songs(directory, num_songs);
+  initialize_tree(bin_tree);
+  initialize_tree(avl_tree);
+
+  printf("%d músicas, uma versão a cada %d\n", num_songs, batch);
+  for (int readers = 1;; readers *= 2) {
+    if (readers > max_readers)
+      readers = max_readers;
+    run_round(paths, num_songs, batch, readers);
+    if (readers == max_readers)
+      break;
+  }
+
+  for (int s = 0; s < num_songs; s++) {
+    unlink(paths[s]);
+    free(paths[s]);
+  }
+  free(paths);
+  rmdir(directory);
+  return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file bench_lookup.c
+ * @brief Benchmark da busca de palavras nos quatro mecanismos.
+ *
+ * Indexa vocabulários sintéticos de tamanhos crescentes (palavras aleatórias
+ * inseridas em ordem aleatória) e mede o tempo médio por busca na BST, na
+ * AVL, no array ordenado e no array em ordem de Eytzinger, para palavras
+ * presentes e ausentes. As árvores também são percorridas com strcmp em
+ * cada nó, como antes dos prefixos nos nós, e o benchmark conta quantas
+ * comparações por busca ainda precisam acessar a string.
+ *
+ * Uso: bench_lookup [tamanho do vocabulário...]
+ */
+
+#include "../include/repository.h"
+#include "../include/structures.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_QUERIES 200000
+#define MAX_WORD 16
+
+typedef WordEntry *(*LookupFunction)(const char *word);
+
+static WordEntry *lookup_bst(const char *word) {
+  return search_bst(bin_tree->root, word);
+}
+
+static WordEntry *lookup_avl(const char *word) {
+  return search_avl(avl_tree->root, word);
+}
+
+static WordEntry *lookup_array(const char *word) {
+  return binary_search_array(sorted_word_array, word);
+}
+
+static WordEntry *lookup_eytzinger(const char *word) {
+  return search_eytzinger(eytzinger_array, word);
+}
+
+/**
+ * @brief Busca comparando com strcmp a palavra de cada nó visitado.
+ */
+static WordEntry *search_strcmp(Node *root, const char *word) {
+  while (root != NULL) {
+    int comparison = strcmp(word, root->entry->word);
+    if (comparison == 0)
+      return root->entry;
+    root = comparison < 0 ? root->left : root->right;
+  }
+  return NULL;
+}
+
+static WordEntry *lookup_bst_strcmp(const char *word) {
+  return search_strcmp(bin_tree->root, word);
+}
+
+static WordEntry *lookup_avl_strcmp(const char *word) {
+  return search_strcmp(avl_tree->root, word);
+}
+
+/**
+ * @brief Conta, para as consultas informadas, os nós visitados e quantos
+ * deles exigiram acessar a string (prefixos empatados e as duas palavras
+ * com mais de 8 bytes).
+ */
+static void count_comparisons(const char *name, Node *root,
+                              char (*queries)[MAX_WORD]) {
+  size_t visited = 0, string_accesses = 0;
+  for (size_t i = 0; i < NUM_QUERIES; i++) {
+    WordKey key = make_word_key(queries[i]);
+    for (Node *node = root; node != NULL;) {
+      visited++;
+      string_accesses += key.prefix == node->key_prefix && key.length > 8 &&
+                         node->key_length > 8;
+      int comparison = compare_word_key(&key, node);
+      if (comparison == 0)
+        break;
+      node = comparison < 0 ? node->left : node->right;
+    }
+  }
+  printf("  %-10s %8.2f comparações/busca | acessos à string: %.2f com "
+         "strcmp, %.4f com prefixo\n",
+         name, (double)visited / NUM_QUERIES, (double)visited / NUM_QUERIES,
+         (double)string_accesses / NUM_QUERIES);
+}
+
+static void run_engine(const char *name, LookupFunction lookup,
+                       char (*hits)[MAX_WORD], char (*misses)[MAX_WORD]) {
+  size_t found = 0;
+  double start = bench_now();
+  for (size_t i = 0; i < NUM_QUERIES; i++) {
+    found += lookup(hits[i]) != NULL;
+  }
+  double hit_time = bench_now() - start;
+
+  start = bench_now();
+  for (size_t i = 0; i < NUM_QUERIES; i++) {
+    found += lookup(misses[i]) != NULL;
+  }
+  double miss_time = bench_now() - start;
+
+  printf("  %-10s %8.1f ns/busca (presentes) | %8.1f ns/busca (ausentes)%s\n",
+         name, hit_time * 1e9 / NUM_QUERIES, miss_time * 1e9 / NUM_QUERIES,
+         found == NUM_QUERIES ? "" : " [ERRO]");
+}
+
+static void run_size(size_t vocabulary) {
+  uint64_t state = 0x9E3779B97F4A7C15ULL ^ vocabulary;
+  char word[MAX_WORD];
+
+  song_repository = create_repository();
+  const char *name = "Sintética";
+  char *title = arena_strndup(&song_repository->strings, name, strlen(name));
+  char *verse = arena_strndup(&song_repository->strings, "", 0);
+  unsigned int song_id = add_song(song_repository, title, title, &verse, 1, 1);
+  SongOccurrence occurrence = {song_id, 0, 1};
+
+  while (song_repository->dictionary.size < vocabulary) {
+    bench_random_word(&state, word);
+    bool created;
+    WordEntry *entry = add_word_occurrence(&song_repository->dictionary, word,
+                                           1, &occurrence, &created);
+    if (created) {
+      insert_word(&song_repository->nodes, entry);
+      insert_word_avl(&song_repository->nodes, entry);
+    }
+  }
+  update_search_structures(song_repository);
+  double start = bench_now();
+  eytzinger_array = build_eytzinger_array(sorted_word_array);
+  double build_time = bench_now() - start;
+
+  // As consultas são cópias das palavras, fora das estruturas indexadas.
+  char(*hits)[MAX_WORD] = malloc(NUM_QUERIES * sizeof(*hits));
+  char(*misses)[MAX_WORD] = malloc(NUM_QUERIES * sizeof(*misses));
+  for (size_t i = 0; i < NUM_QUERIES; i++) {
+    WordEntry *entry =
+        song_repository->dictionary
+            .entries[bench_random(&state) % song_repository->dictionary.size];
+    strcpy(hits[i], entry->word);
+    // Palavras com um dígito nunca são geradas pelo vocabulário.
+    bench_random_word(&state, misses[i]);
+    misses[i][bench_random(&state) % strlen(misses[i])] = '0';
+  }
+
+  printf("vocabulário de %zu palavras (Eytzinger montado em %.1f ms)\n",
+         vocabulary, build_time * 1e3);
+  run_engine("BST", lookup_bst, hits, misses);
+  run_engine("BST strcmp", lookup_bst_strcmp, hits, misses);
+  run_engine("AVL", lookup_avl, hits, misses);
+  run_engine("AVL strcmp", lookup_avl_strcmp, hits, misses);
+  run_engine("array", lookup_array, hits, misses);
+  run_engine("Eytzinger", lookup_eytzinger, hits, misses);
+  count_comparisons("BST", bin_tree->root, hits);
+  count_comparisons("AVL", avl_tree->root, hits);
+
+  free(hits);
+  free(misses);
+  free_eytzinger_array(eytzinger_array);
+  eytzinger_array = NULL;
+  free_word_array(sorted_word_array);
+  sorted_word_array = NULL;
+  bin_tree->root = NULL;
+  avl_tree->root = NULL;
+  avl_frequency_tree->root = NULL;
+  free_repository(song_repository);
+  song_repository = NULL;
+}
+
+int main(int argc, char **argv) {
+  initialize_tree(bin_tree);
+  initialize_tree(avl_tree);
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      run_size(strtoul(argv[i], NULL, 10));
+    }
+  } else {
+    run_size(10000);
+    run_size(100000);
+    run_size(1000000);
+  }
+  return 0;
+}
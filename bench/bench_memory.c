@@ -0,0 +1,176 @@
+/**
+ * @file bench_memory.c
+ * @brief Benchmark da memória usada pelo índice.
+ *
+ * Carrega os arquivos ou diretórios informados (ou músicas sintéticas
+ * gravadas em um diretório temporário) pelas árvores globais, monta o array
+ * ordenado e a árvore de frequência como o menu faz após uma carga e mede a
+ * memória do heap em uso e a memória residente do processo, divididas pelo
+ * número de palavras indexadas, o número de alocações durante a carga e o
+ * tempo de liberação do índice. Também mede as listas de ocorrências: os
+ * bytes codificados e os dos blocos alocados, por ocorrência.
+ *
+ * Uso: bench_memory [-s músicas sintéticas] [arquivo ou diretório...]
+ */
+
+#include "../include/ingest.h"
+#include "../include/repository.h"
+#include "../include/structures.h"
+#include "alloc_count.h"
+#include "bench.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t heap_in_use(void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+static size_t resident_bytes(void) {
+  long pages_total = 0, pages_resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == NULL) {
+    return 0;
+  }
+  if (fscanf(statm, "%ld %ld", &pages_total, &pages_resident) != 2) {
+    pages_resident = 0;
+  }
+  fclose(statm);
+  return (size_t)pages_resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static size_t count_nodes(Node *node) {
+  if (node == NULL)
+    return 0;
+  return 1 + count_nodes(node->left) + count_nodes(node->right);
+}
+
+/**
+ * @brief Grava músicas sintéticas em um diretório temporário.
+ *
+ * Cada música sorteia 300 palavras de um vocabulário de 40000, com títulos e
+ * autores de tamanho realista.
+ *
+ * @param directory Modelo do diretório (alterado por mkdtemp).
+ * @param num_songs Número de músicas.
+ * @return Os caminhos dos arquivos.
+ */
+static char **write_synthetic_songs(char *directory, int num_songs) {
+  const size_t vocabulary = 40000;
+  uint64_t state = 0x853C49E6748FEA9BULL;
+  char **paths = malloc(num_songs * sizeof(char *));
+
+  mkdtemp(directory);
+  for (int s = 0; s < num_songs; s++) {
+    paths[s] = malloc(strlen(directory) + 32);
+    sprintf(paths[s], "%s/%d.txt", directory, s);
+    FILE *file = fopen(paths[s], "w");
+    fprintf(file, "Canção Sintética Número %d\nIntérprete Sintético %d\n\n",
+            s, s % 97);
+    for (int w = 0; w < 300; w++) {
+      uint64_t id = bench_random(&state) % vocabulary;
+      fprintf(file, "pal%c%c%llu%s", 'a' + (int)(id % 26),
+              'a' + (int)(id / 26 % 26), (unsigned long long)id,
+              w % 8 == 7 ? "\n" : " ");
+    }
+    fclose(file);
+  }
+  return paths;
+}
+
+static void load_path(const char *path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  if (S_ISDIR(info.st_mode)) {
+    process_music_directory(path, 0);
+  } else {
+    process_music_file_for_word_count(path, NULL, NULL);
+  }
+}
+
+int main(int argc, char **argv) {
+  char directory[] = "/tmp/bench_memory_XXXXXX";
+  int synthetic_songs = 2000;
+  int first_path = 1;
+  if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+    synthetic_songs = atoi(argv[2]);
+    first_path = 3;
+  }
+  char **paths = argv + first_path;
+  int num_paths = argc - first_path;
+  bool synthetic = num_paths == 0;
+  if (synthetic) {
+    num_paths = synthetic_songs;
+    paths = write_synthetic_songs(directory, num_paths);
+  }
+
+  initialize_tree(bin_tree);
+  initialize_tree(avl_tree);
+
+  size_t heap_before = heap_in_use();
+  size_t resident_before = resident_bytes();
+  size_t allocations_before = bench_allocations;
+  double start = bench_now();
+  for (int i = 0; i < num_paths; i++) {
+    load_path(paths[i]);
+  }
+  update_search_structures(song_repository);
+  double elapsed = bench_now() - start;
+  size_t allocations = bench_allocations - allocations_before;
+  size_t heap = heap_in_use() - heap_before;
+  size_t resident = resident_bytes() - resident_before;
+
+  size_t words = count_nodes(bin_tree->root);
+  size_t nodes = words + count_nodes(avl_tree->root) +
+                 count_nodes(avl_frequency_tree->root);
+  int songs = song_repository->num_songs;
+
+  size_t postings = 0, encoded = 0, allocated = 0;
+  const Dictionary *dictionary = &song_repository->dictionary;
+  for (size_t i = 0; i < dictionary->size; i++) {
+    const PostingList *list = &dictionary->postings[i];
+    postings += list->num_songs;
+    encoded += posting_list_size(list);
+    allocated += posting_list_allocated(list);
+  }
+
+  start = bench_now();
+  free_word_array(sorted_word_array);
+  free_repository(song_repository);
+  double teardown = bench_now() - start;
+
+  if (synthetic) {
+    for (int i = 0; i < num_paths; i++) {
+      unlink(paths[i]);
+      free(paths[i]);
+    }
+    free(paths);
+    rmdir(directory);
+  }
+
+  printf("%d músicas, %zu palavras distintas, %zu nós, %.3f s\n",
+         songs, words, nodes, elapsed);
+  printf("heap em uso: %10zu bytes | %8.1f bytes/palavra\n", heap,
+         (double)heap / words);
+  printf("residente:   %10zu bytes | %8.1f bytes/palavra\n", resident,
+         (double)resident / words);
+  printf("alocações:   %10zu        | %8.1f por música\n", allocations,
+         (double)allocations / songs);
+  printf("liberação:   %10.3f ms\n", teardown * 1e3);
+  printf("ocorrências: %10zu        | %8.1f por palavra\n", postings,
+         (double)postings / words);
+  printf("codificadas: %10zu bytes | %8.2f bytes/ocorrência\n", encoded,
+         (double)encoded / postings);
+  printf("blocos:      %10zu bytes | %8.2f bytes/ocorrência (%.2f com as "
+         "listas no dicionário)\n",
+         allocated, (double)allocated / postings,
+         (double)(allocated + words * sizeof(PostingList)) / postings);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file bench_prefix.c
+ * @brief Benchmark do autocompletar (busca por prefixo).
+ *
+ * Monta vocabulários sintéticos de tamanhos crescentes, com contagens de
+ * cauda longa, e simula a digitação de palavras sorteadas segundo uma
+ * distribuição de Zipf: cada tecla gera uma consulta com o prefixo digitado
+ * até ali. Cada consulta pede as 10 primeiras sugestões em ordem alfabética
+ * e as 10 de maior contagem (com o CountIndex). Informa a vazão e os
+ * percentis 50, 99 e 99,9 e o máximo da latência por consulta, além do
+ * tempo de montagem e da memória do CountIndex.
+ *
+ * Uso: bench_prefix [-n palavras digitadas] [tamanho do vocabulário...]
+ */
+
+#include "../include/prefix.h"
+#include "../include/repository.h"
+#include "../include/structures.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WORD 16
+#define NUM_SUGGESTIONS 10
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Mede uma sequência de consultas e informa vazão e percentis.
+ */
+static void run_queries(const char *name, const WordArray *arr,
+                        const CountIndex *index, char (*queries)[MAX_WORD],
+                        size_t num_queries, uint32_t *latencies) {
+  size_t suggestions = 0;
+  uint64_t total = 0;
+  for (size_t i = 0; i < num_queries; i++) {
+    uint64_t before = now_ns();
+    WordArray *results =
+        search_prefix(arr, index, queries[i], NUM_SUGGESTIONS, NULL);
+    uint64_t after = now_ns();
+    suggestions += results->size;
+    free_word_array(results);
+    latencies[i] = (uint32_t)(after - before);
+    total += after - before;
+  }
+  qsort(latencies, num_queries, sizeof(uint32_t), compare_u32);
+  printf("  %-12s %5.2f M consultas/s | p50 %6u ns | p99 %6u ns | "
+         "p99,9 %6u ns | máx %7u ns | %.1f sugestões/consulta\n",
+         name, num_queries / (total / 1e9) / 1e6, latencies[num_queries / 2],
+         latencies[num_queries * 99 / 100],
+         latencies[num_queries * 999 / 1000], latencies[num_queries - 1],
+         (double)suggestions / num_queries);
+}
+
+static void run_size(size_t vocabulary, size_t num_typed) {
+  uint64_t state = 0x9E3779B97F4A7C15ULL ^ vocabulary;
+  char word[MAX_WORD];
+
+  // As contagens seguem 1e6 / (posição de criação + 1), uma cauda longa
+  // sem relação com a ordem alfabética.
+  double start = bench_now();
+  Repository *repo = create_repository();
+  SongOccurrence occurrence = {0, 0, 1};
+  while (repo->dictionary.size < vocabulary) {
+    bench_random_word(&state, word);
+    unsigned int count =
+        1 + 1000000 / (unsigned int)(repo->dictionary.size + 1);
+    add_word_occurrence(&repo->dictionary, word, count, &occurrence, NULL);
+  }
+  WordArray *sorted = create_word_array();
+  for (size_t i = 0; i < repo->dictionary.size; i++) {
+    add_entry_to_array(sorted, repo->dictionary.entries[i]);
+  }
+  sort_word_array(sorted);
+  double build_time = bench_now() - start;
+
+  start = bench_now();
+  CountIndex *index = build_word_array_count_index(sorted);
+  double index_time = bench_now() - start;
+  size_t index_bytes = (index->size + 2 * index->leaves) * sizeof(uint32_t);
+
+  // Digitação: cada palavra sorteada gera uma consulta por tecla.
+  double *zipf = bench_zipf_distribution(vocabulary, 1.0);
+  size_t capacity = num_typed * MAX_WORD, num_queries = 0;
+  char(*queries)[MAX_WORD] = malloc(capacity * sizeof(*queries));
+  for (size_t t = 0; t < num_typed; t++) {
+    const char *target =
+        repo->dictionary.entries[bench_sample_zipf(zipf, vocabulary, &state)]->word;
+    size_t length = strlen(target);
+    for (size_t k = 1; k <= length; k++) {
+      memcpy(queries[num_queries], target, k);
+      queries[num_queries][k] = '\0';
+      num_queries++;
+    }
+  }
+  uint32_t *latencies = malloc(num_queries * sizeof(uint32_t));
+
+  printf("vocabulário de %zu palavras (montagem %.0f ms), CountIndex em "
+         "%.1f ms, %.1f bytes/palavra; %zu consultas\n",
+         vocabulary, build_time * 1e3, index_time * 1e3,
+         (double)index_bytes / vocabulary, num_queries);
+  run_queries("alfabética", sorted, NULL, queries, num_queries, latencies);
+  run_queries("por contagem", sorted, index, queries, num_queries, latencies);
+
+  free(latencies);
+  free(queries);
+  free(zipf);
+  free_count_index(index);
+  free_word_array(sorted);
+  free_repository(repo);
+}
+
+int main(int argc, char **argv) {
+  size_t num_typed = 100000;
+  int first_size = 1;
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    num_typed = strtoul(argv[2], NULL, 10);
+    first_size = 3;
+  }
+  if (num_typed == 0) {
+    num_typed = 1;
+  }
+
+  if (first_size < argc) {
+    for (int i = first_size; i < argc; i++) {
+      run_size(strtoul(argv[i], NULL, 10), num_typed);
+    }
+  } else {
+    run_size(100000, num_typed);
+    run_size(1000000, num_typed);
+    run_size(4000000, num_typed);
+  }
+  return 0;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file bench_rank.c
+ * @brief Benchmark do ranqueamento BM25 com max-score.
+ *
+ * Monta em memória um catálogo sintético (músicas com tamanhos variados e
+ * palavras sorteadas por uma distribuição de Zipf, como em letras reais) e
+ * compara rank_terms com a avaliação exaustiva, que decodifica as listas
+ * inteiras, acumula a relevância de cada música e seleciona as k maiores
+ * com um heap. Os conjuntos de consultas têm só palavras muito comuns, uma
+ * comum e uma rara, ou palavras sorteadas por Zipf. Para k = 10 e 100,
+ * informa a latência média, os percentis 50 e 99 e o máximo, conferindo
+ * que os resultados coincidem.
+ *
+ * Uso: bench_rank [-s músicas] [-n consultas]
+ */
+
+#include "../include/arena.h"
+#include "../include/postings.h"
+#include "../include/rank.h"
+#include "bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VOCABULARY 50000
+#define MAX_QUERY_WORDS 4
+
+/**
+ * @struct Corpus
+ * @brief Catálogo sintético: uma lista por palavra e os tamanhos.
+ */
+typedef struct {
+  PostingList *lists;      /**< Lista de cada palavra. */
+  unsigned int *max_count; /**< Maior contagem de cada palavra. */
+  uint32_t *lengths;       /**< Tamanho de cada música. */
+  RankCorpus stats;        /**< Estatísticas para o BM25. */
+  Arena arena;             /**< Blocos das listas. */
+} Corpus;
+
+/**
+ * @struct Query
+ * @brief Uma consulta: os índices das palavras.
+ */
+typedef struct {
+  unsigned int words[MAX_QUERY_WORDS]; /**< Palavras (sem repetição). */
+  unsigned int num_words;              /**< Número de palavras. */
+} Query;
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void build_corpus(Corpus *corpus, size_t num_songs,
+                         const double *zipf, uint64_t *state) {
+  corpus->lists = calloc(VOCABULARY, sizeof(PostingList));
+  corpus->max_count = calloc(VOCABULARY, sizeof(unsigned int));
+  corpus->lengths = malloc(num_songs * sizeof(uint32_t));
+  arena_init(&corpus->arena, 1 << 20);
+  uint64_t total_length = 0;
+
+  // As palavras de cada música são ordenadas por (palavra, posição), de
+  // modo que as ocorrências de uma palavra ficam juntas e em ordem.
+  uint32_t *tokens = malloc(400 * sizeof(uint32_t));
+  uint32_t positions[400];
+  for (size_t s = 0; s < num_songs; s++) {
+    uint32_t length = 50 + (uint32_t)(bench_random(state) % 351);
+    for (uint32_t t = 0; t < length; t++) {
+      uint32_t word = (uint32_t)bench_sample_zipf(zipf, VOCABULARY, state);
+      tokens[t] = word << 9 | t;
+    }
+    qsort(tokens, length, sizeof(uint32_t), compare_u32);
+    for (uint32_t t = 0; t < length;) {
+      uint32_t word = tokens[t] >> 9, count = 0;
+      while (t < length && tokens[t] >> 9 == word)
+        positions[count++] = tokens[t++] & 0x1FF;
+      add_posting(&corpus->lists[word], &corpus->arena, (unsigned int)s,
+                  count, positions);
+      if (count > corpus->max_count[word])
+        corpus->max_count[word] = count;
+    }
+    corpus->lengths[s] = length;
+    total_length += length;
+  }
+  free(tokens);
+  corpus->stats.lengths = corpus->lengths;
+  corpus->stats.num_songs = (unsigned int)num_songs;
+  corpus->stats.average_length = (double)total_length / num_songs;
+}
+
+static void free_corpus(Corpus *corpus) {
+  arena_free(&corpus->arena);
+  free(corpus->lists);
+  free(corpus->max_count);
+  free(corpus->lengths);
+}
+
+static bool worse(const RankedSong *a, const RankedSong *b) {
+  return a->score < b->score ||
+         (a->score == b->score && a->song_id > b->song_id);
+}
+
+static void sift_down(RankedSong *heap, size_t size, size_t i) {
+  for (;;) {
+    size_t smallest = i, left = 2 * i + 1, right = left + 1;
+    if (left < size && worse(&heap[left], &heap[smallest]))
+      smallest = left;
+    if (right < size && worse(&heap[right], &heap[smallest]))
+      smallest = right;
+    if (smallest == i)
+      return;
+    RankedSong swap = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = swap;
+    i = smallest;
+  }
+}
+
+/**
+ * @brief Avaliação exaustiva: decodifica todas as listas da consulta.
+ *
+ * @param scores Relevâncias por música (zeradas na entrada e na saída).
+ * @param touched Recebe as músicas com alguma palavra.
+ */
+static size_t rank_exhaustive(const Corpus *corpus, const Query *query,
+                              size_t k, double *scores, uint32_t *touched,
+                              RankedSong *out) {
+  const RankCorpus *stats = &corpus->stats;
+  size_t num_touched = 0;
+  for (unsigned int w = 0; w < query->num_words; w++) {
+    const PostingList *list = &corpus->lists[query->words[w]];
+    double n = list->num_songs;
+    double idf = log(1 + (stats->num_songs - n + 0.5) / (n + 0.5));
+    PostingCursor cursor;
+    open_posting_list(&cursor, list);
+    while (posting_cursor_next(&cursor)) {
+      double relative = stats->lengths[cursor.song_id] / stats->average_length;
+      double normalization = BM25_K1 * (1 - BM25_B + BM25_B * relative);
+      if (scores[cursor.song_id] == 0)
+        touched[num_touched++] = cursor.song_id;
+      scores[cursor.song_id] += idf * cursor.count * (BM25_K1 + 1) /
+                                (cursor.count + normalization);
+    }
+  }
+
+  // As k melhores com um heap de mínimo, ordenado ao final.
+  size_t size = 0;
+  for (size_t i = 0; i < num_touched; i++) {
+    RankedSong song = {touched[i], scores[touched[i]]};
+    scores[touched[i]] = 0;
+    if (size < k) {
+      out[size++] = song;
+      if (size == k) {
+        for (size_t j = k / 2; j-- > 0;)
+          sift_down(out, k, j);
+      }
+    } else if (worse(&out[0], &song)) {
+      out[0] = song;
+      sift_down(out, k, 0);
+    }
+  }
+  if (size < k) {
+    for (size_t j = size / 2; j-- > 0;)
+      sift_down(out, size, j);
+  }
+  for (size_t end = size; end > 1; end--) {
+    RankedSong swap = out[0];
+    out[0] = out[end - 1];
+    out[end - 1] = swap;
+    sift_down(out, end - 1, 0);
+  }
+  return size;
+}
+
+static size_t rank_max_score(const Corpus *corpus, const Query *query,
+                             size_t k, RankedSong *out) {
+  RankTerm terms[MAX_QUERY_WORDS];
+  for (unsigned int w = 0; w < query->num_words; w++) {
+    open_posting_list(&terms[w].cursor, &corpus->lists[query->words[w]]);
+    terms[w].max_count = corpus->max_count[query->words[w]];
+    terms[w].repeats = 1;
+  }
+  return rank_terms(terms, query->num_words, &corpus->stats, k, out);
+}
+
+/**
+ * @brief Confere dois resultados, aceitando trocas entre músicas empatadas
+ * (a ordem das somas pode mudar o último bit da relevância).
+ */
+static bool same_ranking(const RankedSong *a, size_t a_size,
+                         const RankedSong *b, size_t b_size) {
+  if (a_size != b_size)
+    return false;
+  for (size_t i = 0; i < a_size; i++) {
+    if (fabs(a[i].score - b[i].score) > 1e-9 * (1 + fabs(b[i].score)))
+      return false;
+  }
+  return true;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void print_latencies(const char *name, double *latencies,
+                            size_t num_queries, bool correct) {
+  double total = 0;
+  for (size_t i = 0; i < num_queries; i++)
+    total += latencies[i];
+  qsort(latencies, num_queries, sizeof(double), compare_double);
+  printf("    %-10s média %8.1f us | p50 %8.1f us | p99 %8.1f us | "
+         "máx %8.1f us | %s\n",
+         name, total / num_queries * 1e6,
+         latencies[num_queries / 2] * 1e6,
+         latencies[num_queries * 99 / 100] * 1e6,
+         latencies[num_queries - 1] * 1e6,
+         correct ? "ok" : "RESULTADO DIFERENTE");
+}
+
+static void run_queries(const char *name, const Corpus *corpus,
+                        const Query *queries, size_t num_queries) {
+  size_t num_songs = corpus->stats.num_songs;
+  double *scores = calloc(num_songs, sizeof(double));
+  uint32_t *touched = malloc(num_songs * sizeof(uint32_t));
+  double *fast = malloc(num_queries * sizeof(double));
+  double *slow = malloc(num_queries * sizeof(double));
+  RankedSong expected[100], actual[100];
+  size_t ks[] = {10, 100};
+
+  printf("%s\n", name);
+  for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+    size_t k = ks[i];
+    bool correct = true;
+    for (size_t q = 0; q < num_queries; q++) {
+      double start = bench_now();
+      size_t n = rank_max_score(corpus, &queries[q], k, actual);
+      double middle = bench_now();
+      size_t m = rank_exhaustive(corpus, &queries[q], k, scores, touched,
+                                 expected);
+      fast[q] = middle - start;
+      slow[q] = bench_now() - middle;
+      if (!same_ranking(actual, n, expected, m))
+        correct = false;
+    }
+    printf("  k = %zu\n", k);
+    print_latencies("max-score", fast, num_queries, correct);
+    print_latencies("exaustiva", slow, num_queries, correct);
+  }
+  free(scores);
+  free(touched);
+  free(fast);
+  free(slow);
+}
+
+/**
+ * @brief Sorteia uma consulta com palavras distintas; a palavra i vem do
+ * intervalo [first[i], first[i] + range[i]) da ordem de frequência, ou da
+ * distribuição de Zipf se range[i] for 0.
+ */
+static void random_query(Query *query, unsigned int num_words,
+                         const unsigned int *first,
+                         const unsigned int *range, const double *zipf,
+                         uint64_t *state) {
+  query->num_words = 0;
+  while (query->num_words < num_words) {
+    unsigned int i = query->num_words, word;
+    if (range[i] == 0)
+      word = (unsigned int)bench_sample_zipf(zipf, VOCABULARY, state);
+    else
+      word = first[i] + (unsigned int)(bench_random(state) % range[i]);
+    bool repeated = false;
+    for (unsigned int j = 0; j < i; j++)
+      repeated |= query->words[j] == word;
+    if (!repeated)
+      query->words[query->num_words++] = word;
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t num_songs = 50000, num_queries = 1000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-s") == 0)
+      num_songs = strtoul(argv[i + 1], NULL, 10);
+    else if (strcmp(argv[i], "-n") == 0)
+      num_queries = strtoul(argv[i + 1], NULL, 10);
+  }
+  if (num_songs == 0)
+    num_songs = 1;
+  if (num_queries == 0)
+    num_queries = 1;
+
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  double *zipf = bench_zipf_distribution(VOCABULARY, 1.0);
+
+  double start = bench_now();
+  Corpus corpus;
+  build_corpus(&corpus, num_songs, zipf, &state);
+  printf("%zu músicas, %d palavras, tamanho médio %.1f (montagem %.0f ms); "
+         "a palavra mais comum está em %u músicas\n",
+         num_songs, VOCABULARY, corpus.stats.average_length,
+         (bench_now() - start) * 1e3, corpus.lists[0].num_songs);
+
+  Query *queries = malloc(num_queries * sizeof(Query));
+  static const unsigned int common_first[] = {0, 0, 0};
+  static const unsigned int common_range[] = {50, 50, 50};
+  for (size_t q = 0; q < num_queries; q++)
+    random_query(&queries[q], 2 + q % 2, common_first, common_range, zipf,
+                 &state);
+  run_queries("palavras comuns (entre as 50 mais frequentes)", &corpus,
+              queries, num_queries);
+
+  static const unsigned int mixed_first[] = {0, 1000};
+  static const unsigned int mixed_range[] = {50, 9000};
+  for (size_t q = 0; q < num_queries; q++)
+    random_query(&queries[q], 2, mixed_first, mixed_range, zipf, &state);
+  run_queries("uma palavra comum e uma rara", &corpus, queries, num_queries);
+
+  static const unsigned int zipf_first[] = {0, 0, 0, 0};
+  static const unsigned int zipf_range[] = {0, 0, 0, 0};
+  for (size_t q = 0; q < num_queries; q++)
+    random_query(&queries[q], 2 + q % 3, zipf_first, zipf_range, zipf,
+                 &state);
+  run_queries("palavras sorteadas por Zipf", &corpus, queries, num_queries);
+
+  free(queries);
+  free(zipf);
+  free_corpus(&corpus);
+  return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * @file bench_server.c
+ * @brief Gerador de carga para o servidor de consultas (--serve).
+ *
+ * Abre várias conexões com um servidor já em execução e, em cada uma,
+ * envia as consultas em janelas de p consultas seguidas (sem esperar as
+ * respostas, que o servidor executa como um lote) e espera as p respostas
+ * antes da janela seguinte. As consultas vêm de um arquivo, uma por linha,
+ * ou são sorteadas a partir das 1000 palavras mais frequentes do índice
+ * (obtidas com "top"): buscas de palavras presentes e ausentes,
+ * autocompletar, prefixos e estatísticas.
+ *
+ * Informa a vazão em consultas por segundo, as respostas de erro e os
+ * percentis 50, 99 e 99,9 e o máximo da latência de cada consulta, do
+ * envio da janela até a chegada da sua resposta.
+ *
+ * Uso: bench_server [-c conexões] [-p consultas por janela] [-d segundos]
+ *      [-q arquivo de consultas] endereço
+ */
+
+#include "../include/server.h"
+#include "bench.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @struct LineReader
+ * @brief Leitura de uma conexão, linha a linha.
+ */
+typedef struct {
+  int fd;             /**< O socket. */
+  char buffer[65536]; /**< Bytes recebidos. */
+  size_t used;        /**< Bytes em buffer. */
+  size_t start;       /**< Início da próxima linha. */
+} LineReader;
+
+/**
+ * @struct Client
+ * @brief Estado e resultados de uma conexão do gerador.
+ */
+typedef struct {
+  pthread_t thread;     /**< Identificador da thread. */
+  const char *address;  /**< Endereço do servidor. */
+  char **queries;       /**< As consultas. */
+  size_t num_queries;   /**< Número de consultas. */
+  int depth;            /**< Consultas por janela. */
+  double deadline;      /**< Fim da medição (bench_now). */
+  uint64_t seed;        /**< Semente do gerador. */
+  double *latencies;    /**< Latência de cada consulta, em segundos. */
+  size_t num_latencies; /**< Consultas respondidas. */
+  size_t capacity;      /**< Capacidade de latencies. */
+  size_t errors;        /**< Respostas "error". */
+  bool failed;          /**< Se a conexão falhou. */
+} Client;
+
+/**
+ * @brief Lê a próxima linha, sem o '\n'.
+ * @return A linha (válida até a próxima leitura), ou NULL no fim.
+ */
+static char *read_line(LineReader *reader) {
+  for (;;) {
+    char *start = reader->buffer + reader->start;
+    char *newline = memchr(start, '\n', reader->used - reader->start);
+    if (newline != NULL) {
+      *newline = '\0';
+      reader->start = (size_t)(newline + 1 - reader->buffer);
+      return start;
+    }
+    // Move a linha incompleta para o início e lê mais.
+    reader->used -= reader->start;
+    memmove(reader->buffer, start, reader->used);
+    reader->start = 0;
+    if (reader->used == sizeof(reader->buffer))
+      return NULL;
+    ssize_t received = recv(reader->fd, reader->buffer + reader->used,
+                            sizeof(reader->buffer) - reader->used, 0);
+    if (received <= 0)
+      return NULL;
+    reader->used += (size_t)received;
+  }
+}
+
+static bool send_all(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent <= 0)
+      return false;
+    data += sent;
+    size -= (size_t)sent;
+  }
+  return true;
+}
+
+/**
+ * @brief Lê uma resposta inteira (até a linha vazia).
+ * @return 1 se a resposta é um erro, 0 se não, -1 se a conexão terminou.
+ */
+static int read_response(LineReader *reader) {
+  int status = 0;
+  bool first = true;
+  char *line;
+  while ((line = read_line(reader)) != NULL) {
+    if (line[0] == '\0')
+      return status;
+    if (first && strncmp(line, "error", 5) == 0)
+      status = 1;
+    first = false;
+  }
+  return -1;
+}
+
+static char *copy_query(const char *format, const char *word, int length) {
+  char *query = malloc(strlen(format) + strlen(word) + 16);
+  sprintf(query, format, length, word);
+  return query;
+}
+
+/**
+ * @brief Sorteia as consultas a partir das palavras mais frequentes do
+ * servidor.
+ */
+static char **generate_queries(const char *address, size_t count,
+                               size_t *num_queries) {
+  int fd = server_connect(address);
+  if (fd < 0)
+    exit(EXIT_FAILURE);
+  LineReader *reader = calloc(1, sizeof(LineReader));
+  reader->fd = fd;
+  const char request[] = "top 1000\n";
+  size_t num_words = 0;
+  char **words = malloc(1000 * sizeof(char *));
+  // A resposta é o cabeçalho e uma linha "<palavra> <total>" por palavra.
+  if (send_all(fd, request, strlen(request)) && read_line(reader) != NULL) {
+    char *line;
+    while ((line = read_line(reader)) != NULL && line[0] != '\0' &&
+           num_words < 1000) {
+      char *tab = strchr(line, '\t');
+      if (tab != NULL)
+        *tab = '\0';
+      words[num_words++] = strdup(line);
+    }
+  }
+  close(fd);
+  free(reader);
+
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  char **queries = malloc(count * sizeof(char *));
+  for (size_t i = 0; i < count; i++) {
+    unsigned int kind = (unsigned int)(bench_random(&state) % 100);
+    const char *word =
+        num_words > 0 ? words[bench_random(&state) % num_words] : "";
+    if (num_words == 0 || kind >= 95)
+      queries[i] = strdup("stats");
+    else if (kind < 60)
+      queries[i] = copy_query("lookup %.*s", word, (int)strlen(word));
+    else if (kind < 75)
+      queries[i] = copy_query("lookup zzq%.*s", word, (int)strlen(word));
+    else if (kind < 90)
+      queries[i] = copy_query("complete %.*s 10", word, 3);
+    else
+      queries[i] = copy_query("prefix %.*s 10", word, 2);
+  }
+  for (size_t i = 0; i < num_words; i++)
+    free(words[i]);
+  free(words);
+  *num_queries = count;
+  return queries;
+}
+
+static char **read_queries(const char *path, size_t *num_queries) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  size_t count = 0, capacity = 1024;
+  char **queries = malloc(capacity * sizeof(char *));
+  char *line = NULL;
+  size_t line_capacity = 0;
+  ssize_t length;
+  while ((length = getline(&line, &line_capacity, file)) > 0) {
+    if (line[length - 1] == '\n')
+      line[--length] = '\0';
+    if (length == 0 || line[0] == '#')
+      continue;
+    if (count == capacity) {
+      capacity *= 2;
+      queries = realloc(queries, capacity * sizeof(char *));
+    }
+    queries[count++] = strdup(line);
+  }
+  free(line);
+  fclose(file);
+  if (count == 0) {
+    fprintf(stderr, "Nenhuma consulta em %s.\n", path);
+    exit(EXIT_FAILURE);
+  }
+  *num_queries = count;
+  return queries;
+}
+
+static void *client_run(void *argument) {
+  Client *client = (Client *)argument;
+  int fd = server_connect(client->address);
+  if (fd < 0) {
+    client->failed = true;
+    return NULL;
+  }
+  LineReader *reader = calloc(1, sizeof(LineReader));
+  reader->fd = fd;
+  size_t window_capacity = 4096;
+  char *window = malloc(window_capacity);
+
+  while (bench_now() < client->deadline) {
+    size_t size = 0;
+    for (int q = 0; q < client->depth; q++) {
+      const char *query =
+          client->queries[bench_random(&client->seed) % client->num_queries];
+      size_t length = strlen(query);
+      if (size + length + 1 > window_capacity) {
+        window_capacity = 2 * (size + length + 1);
+        window = realloc(window, window_capacity);
+      }
+      memcpy(window + size, query, length);
+      window[size + length] = '\n';
+      size += length + 1;
+    }
+    if (client->num_latencies + client->depth > client->capacity) {
+      client->capacity = 2 * (client->num_latencies + client->depth);
+      client->latencies =
+          realloc(client->latencies, client->capacity * sizeof(double));
+    }
+
+    double start = bench_now();
+    if (!send_all(fd, window, size)) {
+      client->failed = true;
+      break;
+    }
+    for (int q = 0; q < client->depth; q++) {
+      int status = read_response(reader);
+      if (status < 0) {
+        client->failed = true;
+        break;
+      }
+      client->errors += (size_t)status;
+      client->latencies[client->num_latencies++] = bench_now() - start;
+    }
+    if (client->failed)
+      break;
+  }
+  free(window);
+  free(reader);
+  close(fd);
+  return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+  int num_clients = 4, depth = 16;
+  double duration = 5;
+  const char *queries_path = NULL;
+  const char *address = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      num_clients = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      depth = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      duration = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+      queries_path = argv[++i];
+    } else {
+      address = argv[i];
+    }
+  }
+  if (address == NULL) {
+    fprintf(stderr, "Uso: %s [-c conexões] [-p consultas por janela] "
+                    "[-d segundos] [-q arquivo de consultas] endereço\n",
+            argv[0]);
+    return 1;
+  }
+  if (num_clients < 1)
+    num_clients = 1;
+  if (depth < 1)
+    depth = 1;
+
+  size_t num_queries;
+  char **queries = queries_path != NULL
+                       ? read_queries(queries_path, &num_queries)
+                       : generate_queries(address, 10000, &num_queries);
+
+  Client *clients = calloc(num_clients, sizeof(Client));
+  double start = bench_now();
+  for (int c = 0; c < num_clients; c++) {
+    clients[c].address = address;
+    clients[c].queries = queries;
+    clients[c].num_queries = num_queries;
+    clients[c].depth = depth;
+    clients[c].deadline = start + duration;
+    clients[c].seed = 0x9E3779B97F4A7C15ULL * (c + 1);
+    pthread_create(&clients[c].thread, NULL, client_run, &clients[c]);
+  }
+  size_t total = 0, errors = 0;
+  int failed = 0;
+  for (int c = 0; c < num_clients; c++) {
+    pthread_join(clients[c].thread, NULL);
+    total += clients[c].num_latencies;
+    errors += clients[c].errors;
+    failed += clients[c].failed;
+  }
+  double elapsed = bench_now() - start;
+
+  double *latencies = malloc((total > 0 ? total : 1) * sizeof(double));
+  size_t n = 0;
+  for (int c = 0; c < num_clients; c++) {
+    memcpy(latencies + n, clients[c].latencies,
+           clients[c].num_latencies * sizeof(double));
+    n += clients[c].num_latencies;
+    free(clients[c].latencies);
+  }
+  qsort(latencies, total, sizeof(double), compare_double);
+
+  printf("%d conexão(ões), %d consulta(s) por janela, %zu consultas "
+         "distintas\n",
+         num_clients, depth, num_queries);
+  if (total > 0) {
+    printf("%zu consultas em %.2f s: %.0f consultas/s | p50 %.1f us | p99 "
+           "%.1f us | p99,9 %.1f us | máximo %.1f us\n",
+           total, elapsed, total / elapsed, latencies[total / 2] * 1e6,
+           latencies[total * 99 / 100] * 1e6,
+           latencies[total * 999 / 1000] * 1e6, latencies[total - 1] * 1e6);
+  }
+  printf("%zu resposta(s) de erro, %d conexão(ões) com falha\n", errors,
+         failed);
+
+  free(latencies);
+  free(clients);
+  for (size_t i = 0; i < num_queries; i++)
+    free(queries[i]);
+  free(queries);
+  return failed > 0 ? 1 : 0;
+}
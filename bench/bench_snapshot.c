@@ -0,0 +1,159 @@
+/**
+ * @file bench_snapshot.c
+ * @brief Benchmark do índice salvo em arquivo.
+ *
+ * Indexa vocabulários sintéticos de tamanhos crescentes, salva o índice e
+ * mede o tempo de montagem das estruturas em memória, de gravação e de
+ * carga do arquivo (só com a conferência do cabeçalho e com a soma de
+ * verificação completa). Confere que toda palavra do dicionário é
+ * encontrada no índice carregado com a mesma contagem e a mesma melhor
+ * ocorrência, e que a ordem de frequência coincide com a da árvore;
+ * termina com status 1 se houver divergências.
+ *
+ * Uso: bench_snapshot [tamanho do vocabulário...]
+ */
+
+#include "../include/repository.h"
+#include "../include/snapshot.h"
+#include "../include/structures.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_SONGS 64
+
+/**
+ * @brief Confere o índice carregado contra o dicionário e a árvore de
+ * frequência em memória.
+ * @return O número de divergências.
+ */
+static size_t check_snapshot(const Snapshot *snapshot) {
+  size_t mismatches = 0;
+  const Dictionary *dictionary = &song_repository->dictionary;
+  for (size_t i = 0; i < dictionary->size; i++) {
+    const WordEntry *entry = dictionary->entries[i];
+    const SnapshotWord *word = snapshot_find_word(snapshot, entry->word);
+    if (word == NULL || word->total_word_count != entry->total_word_count ||
+        word->song_id != entry->best_song_occurrence.song_id ||
+        word->verse_line != entry->best_song_occurrence.verse_line ||
+        strcmp(snapshot_word_text(snapshot, word).word, entry->word) != 0) {
+      mismatches++;
+    }
+  }
+
+  WordArray *by_frequency = create_word_array();
+  populate_array_from_tree(avl_frequency_tree->root, by_frequency);
+  for (int i = 0; i < by_frequency->size; i++) {
+    const SnapshotWord *word = snapshot_frequency_word(snapshot, i);
+    if (word == NULL || strcmp(snapshot_word_text(snapshot, word).word,
+                               by_frequency->entries[i]->word) != 0) {
+      mismatches++;
+    }
+  }
+  free_word_array(by_frequency);
+  return mismatches;
+}
+
+/**
+ * @brief Mede e confere um vocabulário.
+ * @return O número de divergências.
+ */
+static size_t run_size(size_t vocabulary) {
+  uint64_t state = 0x2545F4914F6CDD1DULL ^ vocabulary;
+  char word[16];
+  char path[] = "/tmp/bench_snapshot_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+
+  // Músicas com um verso cada; as palavras recebem contagens de 1 a 64 em
+  // músicas sorteadas.
+  double start = bench_now();
+  song_repository = create_repository();
+  for (int s = 0; s < NUM_SONGS; s++) {
+    char text[64];
+    int length = snprintf(text, sizeof(text), "Canção Sintética %d", s);
+    char *title = arena_strndup(&song_repository->strings, text, length);
+    char *verse = arena_strndup(&song_repository->strings, text, length);
+    add_song(song_repository, title, title, &verse, 1, 1);
+  }
+  while (song_repository->dictionary.size < vocabulary) {
+    bench_random_word(&state, word);
+    SongOccurrence occurrence = {bench_random(&state) % NUM_SONGS, 0,
+                                 1 + bench_random(&state) % 64};
+    bool created;
+    WordEntry *entry = add_word_occurrence(
+        &song_repository->dictionary, word, occurrence.word_count_in_song,
+        &occurrence, &created);
+    if (created) {
+      insert_word(&song_repository->nodes, entry);
+      insert_word_avl(&song_repository->nodes, entry);
+    }
+  }
+  update_search_structures(song_repository);
+  double build_time = bench_now() - start;
+
+  start = bench_now();
+  bool saved = save_snapshot(path, song_repository, sorted_word_array,
+                             avl_frequency_tree->root);
+  double save_time = bench_now() - start;
+
+  start = bench_now();
+  Snapshot *snapshot = load_snapshot(path, false);
+  double load_time = bench_now() - start;
+  // A primeira busca é de uma palavra do vocabulário (a última sorteada).
+  start = bench_now();
+  const SnapshotWord *first =
+      snapshot != NULL ? snapshot_find_word(snapshot, word) : NULL;
+  double first_query = bench_now() - start;
+  free_snapshot(snapshot);
+
+  start = bench_now();
+  snapshot = load_snapshot(path, true);
+  double verified_load_time = bench_now() - start;
+
+  size_t mismatches =
+      saved && snapshot != NULL ? check_snapshot(snapshot) : vocabulary;
+  printf("vocabulário de %zu palavras, arquivo de %.1f MB%s\n", vocabulary,
+         snapshot != NULL ? snapshot->size / 1e6 : 0.0,
+         mismatches == 0 ? "" : " [ERRO]");
+  printf("  montagem em memória %10.3f ms\n", build_time * 1e3);
+  printf("  gravação            %10.3f ms\n", save_time * 1e3);
+  printf("  carga               %10.3f ms (primeira busca: %.3f ms%s)\n",
+         load_time * 1e3, first_query * 1e3,
+         first != NULL ? "" : ", ausente");
+  printf("  carga conferida     %10.3f ms\n", verified_load_time * 1e3);
+
+  free_snapshot(snapshot);
+  unlink(path);
+  free_word_array(sorted_word_array);
+  sorted_word_array = NULL;
+  bin_tree->root = NULL;
+  avl_tree->root = NULL;
+  avl_frequency_tree->root = NULL;
+  free_repository(song_repository);
+  song_repository = NULL;
+  return mismatches;
+}
+
+int main(int argc, char **argv) {
+  initialize_tree(bin_tree);
+  initialize_tree(avl_tree);
+
+  size_t mismatches = 0;
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      mismatches += run_size(strtoul(argv[i], NULL, 10));
+    }
+  } else {
+    mismatches += run_size(10000);
+    mismatches += run_size(100000);
+    mismatches += run_size(1000000);
+  }
+  return mismatches != 0 ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file bench_tokenize.c
+ * @brief Benchmark das implementações do tokenizador.
+ *
+ * Confere que cada implementação suportada (escalar, SSE2, AVX2) produz os
+ * mesmos tokens que strtok seguido de remove_punctuation e to_lowercase e
+ * mede a vazão de cada uma, em MB/s, sobre versos sintéticos (com
+ * maiúsculas, pontuação, acentos UTF-8 e algumas linhas longas) ou sobre as
+ * linhas dos arquivos informados. Termina com status 1 se alguma
+ * implementação divergir.
+ *
+ * Uso: bench_tokenize [arquivo...]
+ */
+
+#include "../include/repository.h"
+#include "../include/tokenize.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct LineSet
+ * @brief Linhas guardadas em sequência em um único buffer.
+ */
+typedef struct {
+  char *text;       /**< As linhas, sem o '\n'. */
+  size_t *starts;   /**< Início de cada linha (e o fim da última). */
+  size_t num_lines; /**< Número de linhas. */
+  size_t longest;   /**< Comprimento da maior linha. */
+} LineSet;
+
+static void add_line(LineSet *set, size_t *text_capacity,
+                     size_t *lines_capacity, const char *line,
+                     size_t length) {
+  size_t used = set->starts[set->num_lines];
+  while (used + length > *text_capacity) {
+    *text_capacity *= 2;
+    set->text = realloc(set->text, *text_capacity);
+  }
+  if (set->num_lines + 2 > *lines_capacity) {
+    *lines_capacity *= 2;
+    set->starts = realloc(set->starts, *lines_capacity * sizeof(size_t));
+  }
+  memcpy(set->text + used, line, length);
+  set->starts[++set->num_lines] = used + length;
+  if (length > set->longest) {
+    set->longest = length;
+  }
+}
+
+static LineSet read_lines(char **paths, int num_paths, size_t synthetic) {
+  size_t text_capacity = 1 << 20, lines_capacity = 1024;
+  LineSet set = {malloc(text_capacity), malloc(lines_capacity * sizeof(size_t)),
+                 0, 0};
+  set.starts[0] = 0;
+
+  for (int i = 0; i < num_paths; i++) {
+    FILE *file = fopen(paths[i], "r");
+    if (file == NULL) {
+      perror(paths[i]);
+      exit(EXIT_FAILURE);
+    }
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, file)) > 0) {
+      if (line[length - 1] == '\n') {
+        length--;
+      }
+      add_line(&set, &text_capacity, &lines_capacity, line, (size_t)length);
+    }
+    free(line);
+    fclose(file);
+  }
+
+  static const char *pieces[] = {"Amor",  "coração", "SAUDADE", "tchau!",
+                                 "é",     "(vem)",   "ça-va",   "Rio2024",
+                                 "...",   "x",       "MUNDO,",  "\"Luz\"",
+                                 "noite", "céu;",    "N'água", "sol"};
+  static const char *separators[] = {" ", " ", " ", "  ", "\t", " \r"};
+  uint64_t state = 0x5DEECE66DULL;
+  char line[4096];
+  for (size_t l = 0; l < synthetic; l++) {
+    size_t words = l % 64 == 0 ? 300 : 3 + bench_random(&state) % 10;
+    size_t length = 0;
+    for (size_t w = 0; w < words && length + 32 < sizeof(line); w++) {
+      const char *piece = pieces[bench_random(&state) % 16];
+      const char *separator = separators[bench_random(&state) % 6];
+      length += (size_t)sprintf(line + length, "%s%s", piece,
+                                w + 1 < words ? separator : "");
+    }
+    add_line(&set, &text_capacity, &lines_capacity, line, length);
+  }
+  return set;
+}
+
+/**
+ * @brief Tokeniza todas as linhas com strtok e os auxiliares originais e
+ * devolve os tokens normalizados separados por '\0'.
+ */
+static size_t legacy_tokenize(const LineSet *set, char *output) {
+  char *line = malloc(set->longest + 1);
+  size_t used = 0;
+  for (size_t l = 0; l < set->num_lines; l++) {
+    size_t length = set->starts[l + 1] - set->starts[l];
+    memcpy(line, set->text + set->starts[l], length);
+    line[length] = '\0';
+    char *save_ptr;
+    for (char *token = strtok_r(line, " \t\n\r", &save_ptr); token;
+         token = strtok_r(NULL, " \t\n\r", &save_ptr)) {
+      remove_punctuation(token);
+      to_lowercase(token);
+      size_t token_length = strlen(token) + 1;
+      memcpy(output + used, token, token_length);
+      used += token_length;
+    }
+  }
+  free(line);
+  return used;
+}
+
+/**
+ * @brief Tokeniza todas as linhas com uma implementação e, se output não for
+ * NULL, devolve os tokens no formato de legacy_tokenize.
+ * @return O número de bytes de output, ou o número de tokens.
+ */
+static size_t kernel_tokenize(const LineSet *set, TokenizeFunction tokenize,
+                              char *output) {
+  char *normalized = malloc(set->longest + TOKENIZE_PADDING);
+  TokenSpan *tokens = malloc((set->longest / 2 + 1) * sizeof(TokenSpan));
+  size_t used = 0;
+  for (size_t l = 0; l < set->num_lines; l++) {
+    size_t length = set->starts[l + 1] - set->starts[l];
+    size_t num_tokens =
+        tokenize(set->text + set->starts[l], length, normalized, tokens);
+    if (output == NULL) {
+      used += num_tokens;
+      continue;
+    }
+    for (size_t t = 0; t < num_tokens; t++) {
+      memcpy(output + used, normalized + tokens[t].offset, tokens[t].length);
+      used += tokens[t].length;
+      output[used++] = '\0';
+    }
+  }
+  free(normalized);
+  free(tokens);
+  return used;
+}
+
+int main(int argc, char **argv) {
+  LineSet set = read_lines(argv + 1, argc - 1, argc > 1 ? 0 : 200000);
+  size_t bytes = set.starts[set.num_lines];
+  int repetitions = (int)(200000000 / (bytes + 1)) + 1;
+  printf("%zu linhas, %zu bytes, %d repetições\n", set.num_lines, bytes,
+         repetitions);
+
+  // Cada token ocupa no máximo os próprios bytes mais o '\0', e há no
+  // máximo um token a cada dois bytes (mais um por linha).
+  size_t output_capacity = bytes + bytes / 2 + set.num_lines + 1;
+  char *expected = malloc(output_capacity);
+  char *actual = malloc(output_capacity);
+  size_t expected_size = legacy_tokenize(&set, expected);
+
+  double start = bench_now();
+  for (int r = 0; r < repetitions; r++) {
+    legacy_tokenize(&set, actual);
+  }
+  double elapsed = bench_now() - start;
+  printf("%-10s %9.1f MB/s\n", "strtok",
+         bytes * (double)repetitions / elapsed / 1e6);
+
+  int differences = 0;
+  for (size_t k = 0; k < num_tokenizer_kernels; k++) {
+    const TokenizerKernel *kernel = &tokenizer_kernels[k];
+    if (!kernel->supported()) {
+      printf("%-10s (não suportado)\n", kernel->name);
+      continue;
+    }
+
+    size_t actual_size = kernel_tokenize(&set, kernel->tokenize, actual);
+    bool identical = actual_size == expected_size &&
+                     memcmp(actual, expected, expected_size) == 0;
+    if (!identical)
+      differences++;
+
+    size_t tokens = 0;
+    start = bench_now();
+    for (int r = 0; r < repetitions; r++) {
+      tokens += kernel_tokenize(&set, kernel->tokenize, NULL);
+    }
+    elapsed = bench_now() - start;
+    printf("%-10s %9.1f MB/s | %zu tokens | %s\n", kernel->name,
+           bytes * (double)repetitions / elapsed / 1e6, tokens / repetitions,
+           identical ? "saída idêntica" : "SAÍDA DIFERENTE");
+  }
+
+  free(expected);
+  free(actual);
+  free(set.text);
+  free(set.starts);
+  return differences > 0 ? 1 : 0;
+}
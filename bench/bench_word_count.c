@@ -0,0 +1,201 @@
+/**
+ * @file bench_word_count.c
+ * @brief Benchmark da contagem de palavras por música.
+ *
+ * Compara a lista encadeada original (busca linear com strcmp) com o
+ * WordCounter (hash de endereçamento aberto) sobre os tokens já normalizados
+ * do acervo informado e de uma música sintética grande.
+ *
+ * Uso: bench_word_count [arquivo...]
+ */
+
+#include "../include/repository.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct LegacyWordCount
+ * @brief Nó da lista encadeada usada antes do WordCounter.
+ */
+typedef struct LegacyWordCount {
+  char *word;
+  unsigned int count;
+  struct LegacyWordCount *next;
+} LegacyWordCount;
+
+static LegacyWordCount *legacy_find_or_create(LegacyWordCount **head,
+                                              const char *word) {
+  for (LegacyWordCount *current = *head; current; current = current->next) {
+    if (strcmp(current->word, word) == 0) {
+      return current;
+    }
+  }
+  LegacyWordCount *new_count = malloc(sizeof(LegacyWordCount));
+  new_count->word = strdup(word);
+  new_count->count = 0;
+  new_count->next = *head;
+  *head = new_count;
+  return new_count;
+}
+
+static void legacy_free(LegacyWordCount *head) {
+  while (head != NULL) {
+    LegacyWordCount *next = head->next;
+    free(head->word);
+    free(head);
+    head = next;
+  }
+}
+
+/**
+ * @struct TokenList
+ * @brief Tokens normalizados de uma música.
+ */
+typedef struct {
+  char **tokens;
+  size_t size;
+  size_t capacity;
+} TokenList;
+
+static void add_token(TokenList *list, const char *token) {
+  if (list->size == list->capacity) {
+    list->capacity = list->capacity ? list->capacity * 2 : 256;
+    list->tokens = realloc(list->tokens, list->capacity * sizeof(char *));
+  }
+  list->tokens[list->size++] = strdup(token);
+}
+
+/**
+ * @brief Lê e normaliza os tokens de um arquivo como a carga faz.
+ */
+static void load_song_tokens(const char *path, TokenList *list) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  char line[256];
+  int line_number = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (line_number++ < 2) {
+      continue;
+    }
+    char *save_ptr;
+    for (char *token = strtok_r(line, " \t\n\r", &save_ptr); token;
+         token = strtok_r(NULL, " \t\n\r", &save_ptr)) {
+      remove_punctuation(token);
+      to_lowercase(token);
+      if (strlen(token) >= 3) {
+        add_token(list, token);
+      }
+    }
+  }
+  fclose(file);
+}
+
+/**
+ * @brief Gera uma música sintética com vocabulário uniforme.
+ */
+static void make_synthetic_song(TokenList *list, size_t vocabulary,
+                                size_t tokens) {
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  char **words = malloc(vocabulary * sizeof(char *));
+  for (size_t i = 0; i < vocabulary; i++) {
+    char word[16];
+    size_t length = 3 + bench_random(&state) % 8;
+    for (size_t j = 0; j < length; j++) {
+      word[j] = 'a' + bench_random(&state) % 26;
+    }
+    word[length] = '\0';
+    words[i] = strdup(word);
+  }
+  for (size_t i = 0; i < tokens; i++) {
+    add_token(list, words[bench_random(&state) % vocabulary]);
+  }
+  for (size_t i = 0; i < vocabulary; i++) {
+    free(words[i]);
+  }
+  free(words);
+}
+
+static size_t count_legacy(TokenList *songs, size_t num_songs) {
+  size_t distinct = 0;
+  for (size_t s = 0; s < num_songs; s++) {
+    LegacyWordCount *head = NULL;
+    for (size_t i = 0; i < songs[s].size; i++) {
+      legacy_find_or_create(&head, songs[s].tokens[i])->count++;
+    }
+    for (LegacyWordCount *c = head; c; c = c->next) {
+      distinct++;
+    }
+    legacy_free(head);
+  }
+  return distinct;
+}
+
+static size_t count_hashed(TokenList *songs, size_t num_songs) {
+  size_t distinct = 0;
+  for (size_t s = 0; s < num_songs; s++) {
+    WordCounter counter;
+    init_word_counter(&counter);
+    for (size_t i = 0; i < songs[s].size; i++) {
+      find_or_create_word_count(&counter, songs[s].tokens[i])->count++;
+    }
+    distinct += counter.size;
+    free_word_counter(&counter);
+  }
+  return distinct;
+}
+
+static void run_case(const char *name, TokenList *songs, size_t num_songs,
+                     int repetitions) {
+  size_t tokens = 0;
+  for (size_t s = 0; s < num_songs; s++) {
+    tokens += songs[s].size;
+  }
+
+  size_t legacy_distinct = 0, hashed_distinct = 0;
+  double start = bench_now();
+  for (int r = 0; r < repetitions; r++) {
+    legacy_distinct = count_legacy(songs, num_songs);
+  }
+  double legacy_time = (bench_now() - start) / repetitions;
+
+  start = bench_now();
+  for (int r = 0; r < repetitions; r++) {
+    hashed_distinct = count_hashed(songs, num_songs);
+  }
+  double hashed_time = (bench_now() - start) / repetitions;
+
+  if (legacy_distinct != hashed_distinct) {
+    fprintf(stderr, "%s: contagens divergentes (%zu vs %zu)\n", name,
+            legacy_distinct, hashed_distinct);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("%-22s %8zu tokens %7zu distintas | lista: %10.3f ms | hash: "
+         "%8.3f ms | %6.1fx\n",
+         name, tokens, hashed_distinct, legacy_time * 1e3, hashed_time * 1e3,
+         legacy_time / hashed_time);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    TokenList *songs = calloc(argc - 1, sizeof(TokenList));
+    for (int i = 1; i < argc; i++) {
+      load_song_tokens(argv[i], &songs[i - 1]);
+    }
+    run_case("acervo", songs, argc - 1, 200);
+  }
+
+  TokenList synthetic = {0};
+  make_synthetic_song(&synthetic, 2000, 100000);
+  run_case("sintética 2k/100k", &synthetic, 1, 3);
+
+  TokenList large = {0};
+  make_synthetic_song(&large, 5000, 500000);
+  run_case("sintética 5k/500k", &large, 1, 1);
+  return 0;
+}
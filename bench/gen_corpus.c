@@ -0,0 +1,282 @@
+/**
+ * @file gen_corpus.c
+ * @brief Gerador de corpus sintéticos de letras de músicas.
+ *
+ * Grava músicas no mesmo formato de LetrasMusicas/ (título, autor, linha em
+ * branco e versos) para testes de escala da carga e das buscas. O
+ * vocabulário tem palavras distintas de letras minúsculas, e as palavras de
+ * cada verso são sorteadas segundo uma distribuição de Zipf sobre o
+ * vocabulário (ou uniforme, com expoente 0). Palavras ainda não usadas são
+ * intercaladas a intervalos regulares, de modo que todo o vocabulário
+ * aparece no corpus sempre que o número total de palavras for ao menos o
+ * tamanho do vocabulário.
+ *
+ * A ordem em que as palavras aparecem pela primeira vez pode ser aleatória
+ * ou, para testar casos adversos, alfabética ou alfabética inversa (o que
+ * degenera a BST sem balanceamento).
+ *
+ * Uso: gen_corpus -o diretório [-s músicas] [-v vocabulário]
+ *      [-w palavras por música] [-z expoente de Zipf]
+ *      [-l mínimo-máximo de palavras por verso]
+ *      [--order random|sorted|reverse] [--seed semente]
+ */
+
+#include "bench.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define UNASSIGNED UINT32_MAX
+
+/**
+ * @struct Vocabulary
+ * @brief Palavras do vocabulário, guardadas em sequência.
+ */
+typedef struct {
+  char *text;     /**< As palavras, terminadas em '\0'. */
+  size_t *starts; /**< Início de cada palavra em text. */
+  uint32_t size;  /**< Número de palavras. */
+} Vocabulary;
+
+/**
+ * @brief Gera size palavras distintas.
+ *
+ * Cada palavra é um prefixo aleatório de 2 a 7 letras seguido do
+ * identificador em base 26 com um número fixo de letras, o que garante que
+ * palavras diferentes nunca coincidam.
+ */
+static Vocabulary make_vocabulary(uint32_t size, uint64_t *state) {
+  int suffix_length = 1;
+  for (uint64_t capacity = 26; capacity < size; capacity *= 26) {
+    suffix_length++;
+  }
+  Vocabulary vocabulary = {malloc((size_t)size * (8 + suffix_length)),
+                           malloc((size_t)size * sizeof(size_t)), size};
+  if (vocabulary.text == NULL || vocabulary.starts == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para o vocabulário.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t used = 0;
+  for (uint32_t id = 0; id < size; id++) {
+    vocabulary.starts[id] = used;
+    size_t prefix_length = 2 + bench_random(state) % 6;
+    for (size_t i = 0; i < prefix_length; i++) {
+      vocabulary.text[used++] = 'a' + bench_random(state) % 26;
+    }
+    uint32_t rest = id;
+    for (int i = 0; i < suffix_length; i++) {
+      vocabulary.text[used++] = 'a' + rest % 26;
+      rest /= 26;
+    }
+    vocabulary.text[used++] = '\0';
+  }
+  return vocabulary;
+}
+
+static const Vocabulary *sort_vocabulary;
+
+static int compare_word_ids(const void *a, const void *b) {
+  const Vocabulary *v = sort_vocabulary;
+  return strcmp(v->text + v->starts[*(const uint32_t *)a],
+                v->text + v->starts[*(const uint32_t *)b]);
+}
+
+/**
+ * @struct Generator
+ * @brief Estado da geração das palavras do corpus.
+ *
+ * Cada posição da distribuição de Zipf recebe uma palavra no primeiro
+ * sorteio, na ordem de order; next é a próxima palavra a ser atribuída.
+ */
+typedef struct {
+  const Vocabulary *vocabulary; /**< O vocabulário. */
+  const double *cumulative;     /**< Distribuição acumulada. */
+  uint32_t *assigned;           /**< Palavra de cada posição. */
+  const uint32_t *order;        /**< Ordem de primeira aparição. */
+  uint32_t next;                /**< Próximo índice em order. */
+  uint32_t next_unassigned;     /**< Menor posição possivelmente livre. */
+  uint64_t emitted;             /**< Palavras já geradas. */
+  uint64_t total;               /**< Palavras a gerar no corpus. */
+  uint64_t *state;              /**< Estado do gerador aleatório. */
+} Generator;
+
+static const char *next_word(Generator *generator) {
+  uint32_t size = generator->vocabulary->size;
+  uint64_t t = generator->emitted++;
+  uint32_t rank;
+  // Intercala uma palavra nova sempre que t * size / total passa de um
+  // inteiro, enquanto houver palavras sem posição.
+  bool inject = generator->next < size &&
+                (t + 1) * size / generator->total > t * size / generator->total;
+  if (inject) {
+    while (generator->assigned[generator->next_unassigned] != UNASSIGNED) {
+      generator->next_unassigned++;
+    }
+    rank = generator->next_unassigned;
+  } else {
+    rank = (uint32_t)bench_sample_zipf(generator->cumulative, size,
+                                       generator->state);
+  }
+  if (generator->assigned[rank] == UNASSIGNED) {
+    generator->assigned[rank] = generator->order[generator->next++];
+  }
+  const Vocabulary *vocabulary = generator->vocabulary;
+  return vocabulary->text + vocabulary->starts[generator->assigned[rank]];
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Uso: %s -o diretório [-s músicas] [-v vocabulário] "
+          "[-w palavras por música]\n"
+          "       [-z expoente de Zipf] [-l mínimo-máximo] "
+          "[--order random|sorted|reverse] [--seed semente]\n",
+          program);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  const char *directory = NULL;
+  const char *order_name = "random";
+  unsigned long songs = 1000, vocabulary_size = 10000, words_per_song = 200;
+  unsigned long min_line = 4, max_line = 10;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  double exponent = 1.0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *option = argv[i];
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+    }
+    const char *value = argv[++i];
+    if (strcmp(option, "-o") == 0) {
+      directory = value;
+    } else if (strcmp(option, "-s") == 0) {
+      songs = strtoul(value, NULL, 10);
+    } else if (strcmp(option, "-v") == 0) {
+      vocabulary_size = strtoul(value, NULL, 10);
+    } else if (strcmp(option, "-w") == 0) {
+      words_per_song = strtoul(value, NULL, 10);
+    } else if (strcmp(option, "-z") == 0) {
+      exponent = strtod(value, NULL);
+    } else if (strcmp(option, "-l") == 0) {
+      if (sscanf(value, "%lu-%lu", &min_line, &max_line) != 2) {
+        usage(argv[0]);
+      }
+    } else if (strcmp(option, "--order") == 0) {
+      order_name = value;
+    } else if (strcmp(option, "--seed") == 0) {
+      seed = strtoull(value, NULL, 0);
+    } else {
+      usage(argv[0]);
+    }
+  }
+  bool sorted = strcmp(order_name, "sorted") == 0;
+  bool reverse = strcmp(order_name, "reverse") == 0;
+  if (directory == NULL || songs == 0 || vocabulary_size == 0 ||
+      vocabulary_size >= UNASSIGNED || words_per_song == 0 ||
+      min_line == 0 || min_line > max_line || exponent < 0 ||
+      (!sorted && !reverse && strcmp(order_name, "random") != 0)) {
+    usage(argv[0]);
+  }
+  if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+    perror(directory);
+    return 1;
+  }
+
+  uint64_t state = seed != 0 ? seed : 1;
+  uint32_t size = (uint32_t)vocabulary_size;
+  Vocabulary vocabulary = make_vocabulary(size, &state);
+
+  uint32_t *order = malloc((size_t)size * sizeof(uint32_t));
+  uint32_t *assigned = malloc((size_t)size * sizeof(uint32_t));
+  if (order == NULL || assigned == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a ordem.\n");
+    return 1;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    order[i] = i;
+    assigned[i] = UNASSIGNED;
+  }
+  // Os prefixos aleatórios já tornam a ordem dos identificadores aleatória
+  // em relação à ordem alfabética.
+  if (sorted || reverse) {
+    sort_vocabulary = &vocabulary;
+    qsort(order, size, sizeof(uint32_t), compare_word_ids);
+    if (reverse) {
+      for (uint32_t i = 0, j = size - 1; i < j; i++, j--) {
+        uint32_t swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+      }
+    }
+  }
+
+  double *cumulative = bench_zipf_distribution(size, exponent);
+  Generator generator = {&vocabulary, cumulative, assigned, order, 0, 0, 0,
+                         (uint64_t)songs * words_per_song, &state};
+
+  size_t path_capacity = strlen(directory) + 32;
+  char *path = malloc(path_capacity);
+  uint64_t bytes = 0;
+  for (unsigned long s = 0; s < songs; s++) {
+    snprintf(path, path_capacity, "%s/%07lu.txt", directory, s);
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+      perror(path);
+      return 1;
+    }
+    int written = fprintf(file, "Canção Sintética %lu\nArtista %lu\n\n", s,
+                          s % (songs / 10 + 1));
+    bytes += written > 0 ? (uint64_t)written : 0;
+
+    // Versos com a primeira letra maiúscula e pontuação no final, em
+    // estrofes de quatro versos.
+    unsigned long remaining = words_per_song, line = 0;
+    while (remaining > 0) {
+      unsigned long length =
+          min_line + bench_random(&state) % (max_line - min_line + 1);
+      if (length > remaining) {
+        length = remaining;
+      }
+      for (unsigned long w = 0; w < length; w++) {
+        const char *word = next_word(&generator);
+        if (w == 0) {
+          putc(word[0] - 'a' + 'A', file);
+          fputs(word + 1, file);
+        } else {
+          putc(' ', file);
+          fputs(word, file);
+        }
+        bytes += strlen(word) + (w > 0);
+      }
+      fputs(line % 4 == 3 ? ".\n\n" : ",\n", file);
+      bytes += line % 4 == 3 ? 3 : 2;
+      remaining -= length;
+      line++;
+    }
+    if (fclose(file) != 0) {
+      perror(path);
+      return 1;
+    }
+  }
+
+  printf("%lu músicas, %llu palavras, %u palavras distintas, %.1f MB em %s\n",
+         songs, (unsigned long long)generator.total, generator.next,
+         bytes / 1e6, directory);
+  if (generator.next < size) {
+    printf("Aviso: o corpus tem menos palavras que o vocabulário; use mais "
+           "músicas ou palavras por música.\n");
+  }
+
+  free(path);
+  free(cumulative);
+  free(order);
+  free(assigned);
+  free(vocabulary.text);
+  free(vocabulary.starts);
+  return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file dictionary.c
+ * @brief Implementação do dicionário de palavras compartilhado.
+ */
+
+#include "include/dictionary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned int hash_word(const char *s, size_t length) {
+  unsigned int hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)s[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void init_dictionary(Dictionary *dictionary) {
+  dictionary->slot_capacity = 1024;
+  dictionary->slots = (DictionarySlot *)calloc(dictionary->slot_capacity,
+                                               sizeof(DictionarySlot));
+  dictionary->entry_capacity = 512;
+  dictionary->entries =
+      (WordEntry **)malloc(dictionary->entry_capacity * sizeof(WordEntry *));
+  dictionary->postings =
+      (PostingList *)malloc(dictionary->entry_capacity * sizeof(PostingList));
+  if (dictionary->slots == NULL || dictionary->entries == NULL ||
+      dictionary->postings == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para Dictionary.\n");
+    exit(EXIT_FAILURE);
+  }
+  dictionary->size = 0;
+  dictionary->changed = NULL;
+  dictionary->num_changed = 0;
+  dictionary->changed_capacity = 0;
+  arena_init(&dictionary->memory, 0);
+  arena_init(&dictionary->posting_blocks, 0);
+}
+
+void free_dictionary(Dictionary *dictionary) {
+  free(dictionary->slots);
+  free(dictionary->entries);
+  free(dictionary->changed);
+  arena_free(&dictionary->memory);
+  free(dictionary->postings);
+  arena_free(&dictionary->posting_blocks);
+  dictionary->slots = NULL;
+  dictionary->entries = NULL;
+  dictionary->postings = NULL;
+  dictionary->changed = NULL;
+  dictionary->size = 0;
+  dictionary->num_changed = 0;
+}
+
+/**
+ * @brief Acrescenta um registro à lista de alterados.
+ */
+static void record_change(Dictionary *dictionary, WordEntry *entry) {
+  if (dictionary->num_changed == dictionary->changed_capacity) {
+    dictionary->changed_capacity =
+        dictionary->changed_capacity ? dictionary->changed_capacity * 2 : 256;
+    dictionary->changed = (WordEntry **)realloc(
+        dictionary->changed,
+        dictionary->changed_capacity * sizeof(WordEntry *));
+    if (dictionary->changed == NULL) {
+      fprintf(stderr, "Falha no realloc de Dictionary.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  dictionary->changed[dictionary->num_changed++] = entry;
+}
+
+/**
+ * @brief Dobra a tabela hash e reinsere as posições ocupadas.
+ * @param dictionary O dicionário.
+ */
+static void grow_dictionary_slots(Dictionary *dictionary) {
+  size_t new_capacity = dictionary->slot_capacity * 2;
+  DictionarySlot *new_slots =
+      (DictionarySlot *)calloc(new_capacity, sizeof(DictionarySlot));
+  if (new_slots == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para Dictionary.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  size_t mask = new_capacity - 1;
+  for (size_t i = 0; i < dictionary->slot_capacity; i++) {
+    DictionarySlot slot = dictionary->slots[i];
+    if (slot.entry == 0) {
+      continue;
+    }
+    size_t position = slot.hash & mask;
+    while (new_slots[position].entry != 0) {
+      position = (position + 1) & mask;
+    }
+    new_slots[position] = slot;
+  }
+
+  free(dictionary->slots);
+  dictionary->slots = new_slots;
+  dictionary->slot_capacity = new_capacity;
+}
+
+/**
+ * @brief Encontra a posição da tabela que contém a palavra ou, se ela não
+ * estiver no dicionário, a posição vazia onde seria inserida.
+ */
+static size_t find_slot(const Dictionary *dictionary, const char *word,
+                        size_t length, unsigned int hash) {
+  size_t mask = dictionary->slot_capacity - 1;
+  size_t position = hash & mask;
+  while (dictionary->slots[position].entry != 0) {
+    DictionarySlot slot = dictionary->slots[position];
+    if (slot.hash == hash) {
+      const char *candidate = dictionary->entries[slot.entry - 1]->word;
+      if (memcmp(candidate, word, length) == 0 && candidate[length] == '\0') {
+        break;
+      }
+    }
+    position = (position + 1) & mask;
+  }
+  return position;
+}
+
+/**
+ * @brief Retorna o registro de uma posição da tabela, ou NULL se ela estiver
+ * vazia.
+ */
+static WordEntry *slot_entry(const Dictionary *dictionary, size_t position) {
+  unsigned int entry = dictionary->slots[position].entry;
+  return entry == 0 ? NULL : dictionary->entries[entry - 1];
+}
+
+WordEntry *find_word(const Dictionary *dictionary, const char *word) {
+  size_t length = strlen(word);
+  unsigned int hash = hash_word(word, length);
+  return slot_entry(dictionary, find_slot(dictionary, word, length, hash));
+}
+
+WordEntry *add_word_occurrence(Dictionary *dictionary, const char *word,
+                               unsigned int total_word_count,
+                               const SongOccurrence *occurrence,
+                               bool *created) {
+  size_t length = strlen(word);
+  unsigned int hash = hash_word(word, length);
+  size_t position = find_slot(dictionary, word, length, hash);
+  WordEntry *entry = slot_entry(dictionary, position);
+
+  if (created != NULL) {
+    *created = entry == NULL;
+  }
+  if (entry != NULL) {
+    // Um registro ainda igual ao indexado não está na lista de alterados.
+    if (entry->total_word_count == entry->indexed_count) {
+      record_change(dictionary, entry);
+    }
+    entry->total_word_count += total_word_count;
+    if (occurrence->word_count_in_song >
+        entry->best_song_occurrence.word_count_in_song) {
+      entry->best_song_occurrence = *occurrence;
+    }
+    return entry;
+  }
+
+  if (dictionary->size == dictionary->entry_capacity) {
+    dictionary->entry_capacity *= 2;
+    dictionary->entries = (WordEntry **)realloc(
+        dictionary->entries, dictionary->entry_capacity * sizeof(WordEntry *));
+    dictionary->postings = (PostingList *)realloc(
+        dictionary->postings, dictionary->entry_capacity * sizeof(PostingList));
+    if (dictionary->entries == NULL || dictionary->postings == NULL) {
+      fprintf(stderr, "Falha no realloc de Dictionary.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  entry = (WordEntry *)arena_alloc(&dictionary->memory, sizeof(WordEntry));
+  entry->word = arena_strndup(&dictionary->memory, word, length);
+  entry->total_word_count = total_word_count;
+  entry->best_song_occurrence = *occurrence;
+  entry->indexed_count = 0;
+  entry->id = (unsigned int)dictionary->size;
+  memset(&dictionary->postings[dictionary->size], 0, sizeof(PostingList));
+  dictionary->entries[dictionary->size++] = entry;
+  record_change(dictionary, entry);
+
+  dictionary->slots[position].hash = hash;
+  dictionary->slots[position].entry = (unsigned int)dictionary->size;
+
+  // Mantém o fator de carga abaixo de 3/4.
+  if (dictionary->size * 4 > dictionary->slot_capacity * 3) {
+    grow_dictionary_slots(dictionary);
+  }
+  return entry;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file arena.h
+ * @brief Alocador por arena (bump allocator).
+ *
+ * Uma arena entrega memória em sequência a partir de blocos grandes e libera
+ * todos os blocos de uma só vez. Não há liberação individual.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdalign.h>
+#include <stddef.h>
+
+/**
+ * @struct ArenaBlock
+ * @brief Bloco de memória de uma arena.
+ */
+typedef struct ArenaBlock {
+  struct ArenaBlock *next;          /**< Bloco alocado anteriormente. */
+  size_t used;                      /**< Bytes já entregues deste bloco. */
+  size_t capacity;                  /**< Capacidade do bloco em bytes. */
+  alignas(max_align_t) char data[]; /**< Memória do bloco. */
+} ArenaBlock;
+
+/**
+ * @struct Arena
+ * @brief Arena de memória.
+ */
+typedef struct {
+  ArenaBlock *head;  /**< Bloco atual (o mais recente). */
+  size_t block_size; /**< Tamanho padrão dos novos blocos. */
+} Arena;
+
+/**
+ * @brief Inicializa uma arena vazia.
+ * @param arena A arena.
+ * @param block_size Tamanho padrão dos blocos (0 usa o padrão de 64 KiB).
+ */
+void arena_init(Arena *arena, size_t block_size);
+
+/**
+ * @brief Aloca memória alinhada na arena.
+ *
+ * Encerra o programa se a memória não puder ser obtida.
+ *
+ * @param arena A arena.
+ * @param size Número de bytes.
+ * @return Ponteiro para a memória alocada.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Aloca memória na arena com o alinhamento pedido.
+ *
+ * Útil para objetos pequenos que não precisam do alinhamento máximo.
+ *
+ * @param arena A arena.
+ * @param size Número de bytes.
+ * @param alignment O alinhamento (potência de dois).
+ * @return Ponteiro para a memória alocada.
+ */
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t alignment);
+
+/**
+ * @brief Copia os primeiros length bytes de uma string para a arena.
+ * @param arena A arena.
+ * @param s A string de origem.
+ * @param length Número de bytes a copiar.
+ * @return A cópia, terminada em '\0'.
+ */
+char *arena_strndup(Arena *arena, const char *s, size_t length);
+
+/**
+ * @brief Transfere todos os blocos de uma arena para outra.
+ *
+ * Os ponteiros entregues por source continuam válidos e passam a pertencer a
+ * destination. source fica vazia.
+ *
+ * @param destination A arena que recebe os blocos.
+ * @param source A arena de origem.
+ */
+void arena_adopt(Arena *destination, Arena *source);
+
+/**
+ * @brief Libera todos os blocos da arena de uma só vez.
+ *
+ * A arena volta ao estado vazio e pode ser reutilizada.
+ *
+ * @param arena A arena.
+ */
+void arena_free(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,119 @@
+/**
+ * @file dictionary.h
+ * @brief Dicionário de palavras compartilhado pelas estruturas de busca.
+ *
+ * Cada palavra distinta do repositório tem um único registro (WordEntry) com
+ * a palavra, a contagem total e a melhor ocorrência. A BST, a AVL, o array
+ * ordenado e a árvore de frequência apenas apontam para esses registros.
+ */
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include "arena.h"
+#include "postings.h"
+#include "structures.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @struct DictionarySlot
+ * @brief Posição da tabela hash de um Dictionary.
+ */
+typedef struct {
+  unsigned int hash;  /**< Hash da palavra armazenada. */
+  unsigned int entry; /**< Índice do registro + 1 (0 indica posição vazia). */
+} DictionarySlot;
+
+/**
+ * @struct Dictionary
+ * @brief Registros das palavras distintas, com tabela hash de endereçamento
+ * aberto (sondagem linear).
+ *
+ * Os registros e as palavras são alocados em uma arena e nunca mudam de
+ * endereço, de modo que as árvores podem apontar para eles. O array entries
+ * guarda os registros na ordem em que as palavras foram criadas.
+ *
+ * O array changed lista os registros criados ou alterados desde a última
+ * atualização dos índices derivados (array ordenado e árvore de frequência),
+ * para que ela não precise percorrer o dicionário inteiro. Um registro entra
+ * na lista quando sua contagem deixa de ser igual a indexed_count.
+ *
+ * As listas de ocorrências ficam em um array paralelo a entries (a lista de
+ * um registro está na posição WordEntry::id), e os seus blocos em uma arena
+ * separada, para que a memória delas possa ser medida à parte.
+ */
+typedef struct {
+  DictionarySlot *slots;   /**< Tabela hash (capacidade potência de dois). */
+  size_t slot_capacity;    /**< Número de posições da tabela. */
+  WordEntry **entries;     /**< Registros na ordem de criação. */
+  PostingList *postings;   /**< Listas de ocorrências, na mesma ordem. */
+  size_t size;             /**< Número de palavras distintas. */
+  size_t entry_capacity;   /**< Capacidade do array de registros. */
+  WordEntry **changed;     /**< Registros alterados desde a atualização. */
+  size_t num_changed;      /**< Número de registros alterados. */
+  size_t changed_capacity; /**< Capacidade do array de alterados. */
+  Arena memory;            /**< Registros e palavras. */
+  Arena posting_blocks;    /**< Blocos das listas de ocorrências. */
+} Dictionary;
+
+/**
+ * @brief Retorna a lista de ocorrências de um registro do dicionário.
+ */
+static inline PostingList *word_postings(const Dictionary *dictionary,
+                                         const WordEntry *entry) {
+  return &dictionary->postings[entry->id];
+}
+
+/**
+ * @brief Calcula o hash FNV-1a de 32 bits de uma sequência de bytes.
+ * @param s Os bytes.
+ * @param length O número de bytes.
+ * @return O hash.
+ */
+unsigned int hash_word(const char *s, size_t length);
+
+/**
+ * @brief Inicializa um dicionário vazio.
+ * @param dictionary O dicionário.
+ */
+void init_dictionary(Dictionary *dictionary);
+
+/**
+ * @brief Libera a tabela, os registros e as palavras de um dicionário.
+ * @param dictionary O dicionário.
+ */
+void free_dictionary(Dictionary *dictionary);
+
+/**
+ * @brief Busca o registro de uma palavra.
+ * @param dictionary O dicionário.
+ * @param word A palavra.
+ * @return O registro, ou NULL se a palavra não estiver no dicionário.
+ */
+WordEntry *find_word(const Dictionary *dictionary, const char *word);
+
+/**
+ * @brief Soma ocorrências de uma palavra ao seu registro, criando-o se
+ * necessário.
+ *
+ * A contagem total é acumulada e a melhor ocorrência só é substituída se a
+ * nova tiver mais aparições na música (em caso de empate, a mais antiga
+ * prevalece). O registro é acrescentado a changed se ainda não estiver lá.
+ * A lista de ocorrências não é alterada: quem carrega uma música acrescenta
+ * a ocorrência com add_posting.
+ *
+ * @param dictionary O dicionário.
+ * @param word A palavra.
+ * @param total_word_count O número de ocorrências a somar.
+ * @param occurrence A ocorrência da palavra em uma música.
+ * @param created Recebe true se o registro foi criado nesta chamada (pode
+ * ser NULL).
+ * @return O registro da palavra.
+ */
+WordEntry *add_word_occurrence(Dictionary *dictionary, const char *word,
+                               unsigned int total_word_count,
+                               const SongOccurrence *occurrence,
+                               bool *created);
+
+#endif // DICTIONARY_H
@@ -0,0 +1,44 @@
+/**
+ * @file ingest.h
+ * @brief Carga em lote de diretórios de letras de músicas.
+ *
+ * Distribui os arquivos de um diretório entre um conjunto de threads. Cada
+ * thread constrói uma tabela de palavras privada (uma árvore AVL) e, ao final,
+ * as tabelas são mescladas nas árvores globais.
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Carrega todos os arquivos regulares de um diretório em paralelo.
+ *
+ * Os arquivos são ordenados por nome e divididos em faixas contíguas de
+ * tamanho (em bytes) aproximadamente igual, uma por thread. As tabelas
+ * privadas são mescladas na ordem das faixas, de modo que as contagens
+ * totais e as melhores músicas são idênticas às da carga serial dos mesmos
+ * arquivos, um a um, em ordem alfabética.
+ *
+ * O array ordenado e a árvore de frequência não são reconstruídos aqui.
+ *
+ * @param dirpath O caminho para o diretório.
+ * @param num_threads Número de threads (0 usa o número de núcleos).
+ * @return O número de arquivos carregados, ou -1 em caso de erro.
+ */
+int process_music_directory(const char *dirpath, int num_threads);
+
+/**
+ * @brief Carrega um arquivo de música ou, se o caminho for um diretório,
+ * todos os arquivos dele (em paralelo).
+ *
+ * Como em process_music_directory, o array ordenado e a árvore de
+ * frequência não são reconstruídos aqui.
+ *
+ * @param path O caminho.
+ * @return true se o caminho foi carregado.
+ */
+bool load_music_path(const char *path);
+
+#endif // INGEST_H
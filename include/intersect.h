@@ -0,0 +1,153 @@
+/**
+ * @file intersect.h
+ * @brief Consultas com várias palavras: interseção das listas de
+ * ocorrências e conferência de frases pelas posições.
+ *
+ * Uma consulta começa pela palavra com menos músicas, cujas ocorrências
+ * formam a lista de candidatas, e a reduz com as demais palavras em ordem
+ * crescente de tamanho. Uma lista muito maior que as candidatas é percorrida
+ * com posting_cursor_seek, que usa os pontos de salto e não decodifica as
+ * ocorrências entre duas candidatas; as demais são decodificadas e
+ * intersectadas com intersect_sorted.
+ *
+ * intersect_sorted usa busca exponencial quando um array é muito maior que
+ * o outro e, nos demais casos, uma interseção vetorial que compara um bloco
+ * de 4 (SSE2) ou 8 (AVX2) identificadores com todas as rotações de um bloco
+ * do outro array de uma vez. Como no tokenizador, a implementação é
+ * escolhida em tempo de execução.
+ *
+ * Em uma frase, cada candidata é conferida pelas posições: as posições de
+ * cada palavra, menos a sua distância ao início da frase, precisam ter um
+ * valor em comum. As palavras curtas demais para serem indexadas não são
+ * conferidas, mas contam nas distâncias; os tokens só de pontuação não.
+ */
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+#include "dictionary.h"
+#include "postings.h"
+#include "snapshot.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Razão de tamanhos a partir da qual a lista maior é percorrida por saltos
+ * (busca exponencial) em vez de decodificada e intersectada por inteiro.
+ */
+#define INTERSECT_GALLOP_RATIO 32
+
+/**
+ * @brief Função que intersecta dois arrays em ordem estritamente
+ * crescente.
+ *
+ * @param a O primeiro array.
+ * @param a_size O tamanho de a.
+ * @param b O segundo array.
+ * @param b_size O tamanho de b.
+ * @param out Recebe os valores comuns, em ordem crescente (pelo menos o
+ * menor dos dois tamanhos; não pode coincidir com a nem com b).
+ * @return O número de valores comuns.
+ */
+typedef size_t (*IntersectFunction)(const uint32_t *a, size_t a_size,
+                                    const uint32_t *b, size_t b_size,
+                                    uint32_t *out);
+
+/**
+ * @struct IntersectKernel
+ * @brief Uma implementação da interseção por comparação de blocos.
+ */
+typedef struct {
+  const char *name;            /**< Nome da implementação. */
+  IntersectFunction intersect; /**< A função. */
+  bool (*supported)(void);     /**< Indica se o processador a suporta. */
+} IntersectKernel;
+
+/** Implementações disponíveis, da mais simples para a mais rápida. */
+extern const IntersectKernel intersect_kernels[];
+
+/** Número de elementos de intersect_kernels. */
+extern const size_t num_intersect_kernels;
+
+/**
+ * @brief Interseção por busca exponencial: cada valor de a é procurado em
+ * b a partir da posição do anterior. Os parâmetros são os de
+ * IntersectFunction; a deve ser o array menor.
+ */
+size_t intersect_galloping(const uint32_t *a, size_t a_size,
+                           const uint32_t *b, size_t b_size, uint32_t *out);
+
+/**
+ * @brief Intersecta dois arrays com busca exponencial, se um deles for
+ * INTERSECT_GALLOP_RATIO vezes maior que o outro, ou com a implementação
+ * vetorial mais rápida suportada pelo processador.
+ *
+ * Os parâmetros são os de IntersectFunction.
+ */
+size_t intersect_sorted(const uint32_t *a, size_t a_size, const uint32_t *b,
+                        size_t b_size, uint32_t *out);
+
+/**
+ * @struct QueryTerm
+ * @brief Uma palavra de uma consulta.
+ */
+typedef struct {
+  PostingCursor cursor; /**< Cursor no início da lista da palavra. */
+  unsigned int offset;  /**< Posição da palavra na frase. */
+} QueryTerm;
+
+/**
+ * @brief Músicas que contêm todas as palavras (e, se phrase, as contêm na
+ * sequência dada pelos offsets).
+ *
+ * @param terms As palavras (os cursores são consumidos).
+ * @param num_terms O número de palavras (pelo menos 1).
+ * @param phrase Se verdadeiro, confere as posições.
+ * @param songs Recebe um array alocado com os identificadores, em ordem
+ * crescente, que o chamador libera com free.
+ * @return O número de músicas.
+ */
+size_t match_terms(QueryTerm *terms, size_t num_terms, bool phrase,
+                   uint32_t **songs);
+
+/**
+ * @brief Função que abre o cursor da lista de uma palavra.
+ * @return false se a palavra não estiver no índice.
+ */
+typedef bool (*TermLookup)(const void *index, const char *word,
+                           PostingCursor *cursor);
+
+/**
+ * @brief TermLookup para um dicionário em memória (index é Dictionary *).
+ */
+bool lookup_dictionary_term(const void *index, const char *word,
+                            PostingCursor *cursor);
+
+/**
+ * @brief TermLookup para um índice salvo (index é Snapshot *).
+ */
+bool lookup_snapshot_term(const void *index, const char *word,
+                          PostingCursor *cursor);
+
+/**
+ * @brief Busca as músicas que contêm todas as palavras de um texto ou, se
+ * phrase, a frase formada por elas.
+ *
+ * O texto é separado e normalizado como as letras das músicas; as palavras
+ * com menos de 3 letras são ignoradas (mas contam nas posições da frase).
+ *
+ * @param text O texto da consulta.
+ * @param phrase Se verdadeiro, as palavras devem aparecer em sequência.
+ * @param lookup Função que abre as listas das palavras.
+ * @param index O índice repassado a lookup.
+ * @param songs Recebe um array alocado com os identificadores, em ordem
+ * crescente, que o chamador libera com free.
+ * @param num_terms Recebe o número de palavras indexáveis do texto (0 se
+ * não houver nenhuma).
+ * @return O número de músicas.
+ */
+size_t search_text(const char *text, bool phrase, TermLookup lookup,
+                   const void *index, uint32_t **songs, size_t *num_terms);
+
+#endif // INTERSECT_H
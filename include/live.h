@@ -0,0 +1,172 @@
+/**
+ * @file live.h
+ * @brief Versões imutáveis do índice para consultas concorrentes à carga.
+ *
+ * As árvores globais, o array ordenado e a árvore de frequência são
+ * alterados no lugar durante a carga, de modo que nenhuma consulta pode
+ * usá-los enquanto um arquivo é lido. Um LiveIndex separa as duas coisas:
+ * uma única thread escritora carrega os arquivos nas estruturas globais e,
+ * quando quer tornar a carga visível, monta com build_snapshot uma cópia
+ * imutável do índice (uma versão) e a publica trocando um ponteiro
+ * atômico. As threads leitoras só consultam versões publicadas, que não
+ * mudam: cada consulta vê o índice inteiro de um mesmo momento, sem
+ * travas.
+ *
+ * As versões substituídas são liberadas por épocas (como no RCU): cada
+ * leitora anota, na sua posição de LiveReader, a época global ao começar
+ * uma consulta e a apaga ao terminar. Uma versão substituída na época e só
+ * pode ser lida por consultas que começaram na época e ou antes, pois a
+ * época é incrementada depois da troca do ponteiro; ela é liberada quando
+ * nenhuma leitora está em uma época até e. Cada posição ocupa uma linha de
+ * cache, de modo que as leitoras não escrevem em memória compartilhada
+ * entre si, e a escritora nunca espera uma leitora que não esteja no meio
+ * de uma consulta.
+ */
+
+#ifndef LIVE_H
+#define LIVE_H
+
+#include "prefix.h"
+#include "snapshot.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Número máximo de threads leitoras registradas ao mesmo tempo. */
+#define LIVE_MAX_READERS 128
+
+/** Versões substituídas que a escritora acumula antes de esperar. */
+#define LIVE_MAX_RETIRED 4
+
+/** Tamanho da linha de cache das posições das leitoras. */
+#define LIVE_CACHE_LINE 64
+
+/**
+ * @struct LiveVersion
+ * @brief Uma versão publicada do índice.
+ *
+ * snapshot e counts não mudam depois da publicação e valem enquanto a
+ * leitora estiver na consulta em que obteve a versão.
+ */
+typedef struct LiveVersion {
+  Snapshot *snapshot;        /**< O índice. */
+  CountIndex *counts;        /**< Contagens de snapshot (autocompletar). */
+  uint64_t number;           /**< Número da versão (1 para a primeira). */
+  uint64_t retired_at;       /**< Época em que foi substituída. */
+  struct LiveVersion *older; /**< Próxima versão substituída. */
+} LiveVersion;
+
+/**
+ * @struct LiveReader
+ * @brief Posição de uma thread leitora, em uma linha de cache própria.
+ */
+typedef struct {
+  /** Época da consulta em curso, ou 0 (acesso atômico). */
+  alignas(LIVE_CACHE_LINE) uint64_t epoch;
+  int in_use; /**< Se a posição está registrada (acesso atômico). */
+} LiveReader;
+
+/**
+ * @struct LiveIndex
+ * @brief A versão publicada e o estado da liberação por épocas.
+ */
+typedef struct {
+  LiveVersion *current;   /**< Versão publicada (acesso atômico). */
+  uint64_t epoch;         /**< Época global, a partir de 1 (idem). */
+  LiveVersion *retired;   /**< Versões substituídas ainda não liberadas. */
+  size_t num_retired;     /**< Tamanho da lista retired. */
+  uint64_t num_published; /**< Versões publicadas. */
+  uint64_t num_reclaimed; /**< Versões liberadas. */
+  LiveReader readers[LIVE_MAX_READERS]; /**< Posições das leitoras. */
+} LiveIndex;
+
+/**
+ * @brief Cria o índice e publica como primeira versão o conteúdo atual das
+ * estruturas globais (vazio se nada foi carregado).
+ *
+ * Deve ser chamada pela thread escritora, que passa a ser a única a
+ * alterar as estruturas globais.
+ *
+ * @return O índice.
+ */
+LiveIndex *create_live_index(void);
+
+/**
+ * @brief Libera o índice, a versão publicada e as substituídas. Nenhuma
+ * leitora pode estar em uma consulta.
+ * @param index O índice (pode ser NULL).
+ */
+void free_live_index(LiveIndex *index);
+
+/**
+ * @brief Registra a thread chamadora como leitora.
+ * @param index O índice.
+ * @return A posição da leitora, ou NULL se as LIVE_MAX_READERS posições
+ * estiverem ocupadas.
+ */
+LiveReader *live_index_register(LiveIndex *index);
+
+/**
+ * @brief Devolve a posição de uma leitora, fora de uma consulta.
+ * @param reader A posição (pode ser NULL).
+ */
+void live_index_unregister(LiveReader *reader);
+
+/**
+ * @brief Começa uma consulta: obtém a versão publicada, que não é liberada
+ * até live_index_end. Não usa travas; as consultas não podem ser
+ * aninhadas.
+ *
+ * @param index O índice.
+ * @param reader A posição da leitora.
+ * @return A versão.
+ */
+const LiveVersion *live_index_begin(LiveIndex *index, LiveReader *reader);
+
+/**
+ * @brief Termina a consulta; a versão obtida não pode mais ser usada.
+ * @param reader A posição da leitora.
+ */
+void live_index_end(LiveReader *reader);
+
+/**
+ * @brief Publica um índice como nova versão (só pela thread escritora).
+ *
+ * A versão anterior é substituída e liberada assim que nenhuma leitora
+ * puder estar usando-a. Se houver mais de LIVE_MAX_RETIRED versões à
+ * espera, a escritora espera as leitoras, o que limita a memória.
+ *
+ * @param index O índice.
+ * @param snapshot O índice da nova versão, que passa a pertencer a index.
+ */
+void live_index_publish(LiveIndex *index, Snapshot *snapshot);
+
+/**
+ * @brief Atualiza as estruturas globais com update_search_structures e
+ * publica uma cópia delas como nova versão (só pela thread escritora).
+ *
+ * O custo é proporcional ao tamanho do índice: a escritora deve publicar
+ * depois de um lote de arquivos, não a cada palavra.
+ *
+ * @param index O índice.
+ * @return true se a versão foi publicada.
+ */
+bool live_index_refresh(LiveIndex *index);
+
+/**
+ * @brief Libera as versões substituídas que nenhuma leitora pode estar
+ * usando (só pela thread escritora).
+ * @param index O índice.
+ * @return O número de versões liberadas.
+ */
+size_t live_index_reclaim(LiveIndex *index);
+
+/**
+ * @brief Espera até que todas as versões substituídas sejam liberadas (só
+ * pela thread escritora).
+ * @param index O índice.
+ */
+void live_index_synchronize(LiveIndex *index);
+
+#endif // LIVE_H
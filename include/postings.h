@@ -0,0 +1,278 @@
+/**
+ * @file postings.h
+ * @brief Listas de ocorrências (postings) das palavras, comprimidas.
+ *
+ * Cada palavra guarda as músicas em que aparece, em ordem crescente de
+ * identificador, com a sua contagem e as suas posições em cada uma. Cada
+ * ocorrência é gravada como inteiros de tamanho variável (varint, 7 bits por
+ * byte): a diferença para o identificador anterior (o primeiro é gravado
+ * inteiro), a contagem, o tamanho em bytes das posições e as posições, como
+ * diferenças para a anterior. A posição de uma palavra é o seu índice entre
+ * todas as palavras da música, inclusive as curtas demais para serem
+ * indexadas, de modo que as distâncias de uma frase são preservadas. O
+ * tamanho das posições permite pulá-las sem decodificá-las.
+ *
+ * A lista cresce em blocos encadeados, alocados em uma arena, com o dobro
+ * do tamanho do anterior (até POSTING_BLOCK_MAX bytes): acrescentar uma
+ * ocorrência nunca copia a lista. Os bytes continuam de um bloco para o
+ * seguinte (uma ocorrência pode ficar dividida entre dois), de modo que só
+ * o último bloco tem bytes livres, o cabeçalho de um bloco é apenas o
+ * ponteiro para o seguinte e a concatenação dos blocos é a própria lista
+ * codificada.
+ *
+ * A cada POSTING_SKIP_INTERVAL ocorrências, a lista guarda um ponto de salto
+ * com o identificador anterior e o endereço da ocorrência seguinte. Um
+ * PostingCursor usa os pontos para avançar até uma música sem decodificar
+ * as ocorrências intermediárias, o que torna barata a interseção de uma
+ * lista longa com uma curta.
+ */
+
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include "arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Tamanho do primeiro bloco de uma lista, com o cabeçalho. */
+#define POSTING_BLOCK_MIN 16
+
+/** Tamanho máximo de um bloco, com o cabeçalho. */
+#define POSTING_BLOCK_MAX 4096
+
+/** Número de ocorrências entre dois pontos de salto. */
+#define POSTING_SKIP_INTERVAL 64
+
+/**
+ * @struct PostingBlock
+ * @brief Bloco de uma lista de ocorrências.
+ */
+typedef struct PostingBlock {
+  struct PostingBlock *next; /**< Bloco seguinte da lista, ou NULL. */
+  unsigned char bytes[];     /**< Ocorrências codificadas. */
+} PostingBlock;
+
+/**
+ * @struct PostingSkip
+ * @brief Ponto de salto de uma lista em memória.
+ *
+ * O ponto i fica antes da ocorrência (i + 1) * POSTING_SKIP_INTERVAL.
+ */
+typedef struct {
+  const PostingBlock *block; /**< Bloco em que a ocorrência começa. */
+  uint32_t song_id;          /**< Identificador da ocorrência anterior. */
+  uint16_t offset;           /**< Posição da ocorrência no bloco. */
+  uint16_t total;            /**< Tamanho do bloco, com o cabeçalho. */
+} PostingSkip;
+
+/**
+ * @struct PostingByteSkip
+ * @brief Ponto de salto de uma lista contígua (índices salvos).
+ */
+typedef struct {
+  uint32_t song_id; /**< Identificador da ocorrência anterior. */
+  uint32_t offset;  /**< Posição da ocorrência em bytes na lista. */
+} PostingByteSkip;
+
+/**
+ * @struct PostingList
+ * @brief Lista de ocorrências de uma palavra.
+ */
+typedef struct {
+  PostingBlock *first;       /**< Primeiro bloco, ou NULL se vazia. */
+  PostingBlock *last;        /**< Bloco em que a lista cresce. */
+  uint32_t last_size;        /**< Bytes usados no último bloco. */
+  uint32_t last_capacity;    /**< Capacidade de bytes do último bloco. */
+  unsigned int num_songs;    /**< Número de ocorrências (músicas). */
+  unsigned int last_song_id; /**< Identificador da última ocorrência. */
+  PostingSkip *skips;        /**< Pontos de salto (na arena dos blocos). */
+} PostingList;
+
+/**
+ * @struct Posting
+ * @brief Ocorrência decodificada.
+ */
+typedef struct {
+  unsigned int song_id; /**< Identificador da música. */
+  unsigned int count;   /**< Contagem da palavra na música. */
+} Posting;
+
+/**
+ * @struct PostingCursor
+ * @brief Leitura de uma lista de ocorrências, em memória ou contígua.
+ *
+ * As listas contíguas vêm de arquivos e são lidas conferindo os limites:
+ * uma lista corrompida termina antes (e marca truncated), mas nunca é lida
+ * fora dos seus bytes. As posições da ocorrência atual só são decodificadas
+ * quando pedidas.
+ */
+typedef struct {
+  const PostingList *list;           /**< Lista em memória, ou NULL. */
+  const unsigned char *bytes;        /**< Início da lista contígua. */
+  const PostingByteSkip *byte_skips; /**< Pontos de salto da contígua. */
+  const PostingBlock *block;         /**< Bloco atual (em memória). */
+  const unsigned char *next;         /**< Próximo byte a ler. */
+  const unsigned char *end;          /**< Fim dos bytes do bloco atual. */
+  size_t total;                      /**< Tamanho do bloco atual. */
+  unsigned int num_songs;            /**< Número de ocorrências da lista. */
+  unsigned int num_skips;            /**< Número de pontos de salto. */
+  unsigned int index;                /**< Ocorrências já lidas. */
+  unsigned int song_id;              /**< Música da ocorrência atual. */
+  unsigned int count;                /**< Contagem da ocorrência atual. */
+  uint32_t positions_size;           /**< Bytes das posições atuais. */
+  bool truncated;                    /**< A lista contígua está corrompida. */
+} PostingCursor;
+
+/**
+ * @brief Número de pontos de salto de uma lista com num_songs ocorrências.
+ */
+static inline unsigned int posting_skip_count(unsigned int num_songs) {
+  return num_songs > 0 ? (num_songs - 1) / POSTING_SKIP_INTERVAL : 0;
+}
+
+/**
+ * @brief Acrescenta uma ocorrência ao final de uma lista.
+ *
+ * @param list A lista.
+ * @param arena A arena dos blocos.
+ * @param song_id O identificador da música, maior que o da última
+ * ocorrência da lista.
+ * @param count A contagem da palavra na música.
+ * @param positions As count posições da palavra na música, em ordem
+ * crescente.
+ */
+void add_posting(PostingList *list, Arena *arena, unsigned int song_id,
+                 unsigned int count, const uint32_t *positions);
+
+/**
+ * @brief Acrescenta as ocorrências de uma lista ao final de outra.
+ *
+ * Usada para mesclar dicionários privados e índices salvos, cujas músicas
+ * são acrescentadas ao catálogo com um deslocamento.
+ *
+ * @param destination A lista que recebe as ocorrências.
+ * @param arena A arena dos blocos de destination.
+ * @param source A lista de origem.
+ * @param song_offset Deslocamento somado aos identificadores de source.
+ */
+void append_postings(PostingList *destination, Arena *arena,
+                     const PostingList *source, unsigned int song_offset);
+
+/**
+ * @brief Acrescenta ao final de uma lista as ocorrências que faltam ler em
+ * um cursor, copiando as posições sem decodificá-las.
+ *
+ * @param destination A lista que recebe as ocorrências.
+ * @param arena A arena dos blocos de destination.
+ * @param source O cursor de origem (não pode ser de destination).
+ * @param song_offset Deslocamento somado aos identificadores de source.
+ */
+void append_posting_cursor(PostingList *destination, Arena *arena,
+                           PostingCursor *source, unsigned int song_offset);
+
+/**
+ * @brief Decodifica as primeiras ocorrências de uma lista.
+ *
+ * @param list A lista.
+ * @param postings Recebe as ocorrências (pelo menos max).
+ * @param max O número máximo de ocorrências.
+ * @return O número de ocorrências decodificadas.
+ */
+size_t decode_postings(const PostingList *list, Posting *postings,
+                       size_t max);
+
+/**
+ * @brief Decodifica ocorrências de uma lista contígua, conferindo os
+ * limites (usada com os índices salvos).
+ *
+ * @param bytes A lista codificada.
+ * @param size O tamanho da lista em bytes.
+ * @param num_songs O número de ocorrências da lista.
+ * @param postings Recebe as ocorrências (pelo menos max).
+ * @param max O número máximo de ocorrências.
+ * @return O número de ocorrências decodificadas (menos que max se a lista
+ * terminar antes ou estiver truncada).
+ */
+size_t decode_posting_bytes(const unsigned char *bytes, size_t size,
+                            unsigned int num_songs, Posting *postings,
+                            size_t max);
+
+/**
+ * @brief Abre um cursor no início de uma lista em memória.
+ *
+ * O cursor vale enquanto a lista não crescer.
+ */
+void open_posting_list(PostingCursor *cursor, const PostingList *list);
+
+/**
+ * @brief Abre um cursor no início de uma lista contígua.
+ *
+ * @param cursor O cursor.
+ * @param bytes A lista codificada.
+ * @param size O tamanho da lista em bytes.
+ * @param num_songs O número de ocorrências da lista.
+ * @param skips Os pontos de salto (posting_skip_count(num_songs), ou NULL
+ * para ler a lista sem saltos).
+ */
+void open_posting_bytes(PostingCursor *cursor, const unsigned char *bytes,
+                        size_t size, unsigned int num_songs,
+                        const PostingByteSkip *skips);
+
+/**
+ * @brief Avança o cursor para a ocorrência seguinte.
+ * @return false se a lista acabou.
+ */
+bool posting_cursor_next(PostingCursor *cursor);
+
+/**
+ * @brief Avança o cursor até a primeira ocorrência com identificador maior
+ * ou igual a song_id, usando os pontos de salto (busca exponencial a partir
+ * do ponto atual). O cursor nunca recua.
+ *
+ * @return false se a lista acabou antes.
+ */
+bool posting_cursor_seek(PostingCursor *cursor, unsigned int song_id);
+
+/**
+ * @brief Decodifica as posições da ocorrência atual.
+ *
+ * @param cursor O cursor, posicionado em uma ocorrência.
+ * @param positions Recebe as posições (pelo menos cursor->count).
+ * @return O número de posições decodificadas (menos que cursor->count se a
+ * lista contígua estiver corrompida).
+ */
+size_t posting_cursor_positions(const PostingCursor *cursor,
+                                uint32_t *positions);
+
+/**
+ * @brief Copia os bytes de uma lista para um buffer contíguo.
+ *
+ * @param list A lista.
+ * @param out Recebe os bytes (pelo menos posting_list_size(list)).
+ * @return O número de bytes copiados.
+ */
+size_t copy_posting_bytes(const PostingList *list, unsigned char *out);
+
+/**
+ * @brief Copia os pontos de salto de uma lista, com as posições contadas
+ * desde o início da lista contígua gerada por copy_posting_bytes.
+ *
+ * @param list A lista.
+ * @param out Recebe os pontos (posting_skip_count(list->num_songs)).
+ * @return O número de pontos copiados.
+ */
+size_t copy_posting_skips(const PostingList *list, PostingByteSkip *out);
+
+/**
+ * @brief Tamanho da lista codificada, em bytes.
+ */
+size_t posting_list_size(const PostingList *list);
+
+/**
+ * @brief Memória ocupada pelos blocos da lista, com cabeçalhos e bytes
+ * livres, e pelos seus pontos de salto.
+ */
+size_t posting_list_allocated(const PostingList *list);
+
+#endif // POSTINGS_H
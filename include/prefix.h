@@ -0,0 +1,116 @@
+/**
+ * @file prefix.h
+ * @brief Busca por prefixo (autocompletar) no array ordenado.
+ *
+ * As palavras que começam com um prefixo ocupam um intervalo contíguo do
+ * array ordenado, encontrado com duas buscas binárias. As primeiras
+ * palavras do intervalo em ordem alfabética saem direto do array; para
+ * ordenar as sugestões pela contagem total, um CountIndex (árvore de
+ * segmentos com a posição de maior contagem de cada intervalo) fornece as
+ * N maiores contagens do intervalo em O(N log n), qualquer que seja o
+ * tamanho do intervalo.
+ */
+
+#ifndef PREFIX_H
+#define PREFIX_H
+
+#include "snapshot.h"
+#include "structures.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct CountIndex
+ * @brief Árvore de segmentos sobre as contagens de um array ordenado.
+ *
+ * O nó k (a partir de 1) tem filhos 2k e 2k + 1, e as folhas ficam nas
+ * posições leaves a 2 * leaves - 1. Cada nó guarda a posição de maior
+ * contagem do seu intervalo (a menor posição, nos empates).
+ */
+typedef struct {
+  uint32_t *counts; /**< Contagem de cada posição do array. */
+  uint32_t *tree;   /**< Posição de maior contagem de cada nó. */
+  size_t size;      /**< Número de posições. */
+  size_t leaves;    /**< Número de folhas (potência de 2 >= size). */
+} CountIndex;
+
+// Montado sob demanda a partir de sorted_word_array; NULL se desatualizado
+// (qualquer palavra nova ou mudança de contagem o invalida).
+extern CountIndex *count_index;
+
+/**
+ * @brief Encontra o intervalo do array ordenado com as palavras que começam
+ * com um prefixo.
+ *
+ * @param arr O WordArray ordenado.
+ * @param prefix O prefixo (o vazio corresponde ao array inteiro).
+ * @param first Recebe a primeira posição do intervalo.
+ * @return O número de palavras com o prefixo, em O(log n).
+ */
+size_t prefix_range(const WordArray *arr, const char *prefix, size_t *first);
+
+/**
+ * @brief Monta um CountIndex.
+ *
+ * @param counts As contagens, alocadas com malloc (o índice passa a ser o
+ * dono do array).
+ * @param size O número de contagens.
+ * @return O novo CountIndex.
+ */
+CountIndex *build_count_index(uint32_t *counts, size_t size);
+
+/**
+ * @brief Monta o CountIndex das contagens totais de um WordArray.
+ * @param arr O WordArray ordenado.
+ * @return O novo CountIndex.
+ */
+CountIndex *build_word_array_count_index(const WordArray *arr);
+
+/**
+ * @brief Monta o CountIndex das contagens totais de um índice salvo, na
+ * ordem alfabética da seção WORDS.
+ * @param snapshot O índice.
+ * @return O novo CountIndex.
+ */
+CountIndex *build_snapshot_count_index(const Snapshot *snapshot);
+
+/**
+ * @brief Lista as posições de maior contagem de um intervalo.
+ *
+ * Uma fila de prioridade guarda subintervalos com a posição de maior
+ * contagem de cada um; a cada posição retirada, o subintervalo é dividido
+ * em dois. Custa O(limit log n).
+ *
+ * @param index O CountIndex.
+ * @param first A primeira posição do intervalo.
+ * @param end A posição seguinte à última do intervalo.
+ * @param limit O número máximo de posições.
+ * @param positions Recebe as posições (pelo menos limit), da maior contagem
+ * para a menor e, nos empates, em ordem alfabética.
+ * @return O número de posições escritas.
+ */
+size_t top_counts_in_range(const CountIndex *index, size_t first, size_t end,
+                           size_t limit, size_t *positions);
+
+/**
+ * @brief Libera a memória alocada por um CountIndex.
+ * @param index O CountIndex a ser liberado (pode ser NULL).
+ */
+void free_count_index(CountIndex *index);
+
+/**
+ * @brief Busca as palavras que começam com um prefixo.
+ *
+ * @param arr O WordArray ordenado.
+ * @param index O CountIndex de arr, para ordenar as sugestões pela contagem
+ * total, ou NULL para a ordem alfabética.
+ * @param prefix O prefixo.
+ * @param limit O número máximo de palavras.
+ * @param total Recebe o número de palavras com o prefixo (pode ser NULL).
+ * @return Um WordArray com até limit registros.
+ */
+WordArray *search_prefix(const WordArray *arr, const CountIndex *index,
+                         const char *prefix, size_t limit, size_t *total);
+
+#endif // PREFIX_H
@@ -0,0 +1,138 @@
+/**
+ * @file query.h
+ * @brief Consultas em modo texto, uma por linha, com respostas em formato
+ * legível por máquina.
+ *
+ * Usado pelo modo em lote do programa (--batch) e pelo servidor
+ * (--serve, server.h). Cada linha de entrada é uma consulta:
+ *
+ *     lookup <palavra>
+ *     frequency <frequência mínima>
+ *     top <k>                    as k palavras mais frequentes
+ *     rank <palavra>             posição da palavra entre as mais frequentes
+ *     select <posição>           a palavra em uma posição (1 = mais frequente)
+ *     range <mínima> <máxima>    palavras com frequência na faixa (inclusive)
+ *     count <mínima> <máxima>    só o número dessas palavras
+ *     prefix <prefixo> <n>       as n primeiras palavras com o prefixo
+ *     complete <prefixo> <n>     as n mais frequentes com o prefixo
+ *     songs <palavra> <n>        as n primeiras músicas com a palavra
+ *     and <n> <palavra>...       as n primeiras músicas com todas as palavras
+ *     phrase <n> <palavra>...    as n primeiras músicas com a frase
+ *     relevant <n> <palavra>...  as n músicas mais relevantes (BM25)
+ *     stats                      o tamanho do índice
+ *     page <mínima> <limite> [<token>]
+ *                                até limite palavras com frequência mínima,
+ *                                após a chave do token "<contagem>:<palavra>"
+ *
+ * Linhas vazias e iniciadas por '#' são ignoradas. As respostas são linhas
+ * com campos separados por tabulação:
+ *
+ *     hit <palavra> <total> <ocorrências na música> <título> <autor>
+ *     miss <palavra>
+ *     frequency <mínima> <n>     seguida de n linhas "<palavra> <total>"
+ *     top <k> <n>                idem, da mais frequente para a menos
+ *     rank <palavra> <posição> <total>
+ *     select <posição> <palavra> <total>
+ *     range <mínima> <máxima> <n>  seguida de n linhas, como frequency
+ *     count <mínima> <máxima> <n>
+ *     page <mínima> <n> <token>  seguida de n linhas, como frequency; o
+ *                                token da página seguinte, ou "-" no fim
+ *     prefix <prefixo> <total> <n>  seguida de n linhas, como frequency
+ *     complete <prefixo> <total> <n>  idem
+ *     songs <palavra> <músicas> <n>  seguida de n linhas "<identificador>
+ *                                <ocorrências> <título> <autor>", em ordem
+ *                                de identificador
+ *     and <músicas> <n>          seguida de n linhas "<identificador>
+ *                                <título> <autor>", em ordem de identificador
+ *     phrase <músicas> <n>       idem
+ *     relevant <n>               seguida de n linhas "<identificador>
+ *                                <relevância> <título> <autor>", da mais
+ *                                relevante para a menos relevante
+ *     stats <músicas> <palavras> <ocorrências>
+ *                                palavras distintas e ocorrências indexadas
+ *     error <mensagem>
+ *
+ * A ordem de top, rank e select é a de (contagem, palavra) decrescente;
+ * rank, select e count usam os tamanhos das subárvores da árvore de
+ * frequência e custam O(log n). frequency, range e page escrevem as
+ * palavras à medida que percorrem a árvore, sem copiar os resultados, e o
+ * token de page continua válido depois de novas cargas. songs decodifica
+ * apenas as n primeiras ocorrências da lista da palavra. and e phrase
+ * aceitam até 16 palavras, normalizadas como as letras das músicas (as de
+ * menos de 3 letras só contam nas distâncias da frase, e a pontuação nem
+ * isso), e intersectam as listas de ocorrências com search_text. relevant
+ * também aceita até 16 palavras, mas basta que a música contenha uma
+ * delas, e ranqueia com rank_text. Tabulações e quebras de linha dentro dos textos são trocadas
+ * por espaços.
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "prefix.h"
+#include "snapshot.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Estrutura usada para responder as buscas de palavras.
+ */
+typedef enum {
+  QUERY_ENGINE_BST,       /**< bin_tree (BST ou treap). */
+  QUERY_ENGINE_AVL,       /**< avl_tree. */
+  QUERY_ENGINE_ARRAY,     /**< Busca binária em sorted_word_array. */
+  QUERY_ENGINE_EYTZINGER, /**< eytzinger_array. */
+  QUERY_ENGINE_SNAPSHOT   /**< Índice salvo mapeado em memória. */
+} QueryEngine;
+
+/**
+ * @struct QueryContext
+ * @brief Estado de uma sequência de consultas.
+ *
+ * As buscas por frequência usam avl_frequency_tree, ou a ordem de
+ * frequência do índice salvo com QUERY_ENGINE_SNAPSHOT. As buscas por
+ * prefixo usam sorted_word_array e count_index, ou as palavras do índice
+ * salvo e snapshot_counts, montado na primeira consulta complete e liberado
+ * por quem criou o contexto.
+ */
+typedef struct {
+  QueryEngine engine;          /**< Estrutura das buscas de palavras. */
+  const Snapshot *snapshot;    /**< Índice salvo (QUERY_ENGINE_SNAPSHOT). */
+  CountIndex *snapshot_counts; /**< Contagens do índice salvo, ou NULL. */
+  size_t num_queries;          /**< Consultas executadas. */
+  size_t num_errors;           /**< Consultas inválidas. */
+} QueryContext;
+
+/**
+ * @brief Converte o nome de uma estrutura ("bst", "avl", "array",
+ * "eytzinger" ou "snapshot").
+ *
+ * @param name O nome.
+ * @param engine Recebe a estrutura.
+ * @return true se o nome for conhecido.
+ */
+bool parse_query_engine(const char *name, QueryEngine *engine);
+
+/**
+ * @brief Executa uma consulta e escreve a resposta.
+ *
+ * Com as estruturas em memória, eytzinger_array é montado na primeira
+ * busca, se necessário.
+ *
+ * @param context O estado das consultas.
+ * @param line A linha da consulta, sem o '\n' (é alterada).
+ * @param out O destino das respostas.
+ */
+void execute_query(QueryContext *context, char *line, FILE *out);
+
+/**
+ * @brief Executa todas as consultas de um arquivo, uma por linha.
+ *
+ * @param context O estado das consultas.
+ * @param in A origem das consultas.
+ * @param out O destino das respostas.
+ */
+void run_query_stream(QueryContext *context, FILE *in, FILE *out);
+
+#endif // QUERY_H
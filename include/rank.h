@@ -0,0 +1,137 @@
+/**
+ * @file rank.h
+ * @brief Ranqueamento de músicas por relevância (BM25) para uma consulta
+ * com uma ou mais palavras.
+ *
+ * A relevância de uma música é a soma, sobre as palavras da consulta que
+ * ela contém, de
+ *
+ *     idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * tamanho / média)),
+ *
+ * em que tf é a contagem da palavra na música, tamanho é o número de
+ * ocorrências de palavras indexadas da música (contado na carga) e
+ * idf = log(1 + (N - n + 0,5) / (n + 0,5)), com N músicas no catálogo e n
+ * músicas com a palavra. Uma palavra repetida na consulta conta uma vez por
+ * repetição.
+ *
+ * As k músicas mais relevantes são obtidas pelo algoritmo max-score: cada
+ * palavra tem um limite superior da sua contribuição (calculado com a
+ * maior contagem da palavra em uma música, a da melhor ocorrência, e
+ * tamanho zero). Ordenadas pelos limites, as palavras cuja soma dos limites
+ * não alcança a k-ésima relevância já encontrada deixam de gerar
+ * candidatas: só são consultadas, com posting_cursor_seek, nas músicas que
+ * contêm alguma das demais e enquanto a música ainda puder entrar no
+ * resultado. Assim, as palavras muito comuns (de idf baixo) quase não são
+ * decodificadas.
+ */
+
+#ifndef RANK_H
+#define RANK_H
+
+#include "postings.h"
+#include "repository.h"
+#include "snapshot.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/** Saturação da contagem no BM25. */
+#define BM25_K1 1.2
+
+/** Peso da normalização pelo tamanho da música no BM25. */
+#define BM25_B 0.75
+
+/**
+ * @struct RankedSong
+ * @brief Uma música do resultado, com a sua relevância.
+ */
+typedef struct {
+  uint32_t song_id; /**< Identificador da música. */
+  double score;     /**< Relevância. */
+} RankedSong;
+
+/**
+ * @struct RankCorpus
+ * @brief Estatísticas do catálogo usadas pelo BM25.
+ */
+typedef struct {
+  const uint32_t *lengths; /**< Tamanho de cada música. */
+  unsigned int num_songs;  /**< Número de músicas. */
+  double average_length;   /**< Tamanho médio (maior que zero). */
+} RankCorpus;
+
+/**
+ * @struct RankTerm
+ * @brief Uma palavra de uma consulta ranqueada.
+ */
+typedef struct {
+  PostingCursor cursor;   /**< Cursor no início da lista da palavra. */
+  unsigned int max_count; /**< Maior contagem da palavra em uma música. */
+  unsigned int repeats;   /**< Vezes que a palavra aparece na consulta. */
+} RankTerm;
+
+/**
+ * @brief As k músicas mais relevantes para as palavras, pelo max-score.
+ *
+ * @param terms As palavras (os cursores são consumidos).
+ * @param num_terms O número de palavras.
+ * @param corpus As estatísticas do catálogo.
+ * @param k O número máximo de músicas.
+ * @param out Recebe as músicas (pelo menos k), da mais relevante para a
+ * menos relevante; empates ficam em ordem crescente de identificador.
+ * @return O número de músicas (menos que k se poucas contêm as palavras).
+ */
+size_t rank_terms(RankTerm *terms, size_t num_terms, const RankCorpus *corpus,
+                  size_t k, RankedSong *out);
+
+/**
+ * @brief Estatísticas de um repositório em memória.
+ */
+void repository_rank_corpus(const Repository *repo, RankCorpus *corpus);
+
+/**
+ * @brief Estatísticas de um índice salvo.
+ */
+void snapshot_rank_corpus(const Snapshot *snapshot, RankCorpus *corpus);
+
+/**
+ * @brief Função que abre o cursor da lista de uma palavra e informa a sua
+ * maior contagem (term->repeats não é alterado).
+ * @return false se a palavra não estiver no índice.
+ */
+typedef bool (*RankLookup)(const void *index, const char *word,
+                           RankTerm *term);
+
+/**
+ * @brief RankLookup para um repositório em memória (index é Repository *).
+ */
+bool rank_repository_term(const void *index, const char *word,
+                          RankTerm *term);
+
+/**
+ * @brief RankLookup para um índice salvo (index é Snapshot *).
+ */
+bool rank_snapshot_term(const void *index, const char *word, RankTerm *term);
+
+/**
+ * @brief As k músicas mais relevantes para as palavras de um texto.
+ *
+ * O texto é separado e normalizado como as letras das músicas; as palavras
+ * com menos de 3 letras e as que não estão no índice são ignoradas.
+ *
+ * @param text O texto da consulta.
+ * @param lookup Função que abre as listas das palavras.
+ * @param index O índice repassado a lookup.
+ * @param corpus As estatísticas do catálogo do índice.
+ * @param k O número máximo de músicas (limitado ao tamanho do catálogo).
+ * @param songs Recebe um array alocado com as músicas, da mais relevante
+ * para a menos relevante, que o chamador libera com free, ou NULL se a
+ * alocação falhar.
+ * @param num_terms Recebe o número de palavras indexáveis do texto (0 se
+ * não houver nenhuma).
+ * @return O número de músicas.
+ */
+size_t rank_text(const char *text, RankLookup lookup, const void *index,
+                 const RankCorpus *corpus, size_t k, RankedSong **songs,
+                 size_t *num_terms);
+
+#endif // RANK_H
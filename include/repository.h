@@ -1,7 +1,10 @@
 #ifndef REPOSITORY_H
 #define REPOSITORY_H
 
+#include "arena.h"
+#include "dictionary.h"
 #include "structures.h"
+#include <stdint.h>
 #include <stdio.h>
 
 /**
@@ -10,33 +13,179 @@
  * única música.
  */
 typedef struct WordCount {
-  char *word;             /**< A palavra. */
-  unsigned int count;     /**< Contagem da palavra na música. */
-  struct WordCount *next; /**< Ponteiro para o próximo WordCount. */
+  char *word;              /**< A palavra (na arena do contador). */
+  unsigned int count;      /**< Contagem da palavra na música. */
+  unsigned int verse_line; /**< Índice do primeiro verso em que aparece. */
 } WordCount;
 
+/**
+ * @struct WordCountSlot
+ * @brief Posição da tabela hash de um WordCounter.
+ *
+ * Guarda o hash da palavra junto ao índice da entrada, de modo que colisões
+ * são descartadas sem acessar a string.
+ */
+typedef struct {
+  unsigned int hash;  /**< Hash da palavra armazenada. */
+  unsigned int entry; /**< Índice da entrada + 1 (0 indica posição vazia). */
+} WordCountSlot;
+
+/**
+ * @struct WordCounter
+ * @brief Contador de palavras de uma música, com tabela hash de endereçamento
+ * aberto (sondagem linear).
+ *
+ * As entradas ficam em um array denso, na ordem da primeira ocorrência de cada
+ * palavra, e as palavras são copiadas para uma arena liberada de uma só vez.
+ */
+typedef struct {
+  WordCountSlot *slots;  /**< Tabela hash (capacidade potência de dois). */
+  size_t slot_capacity;  /**< Número de posições da tabela. */
+  WordCount *entries;    /**< Entradas na ordem de inserção. */
+  size_t size;           /**< Número de palavras distintas. */
+  size_t entry_capacity; /**< Capacidade do array de entradas. */
+  Arena words;           /**< Armazenamento das palavras. */
+} WordCounter;
+
 /**
  * @struct Song
  * @brief Estrutura que representa uma música.
+ *
+ * Apenas os versos usados como trecho de alguma palavra são guardados.
  */
 typedef struct {
   char *title;         /**< Título da música. */
   char *author;        /**< Autor da música. */
-  char **lyrics_lines; /**< Linhas da letra da música. */
-  int number_of_lines; /**< Número de linhas na letra. */
+  char **lyrics_lines; /**< Versos referenciados pelas ocorrências. */
+  int number_of_lines; /**< Número de versos guardados. */
 } Song;
 
 /**
  * @struct Repository
  * @brief Estrutura que representa o repositório de músicas.
+ *
+ * O catálogo de músicas é indexado pelo identificador usado em
+ * SongOccurrence. Os textos (títulos, autores e versos) de todas as músicas
+ * ficam em uma arena do repositório. Cada palavra tem um único registro no
+ * dicionário, e os nós das árvores, que apenas apontam para os registros,
+ * ficam em arenas próprias, de modo que a liberação do repositório não
+ * percorre as árvores.
+ *
+ * O tamanho de cada música (o número de ocorrências de palavras indexadas,
+ * usado para normalizar a relevância) fica em um array à parte, paralelo ao
+ * catálogo, de modo que o ranqueamento o consulta sem carregar os registros
+ * das músicas.
  */
 typedef struct {
-  Node *bst_root; /**< Raiz da árvore de busca binária. */
-  Node *avl_root; /**< Raiz da árvore AVL. */
-  Song *songs;    /**< Array de músicas. */
-  int num_songs;  /**< Número de músicas no repositório. */
+  Song *songs;            /**< Array de músicas. */
+  uint32_t *song_lengths; /**< Palavras indexadas de cada música. */
+  uint64_t total_length;  /**< Soma de song_lengths. */
+  int num_songs;          /**< Número de músicas no repositório. */
+  int songs_capacity;     /**< Capacidade do array de músicas. */
+  Arena strings;          /**< Títulos, autores e versos das músicas. */
+  Dictionary dictionary;  /**< Registros das palavras distintas. */
+  Arena nodes;            /**< Nós da BST e da AVL. */
+  Arena frequency_nodes;  /**< Nós da árvore de frequência. */
 } Repository;
 
+// Catálogo global de músicas, usado pelas árvores globais.
+extern Repository *song_repository;
+
+/**
+ * @brief Cria um repositório vazio.
+ * @return Um ponteiro para o novo repositório.
+ */
+Repository *create_repository();
+
+/**
+ * @brief Adiciona uma música ao catálogo.
+ *
+ * Os textos devem ter sido alocados na arena do repositório; apenas o array
+ * de versos é copiado.
+ *
+ * @param repo O repositório.
+ * @param title O título da música.
+ * @param author O autor da música.
+ * @param lines Os versos referenciados pelas ocorrências da música.
+ * @param number_of_lines O número de versos.
+ * @param length O número de ocorrências de palavras indexadas na música.
+ * @return O identificador da música.
+ */
+unsigned int add_song(Repository *repo, char *title, char *author,
+                      char **lines, int number_of_lines, unsigned int length);
+
+/**
+ * @brief Move todas as músicas de um repositório para o final de outro.
+ *
+ * A música de identificador i em source passa a ter o identificador
+ * (valor retornado + i) em destination. source fica sem músicas.
+ *
+ * @param destination O repositório que recebe as músicas.
+ * @param source O repositório de origem.
+ * @return O deslocamento aplicado aos identificadores.
+ */
+unsigned int move_songs(Repository *destination, Repository *source);
+
+/**
+ * @brief Retorna a música com o identificador informado.
+ * @param repo O repositório.
+ * @param song_id O identificador da música.
+ * @return Ponteiro para a música.
+ */
+const Song *get_song(const Repository *repo, unsigned int song_id);
+
+/**
+ * @brief Libera o catálogo, os textos, o dicionário e os nós de um
+ * repositório.
+ *
+ * As arenas são liberadas por inteiro, sem percorrer as árvores.
+ *
+ * @param repo O repositório.
+ */
+void free_repository(Repository *repo);
+
+/**
+ * @brief Converte uma string para minúsculas.
+ * @param s A string a ser convertida.
+ */
+void to_lowercase(char *s);
+
+/**
+ * @brief Remove a pontuação de uma string.
+ * @param s A string da qual a pontuação será removida.
+ */
+void remove_punctuation(char *s);
+
+/**
+ * @brief Função chamada para cada palavra distinta de uma música processada.
+ *
+ * positions traz as count posições da palavra na música, em ordem
+ * crescente: o índice de cada ocorrência entre todas as palavras da música,
+ * inclusive as que não são indexadas. Os ponteiros recebidos só são válidos
+ * durante a chamada.
+ */
+typedef void (*SongWordHandler)(const char *word, unsigned int count,
+                                const uint32_t *positions,
+                                unsigned int song_id, unsigned int verse_line,
+                                void *context);
+
+/**
+ * @brief Lê um arquivo de música, registra-o no catálogo e entrega cada
+ * palavra distinta ao tratador informado, na ordem da primeira ocorrência.
+ *
+ * O arquivo é mapeado em memória e tokenizado no lugar, em uma única
+ * passada e sem limite de tamanho de linha. A primeira linha é o título, a
+ * segunda o autor e as demais são os versos.
+ *
+ * @param filepath O caminho para o arquivo de música.
+ * @param repo O catálogo em que a música é registrada.
+ * @param handler Função chamada para cada palavra distinta.
+ * @param context Ponteiro repassado ao tratador.
+ * @return true se o arquivo foi lido, false caso contrário.
+ */
+bool scan_music_file(const char *filepath, Repository *repo,
+                     SongWordHandler handler, void *context);
+
 /**
  * @brief Processa um arquivo de música, extraindo palavras e metadados.
  * @param filepath O caminho para o arquivo de música.
@@ -45,28 +194,67 @@ typedef struct {
  */
 void process_music_file_for_word_count(const char *filepath, const char *title,
                                        const char *author);
+/**
+ * @brief Processa um arquivo de música em um repositório privado, sem tocar
+ * nas árvores nem no catálogo globais.
+ *
+ * Usada pela carga paralela de diretórios: cada thread acumula suas músicas
+ * no próprio catálogo e as palavras no dicionário do repositório, que são
+ * mesclados nas estruturas globais ao final.
+ *
+ * @param filepath O caminho para o arquivo de música.
+ * @param repo O repositório privado.
+ */
+void process_music_file_into_repository(const char *filepath,
+                                        Repository *repo);
+
+/**
+ * @brief Atualiza o array ordenado e a árvore de frequência globais com as
+ * palavras alteradas desde a última atualização.
+ *
+ * Percorre apenas a lista de registros alterados do dicionário: palavras
+ * novas são intercaladas no array ordenado e indexadas na árvore de
+ * frequência, e palavras cuja contagem mudou são reposicionadas nela. Se
+ * houver palavras novas, eytzinger_array é descartado. A lista é esvaziada
+ * ao final.
+ *
+ * @param repo O repositório global.
+ */
+void update_search_structures(Repository *repo);
+
+/**
+ * @brief Inicializa um contador de palavras vazio.
+ * @param counter O contador.
+ */
+void init_word_counter(WordCounter *counter);
+
 /**
  * @brief Encontra ou cria uma entrada de contagem de palavras.
- * @param head Ponteiro para o início da lista de contagem de palavras.
+ * @param counter O contador de palavras da música.
  * @param word A palavra a ser encontrada ou criada.
- * @return Ponteiro para a entrada de contagem de palavras.
+ * @return Ponteiro para a entrada de contagem de palavras. O ponteiro é
+ * válido até a próxima inserção no contador.
  */
-WordCount *find_or_create_word_count(WordCount **head, const char *word);
+WordCount *find_or_create_word_count(WordCounter *counter, const char *word);
 
 /**
- * @brief Libera a lista de contagem de palavras.
- * @param head O início da lista.
+ * @brief Encontra ou cria uma entrada de contagem para uma palavra dada por
+ * ponteiro e comprimento (não precisa terminar em '\0').
+ *
+ * A palavra só é copiada para a arena do contador quando é nova.
+ *
+ * @param counter O contador de palavras da música.
+ * @param word Início da palavra.
+ * @param length Comprimento da palavra.
+ * @return Ponteiro para a entrada de contagem de palavras.
  */
-void free_word_count_list(WordCount *head);
+WordCount *find_or_create_word_count_span(WordCounter *counter,
+                                          const char *word, size_t length);
 
 /**
- * @brief Encontra um trecho de verso que contém uma palavra.
- * @param file Ponteiro para o arquivo.
- * @param word A palavra a ser encontrada.
- * @param snippet_buffer Buffer para armazenar o trecho.
- * @param buffer_size Tamanho do buffer.
- * @return Ponteiro para o buffer com o trecho do verso.
+ * @brief Libera a tabela, as entradas e as palavras de um contador.
+ * @param counter O contador.
  */
-char *find_verse_snippet(FILE *file, const char *word, char *snippet_buffer,
-                         size_t buffer_size);
+void free_word_counter(WordCounter *counter);
+
 #endif // REPOSITORY_H
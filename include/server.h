@@ -0,0 +1,77 @@
+/**
+ * @file server.h
+ * @brief Servidor local de consultas (modo --serve).
+ *
+ * O servidor escuta em um socket de domínio Unix ou em TCP na interface de
+ * loopback e responde as mesmas consultas do modo em lote (query.h), uma
+ * por linha. Cada linha recebida tem exatamente uma resposta, no formato de
+ * query.h, terminada por uma linha vazia (só a linha vazia para as linhas
+ * vazias e os comentários), de modo que o cliente pode enviar várias
+ * consultas sem esperar as respostas.
+ *
+ * Uma thread de eventos (epoll) aceita as conexões e entrega as que têm
+ * dados a um conjunto de threads de trabalho. Cada conexão é registrada
+ * com EPOLLONESHOT: enquanto uma thread de trabalho a atende, ela não gera
+ * novos eventos, e o seu estado não precisa de travas. A thread de
+ * trabalho lê o que chegou, executa até 1024 linhas completas como um lote
+ * (na mesma versão do índice, com as respostas em um único buffer), envia
+ * as respostas e rearma a conexão: para leitura ou, se o envio ficou
+ * incompleto, só para escrita. Enquanto restarem linhas completas de um
+ * lote anterior, nada mais é lido. Assim a memória de cada conexão é
+ * limitada tanto para um cliente que não lê as respostas quanto para um
+ * que envia mais rápido do que o servidor executa.
+ *
+ * As consultas usam as versões publicadas de um LiveIndex (live.h). Os
+ * caminhos de --load são carregados em segundo plano por uma thread
+ * escritora, que publica uma versão a cada caminho: o servidor responde
+ * desde o início, e cada consulta vê o índice antes ou depois de cada
+ * carga, nunca no meio.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "snapshot.h"
+
+/**
+ * @struct ServerOptions
+ * @brief Configuração do servidor.
+ */
+typedef struct {
+  const char *address;     /**< Endereço (ver server_listen). */
+  int num_workers;         /**< Threads de trabalho (0 usa os núcleos). */
+  const char **load_paths; /**< Caminhos carregados em segundo plano. */
+  int num_load_paths;      /**< Número de caminhos. */
+  Snapshot *snapshot;      /**< Índice inicial, ou NULL; passa a pertencer
+                                ao servidor. */
+} ServerOptions;
+
+/**
+ * @brief Abre o socket de escuta de um endereço.
+ *
+ * Um endereço com ':' é TCP, "<IPv4>:<porta>" ou ":<porta>" (127.0.0.1);
+ * só endereços de loopback (127.0.0.0/8) são aceitos, pois o servidor não
+ * tem autenticação. Os demais são caminhos de sockets de domínio Unix; um
+ * socket antigo no mesmo caminho é substituído.
+ *
+ * @param address O endereço.
+ * @return O descritor, ou -1 em caso de erro (informado em stderr).
+ */
+int server_listen(const char *address);
+
+/**
+ * @brief Conecta a um servidor (endereço como em server_listen).
+ * @param address O endereço.
+ * @return O descritor, ou -1 em caso de erro (informado em stderr).
+ */
+int server_connect(const char *address);
+
+/**
+ * @brief Executa o servidor até receber SIGINT ou SIGTERM.
+ *
+ * @param options A configuração.
+ * @return 0 se o servidor foi encerrado normalmente, 1 em caso de erro.
+ */
+int run_server(const ServerOptions *options);
+
+#endif // SERVER_H
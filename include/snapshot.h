@@ -0,0 +1,339 @@
+/**
+ * @file snapshot.h
+ * @brief Índice salvo em arquivo binário, carregado por mapeamento em
+ * memória.
+ *
+ * O arquivo guarda o dicionário (palavras, contagens, melhores
+ * ocorrências e listas de ocorrências, com os pontos de salto) na ordem do
+ * array ordenado, a ordem da árvore de frequência, uma cópia do array em
+ * ordem de Eytzinger para as buscas e o catálogo de músicas (títulos,
+ * autores, versos referenciados e tamanhos, para o ranqueamento).
+ * Todas as referências são deslocamentos dentro do arquivo, de modo que ele
+ * pode ser mapeado em qualquer endereço e consultado sem montar árvores: a
+ * carga custa o mesmo para qualquer tamanho de repositório.
+ *
+ * O cabeçalho tem número mágico, versão, marca de ordem de bytes e soma de
+ * verificação própria, e a soma do restante do arquivo pode ser conferida
+ * na carga. Os índices lidos do arquivo são conferidos a cada acesso, de
+ * modo que um arquivo corrompido produz respostas erradas, mas não acessos
+ * fora do mapeamento.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "repository.h"
+#include "structures.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Número mágico no início do arquivo. */
+#define SNAPSHOT_MAGIC "SONGIDX"
+
+/** Versão do formato. Arquivos de outras versões são recusados. */
+#define SNAPSHOT_VERSION 4
+
+/** Seções do arquivo, na ordem em que são gravadas. */
+enum {
+  SNAPSHOT_STRINGS,   /**< Textos terminados em '\0'; o deslocamento 0 é "". */
+  SNAPSHOT_SONGS,     /**< SnapshotSong, por identificador da música. */
+  SNAPSHOT_LENGTHS,   /**< Tamanhos (uint32_t) das músicas, idem. */
+  SNAPSHOT_LINES,     /**< Deslocamentos (uint64_t) dos versos. */
+  SNAPSHOT_WORDS,     /**< SnapshotWord, em ordem alfabética. */
+  SNAPSHOT_PREFIXES,  /**< word_prefix em ordem de Eytzinger (a partir de 1). */
+  SNAPSHOT_LOOKUP,    /**< Índices (uint32_t) em WORDS, na mesma ordem. */
+  SNAPSHOT_FREQUENCY, /**< Índices em WORDS por (contagem, palavra). */
+  SNAPSHOT_POSTINGS,  /**< Listas de ocorrências, como em postings.h. */
+  SNAPSHOT_SKIPS,     /**< PostingByteSkip das listas, na mesma ordem. */
+  SNAPSHOT_NUM_SECTIONS
+};
+
+/**
+ * @struct SnapshotSection
+ * @brief Posição de uma seção no arquivo (alinhada a 64 bytes).
+ */
+typedef struct {
+  uint64_t offset; /**< Deslocamento a partir do início do arquivo. */
+  uint64_t size;   /**< Tamanho em bytes. */
+} SnapshotSection;
+
+/**
+ * @struct SnapshotHeader
+ * @brief Cabeçalho do arquivo.
+ */
+typedef struct {
+  char magic[8];          /**< SNAPSHOT_MAGIC. */
+  uint32_t version;       /**< SNAPSHOT_VERSION. */
+  uint32_t byte_order;    /**< 0x01020304 na ordem de bytes de quem gravou. */
+  uint64_t file_size;     /**< Tamanho total do arquivo. */
+  uint64_t body_checksum; /**< Soma dos bytes após o cabeçalho. */
+  uint32_t num_songs;     /**< Número de músicas. */
+  uint32_t num_lines;     /**< Número total de versos. */
+  uint32_t num_words;     /**< Número de palavras distintas. */
+  uint32_t reserved;      /**< Zero. */
+  uint64_t total_length;  /**< Soma dos tamanhos das músicas. */
+  SnapshotSection sections[SNAPSHOT_NUM_SECTIONS]; /**< Seções. */
+  uint64_t header_checksum; /**< Soma dos campos anteriores. */
+} SnapshotHeader;
+
+/**
+ * @struct SnapshotSong
+ * @brief Uma música do catálogo salvo.
+ */
+typedef struct {
+  uint64_t title;      /**< Deslocamento do título em STRINGS. */
+  uint64_t author;     /**< Deslocamento do autor em STRINGS. */
+  uint32_t first_line; /**< Índice do primeiro verso em LINES. */
+  uint32_t num_lines;  /**< Número de versos. */
+} SnapshotSong;
+
+/**
+ * @struct SnapshotWord
+ * @brief Registro salvo de uma palavra (o equivalente a WordEntry).
+ */
+typedef struct {
+  uint64_t word;               /**< Deslocamento da palavra em STRINGS. */
+  uint32_t total_word_count;   /**< Contagem total no repositório. */
+  uint32_t song_id;            /**< Música da melhor ocorrência. */
+  uint32_t verse_line;         /**< Verso da melhor ocorrência na música. */
+  uint32_t word_count_in_song; /**< Contagem na melhor música. */
+  uint64_t postings;           /**< Deslocamento da lista em POSTINGS. */
+  uint32_t postings_size;      /**< Tamanho da lista em bytes. */
+  uint32_t num_songs;          /**< Número de músicas na lista. */
+  uint64_t skips;              /**< Índice do primeiro ponto em SKIPS. */
+} SnapshotWord;
+
+/**
+ * @struct Snapshot
+ * @brief Índice salvo mapeado em memória (ou montado por build_snapshot).
+ *
+ * Os ponteiros apontam para dentro do mapeamento e valem até free_snapshot.
+ */
+typedef struct {
+  const unsigned char *data;     /**< Início do mapeamento. */
+  size_t size;                   /**< Tamanho do mapeamento. */
+  const char *strings;           /**< Seção STRINGS. */
+  size_t strings_size;           /**< Tamanho de STRINGS. */
+  const SnapshotSong *songs;     /**< Seção SONGS. */
+  const uint32_t *song_lengths;  /**< Seção LENGTHS. */
+  const uint64_t *lines;         /**< Seção LINES. */
+  const SnapshotWord *words;     /**< Seção WORDS. */
+  const uint64_t *prefixes;      /**< Seção PREFIXES. */
+  const uint32_t *lookup;        /**< Seção LOOKUP. */
+  const uint32_t *frequency;     /**< Seção FREQUENCY. */
+  const unsigned char *postings; /**< Seção POSTINGS. */
+  size_t postings_size;          /**< Tamanho de POSTINGS. */
+  const PostingByteSkip *skips;  /**< Seção SKIPS. */
+  size_t num_skips;              /**< Número de pontos em SKIPS. */
+  uint64_t total_length;         /**< Soma dos tamanhos das músicas. */
+  uint32_t num_songs;            /**< Número de músicas. */
+  uint32_t num_lines;            /**< Número total de versos. */
+  uint32_t num_words;            /**< Número de palavras distintas. */
+} Snapshot;
+
+/**
+ * @struct SnapshotWordText
+ * @brief Textos usados para exibir um registro salvo.
+ */
+typedef struct {
+  const char *word;   /**< A palavra. */
+  const char *title;  /**< Título da melhor música. */
+  const char *author; /**< Autor da melhor música. */
+  const char *verse;  /**< Verso da melhor ocorrência. */
+} SnapshotWordText;
+
+/**
+ * @brief Grava o índice de um repositório em um arquivo.
+ *
+ * O arquivo é escrito em "<path>.tmp" e renomeado ao final, de modo que um
+ * índice anterior com o mesmo nome só é substituído por um arquivo
+ * completo.
+ *
+ * @param path O caminho do arquivo.
+ * @param repo O repositório (catálogo e dicionário).
+ * @param sorted O array ordenado, já atualizado com update_search_structures.
+ * @param frequency_root A raiz da árvore de frequência, também atualizada.
+ * @return true se o arquivo foi gravado, false caso contrário.
+ */
+bool save_snapshot(const char *path, const Repository *repo,
+                   const WordArray *sorted, Node *frequency_root);
+
+/**
+ * @brief Mapeia um índice salvo e confere o cabeçalho e as seções.
+ *
+ * @param path O caminho do arquivo.
+ * @param verify Se verdadeiro, também confere a soma do corpo do arquivo
+ * (custo proporcional ao tamanho).
+ * @return O índice, ou NULL se o arquivo não puder ser lido ou for inválido
+ * (a causa é informada em stderr).
+ */
+Snapshot *load_snapshot(const char *path, bool verify);
+
+/**
+ * @brief Monta em memória, sem gravar arquivo, o índice que save_snapshot
+ * gravaria.
+ *
+ * A imagem fica somente leitura e não depende mais das estruturas de
+ * origem, que podem continuar sendo alteradas: é uma cópia imutável do
+ * índice naquele momento, liberada com free_snapshot.
+ *
+ * @param repo O repositório (catálogo e dicionário).
+ * @param sorted O array ordenado, já atualizado com update_search_structures.
+ * @param frequency_root A raiz da árvore de frequência, também atualizada.
+ * @return O índice, ou NULL se as estruturas estiverem desatualizadas.
+ */
+Snapshot *build_snapshot(const Repository *repo, const WordArray *sorted,
+                         Node *frequency_root);
+
+/**
+ * @brief Desfaz o mapeamento e libera o índice.
+ * @param snapshot O índice (pode ser NULL).
+ */
+void free_snapshot(Snapshot *snapshot);
+
+/**
+ * @brief Busca uma palavra no índice salvo (busca de Eytzinger).
+ *
+ * @param snapshot O índice.
+ * @param word A palavra.
+ * @return O registro, ou NULL se a palavra não estiver no índice.
+ */
+const SnapshotWord *snapshot_find_word(const Snapshot *snapshot,
+                                       const char *word);
+
+/**
+ * @brief Intervalo da seção WORDS (em ordem alfabética) com as palavras que
+ * começam com um prefixo, como prefix_range.
+ *
+ * @param snapshot O índice.
+ * @param prefix O prefixo.
+ * @param first Recebe a primeira posição do intervalo.
+ * @return O número de palavras com o prefixo.
+ */
+size_t snapshot_prefix_range(const Snapshot *snapshot, const char *prefix,
+                             size_t *first);
+
+/**
+ * @brief Posição, na ordem de frequência, da primeira palavra com contagem
+ * maior ou igual à informada.
+ *
+ * As palavras com contagem >= frequency são as das posições seguintes até
+ * num_words, em ordem crescente de (contagem, palavra).
+ *
+ * @param snapshot O índice.
+ * @param frequency A frequência mínima.
+ * @return A posição (num_words se não houver nenhuma).
+ */
+size_t snapshot_frequency_lower_bound(const Snapshot *snapshot,
+                                      unsigned int frequency);
+
+/**
+ * @brief Posição, na ordem de frequência, da primeira palavra com chave
+ * (contagem, palavra) maior que a informada.
+ *
+ * Usada para continuar uma paginação a partir do último resultado.
+ *
+ * @param snapshot O índice.
+ * @param count A contagem da chave.
+ * @param word A palavra da chave (não precisa estar no índice).
+ * @return A posição (num_words se não houver nenhuma).
+ */
+size_t snapshot_frequency_after(const Snapshot *snapshot, unsigned int count,
+                                const char *word);
+
+/**
+ * @brief Faixa de posições, na ordem de frequência, das palavras com
+ * contagem em [min_frequency, max_frequency], com duas buscas binárias.
+ *
+ * @param snapshot O índice.
+ * @param min_frequency A frequência mínima (inclusive).
+ * @param max_frequency A frequência máxima (inclusive).
+ * @param first Recebe a primeira posição da faixa.
+ * @return O número de palavras na faixa.
+ */
+size_t snapshot_frequency_range(const Snapshot *snapshot,
+                                unsigned int min_frequency,
+                                unsigned int max_frequency, size_t *first);
+
+/**
+ * @brief Retorna o registro em uma posição da ordem de frequência.
+ * @return O registro, ou NULL se o índice gravado for inválido.
+ */
+const SnapshotWord *snapshot_frequency_word(const Snapshot *snapshot,
+                                            size_t position);
+
+/**
+ * @brief Posição de um registro na ordem de frequência (busca binária por
+ * contagem e, nos empates, pela posição em WORDS).
+ *
+ * @param snapshot O índice.
+ * @param word Um registro de snapshot->words.
+ * @return A posição, ou num_words se o registro não estiver na ordem de
+ * frequência.
+ */
+size_t snapshot_frequency_position(const Snapshot *snapshot,
+                                   const SnapshotWord *word);
+
+/**
+ * @brief Decodifica as primeiras ocorrências de um registro.
+ *
+ * @param snapshot O índice.
+ * @param word O registro.
+ * @param postings Recebe as ocorrências (pelo menos max).
+ * @param max O número máximo de ocorrências.
+ * @return O número de ocorrências decodificadas (0 se a lista gravada
+ * estiver fora da seção).
+ */
+size_t snapshot_word_postings(const Snapshot *snapshot,
+                              const SnapshotWord *word, Posting *postings,
+                              size_t max);
+
+/**
+ * @brief Abre um cursor na lista de ocorrências de um registro.
+ *
+ * Uma lista fora da seção resulta em um cursor vazio, e pontos de salto
+ * fora da seção são ignorados.
+ *
+ * @param snapshot O índice.
+ * @param word O registro.
+ * @param cursor Recebe o cursor, válido até free_snapshot.
+ */
+void snapshot_word_cursor(const Snapshot *snapshot, const SnapshotWord *word,
+                          PostingCursor *cursor);
+
+/**
+ * @brief Retorna os textos de um registro: palavra, música e verso.
+ *
+ * Referências inválidas resultam em strings vazias.
+ */
+SnapshotWordText snapshot_word_text(const Snapshot *snapshot,
+                                    const SnapshotWord *word);
+
+/**
+ * @brief Retorna o título e o autor de uma música do índice salvo.
+ *
+ * @param snapshot O índice.
+ * @param song_id O identificador da música.
+ * @param title Recebe o título ("" se o identificador for inválido).
+ * @param author Recebe o autor (idem).
+ */
+void snapshot_song_text(const Snapshot *snapshot, unsigned int song_id,
+                        const char **title, const char **author);
+
+/**
+ * @brief Copia o índice salvo para um repositório e para as árvores globais.
+ *
+ * As músicas são acrescentadas ao catálogo e as palavras somadas ao
+ * dicionário, como em uma carga de arquivos, e indexadas na BST e na AVL em
+ * ordem de Eytzinger (o que mantém a BST balanceada). O chamador deve
+ * chamar update_search_structures em seguida.
+ *
+ * @param snapshot O índice.
+ * @param repo O repositório de destino.
+ * @return true se o índice foi copiado, false se contiver referências
+ * inválidas (nesse caso o repositório não é alterado).
+ */
+bool restore_snapshot(const Snapshot *snapshot, Repository *repo);
+
+#endif // SNAPSHOT_H
@@ -10,34 +10,77 @@
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 
+#include "arena.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * @struct SongOccurrence
  * @brief Armazena informações sobre a ocorrência de uma palavra em uma música.
+ *
+ * Título, autor e verso ficam no catálogo de músicas (Repository) e são
+ * referenciados pelo identificador da música e pelo índice do verso.
  */
 typedef struct SongOccurrence {
-  char *title;         /**< Título da música. */
-  char *author;        /**< Autor da música. */
-  char *verse_snippet; /**< Trecho do verso onde a palavra ocorre. */
+  unsigned int song_id;            /**< Identificador da música no catálogo. */
+  unsigned int verse_line;         /**< Índice do verso em Song::lyrics_lines. */
   unsigned int word_count_in_song; /**< Contagem da palavra na música. */
 } SongOccurrence;
 
+/**
+ * @struct WordEntry
+ * @brief Registro único de uma palavra do repositório.
+ *
+ * As árvores e o array ordenado apenas apontam para o registro, que fica no
+ * dicionário do repositório (Dictionary). A árvore de frequência é ordenada
+ * por indexed_count, a contagem do registro na última atualização da árvore
+ * (0 se o registro ainda não foi indexado nela). A lista de ocorrências da
+ * palavra fica fora do registro, no dicionário, na posição id, de modo que
+ * as buscas continuam lendo registros de 32 bytes.
+ */
+typedef struct WordEntry {
+  char *word;                          /**< A palavra. */
+  unsigned int total_word_count;       /**< Contagem total no repositório. */
+  SongOccurrence best_song_occurrence; /**< Melhor ocorrência da palavra. */
+  unsigned int indexed_count;          /**< Chave na árvore de frequência. */
+  unsigned int id;                     /**< Posição no dicionário. */
+} WordEntry;
+
 /**
  * @struct node
  * @brief Estrutura de um nó em uma árvore.
+ *
+ * O nó guarda uma cópia do prefixo e do comprimento da palavra (veja
+ * WordKey), de modo que a descida pela árvore só acessa o registro e a
+ * string quando os prefixos empatam. Na árvore de frequência, o nó também
+ * guarda o tamanho da sua subárvore, usado pelas consultas de posição.
  */
 typedef struct Node {
-  char *word; /**< A palavra armazenada no nó. */
-  unsigned int
-      total_word_count; /**< Contagem total da palavra no repositório. */
-  unsigned int height;  /**< Altura do nó (para árvores AVL). */
-  SongOccurrence *best_song_occurrence; /**< Melhor ocorrência da palavra. */
-  struct Node *left;                    /**< Ponteiro para o filho esquerdo. */
-  struct Node *right;                   /**< Ponteiro para o filho direito. */
+  WordEntry *entry;        /**< Registro da palavra indexada pelo nó. */
+  uint64_t key_prefix;     /**< word_prefix da palavra. */
+  unsigned int key_length; /**< Comprimento da palavra. */
+  unsigned int height;     /**< Altura do nó (para árvores AVL). */
+  unsigned int priority;   /**< Prioridade aleatória (para treaps). */
+  unsigned int size;       /**< Nós na subárvore (árvore de frequência). */
+  struct Node *left;       /**< Ponteiro para o filho esquerdo. */
+  struct Node *right;      /**< Ponteiro para o filho direito. */
 } Node;
 
+/**
+ * @struct WordKey
+ * @brief Chave de busca de uma palavra nas árvores ordenadas por palavra.
+ *
+ * É calculada uma vez por busca ou inserção com make_word_key e comparada
+ * com os nós por compare_word_key.
+ */
+typedef struct {
+  uint64_t prefix;     /**< word_prefix da palavra. */
+  unsigned int length; /**< Comprimento da palavra. */
+  const char *word;    /**< A palavra. */
+} WordKey;
+
 /**
  * @struct Tree
  * @brief Estrutura que representa uma árvore.
@@ -46,75 +89,141 @@ typedef struct {
   Node *root; /**< Ponteiro para o nó raiz da árvore. */
 } Tree;
 
+// Profundidade máxima de uma árvore AVL com até 2^32 nós (cerca de
+// 1,44 log2 n), usada nas pilhas dos percursos da árvore de frequência.
+#define FREQUENCY_STACK_DEPTH 64
+
+/**
+ * @struct FrequencyCursor
+ * @brief Posição de um percurso em ordem crescente de (contagem, palavra)
+ * da árvore de frequência.
+ *
+ * Guarda apenas os ancestrais ainda não visitados, de modo que a memória é
+ * constante qualquer que seja o número de resultados. O cursor é invalidado
+ * por qualquer alteração na árvore; para continuar depois de uma alteração,
+ * use a chave do último registro com frequency_cursor_start_after.
+ */
+typedef struct {
+  Node *stack[FREQUENCY_STACK_DEPTH]; /**< Próximos nós, o topo primeiro. */
+  int depth;                          /**< Nós na pilha. */
+  unsigned int max_frequency;         /**< Contagem máxima dos resultados. */
+} FrequencyCursor;
+
 /**
  * @struct WordArray
- * @brief Estrutura para um array dinâmico de ponteiros de nós.
+ * @brief Estrutura para um array dinâmico de ponteiros de registros.
  */
 typedef struct {
-  Node **nodes; /**< Array de ponteiros para nós. */
-  int size;     /**< Número de elementos no array. */
-  int capacity; /**< Capacidade atual do array. */
+  WordEntry **entries; /**< Array de ponteiros para registros. */
+  int size;            /**< Número de elementos no array. */
+  int capacity;        /**< Capacidade atual do array. */
 } WordArray;
 
+/**
+ * @struct EytzingerArray
+ * @brief Cópia congelada do array ordenado em ordem de Eytzinger.
+ *
+ * A posição k (a partir de 1) tem filhos nas posições 2k e 2k + 1, como em
+ * um heap, de modo que os primeiros níveis da busca ficam nas mesmas linhas
+ * de cache e os níveis seguintes podem ser pré-carregados. Cada posição
+ * guarda os 8 primeiros bytes da palavra (big-endian), e a maioria das
+ * comparações não precisa acessar o registro nem a string.
+ */
+typedef struct {
+  uint64_t *prefixes;  /**< Prefixos das palavras (posições 1 a size). */
+  WordEntry **entries; /**< Registros, na mesma ordem dos prefixos. */
+  size_t size;         /**< Número de palavras. */
+} EytzingerArray;
+
 // Variáveis globais
 extern Tree *bin_tree;
 extern Tree *avl_tree;
 extern WordArray *sorted_word_array;
 extern Tree *avl_frequency_tree;
+// Montado sob demanda a partir de sorted_word_array; NULL se desatualizado.
+extern EytzingerArray *eytzinger_array;
+// Se verdadeiro, bin_tree é mantida como treap (BST balanceada por
+// prioridades aleatórias). Deve ser definido antes da primeira inserção.
+extern bool bst_treap_mode;
 
 // Macros
 #define max(a, b) ((a) > (b) ? (a) : (b))
-#define initialize_tree(tree_name) (tree_name = (Tree *)malloc(sizeof(Tree)))
+#define initialize_tree(tree_name)                                             \
+  (tree_name = (Tree *)calloc(1, sizeof(Tree)))
 #define height_node(N) ((N) == NULL ? 0 : (N)->height)
+#define size_node(N) ((N) == NULL ? 0 : (N)->size)
 #define get_balance(N)                                                         \
   ((N) == NULL ? 0 : (height_node((N)->left) - height_node((N)->right)))
 
 /**
- * @brief Cria um novo nó para ser inserido na árvore.
+ * @brief Cria um novo nó para ser inserido em uma árvore.
  *
- * Aloca memória para um novo nó e inicializa seus campos.
- * A palavra é duplicada para evitar problemas de referência.
+ * Aloca o nó na arena informada. O nó aponta para o registro da palavra, que
+ * não é copiado.
  *
- * @param word A palavra a ser armazenada no novo nó.
+ * @param arena A arena onde o nó é alocado.
+ * @param entry O registro da palavra indexada pelo nó.
  * @return Um ponteiro para o nó recém-criado.
  */
-Node *create_node(const char *word);
+Node *create_node(Arena *arena, WordEntry *entry);
 
 /**
- * @brief Cria uma nova estrutura de ocorrência de música.
+ * @brief Indexa um registro na árvore de busca binária (BST) global.
  *
- * Aloca memória para uma nova ocorrência de música e preenche
- * com os detalhes da música onde uma palavra específica foi encontrada.
+ * Um nó é criado na arena e inserido na posição correta com base na ordem
+ * alfabética, com insert_node_bst ou, se bst_treap_mode estiver ativo, com
+ * insert_node_treap_recursive. Se a palavra já estiver indexada, nada é
+ * feito.
  *
- * @param title O título da música.
- * @param author O autor da música.
- * @param verse_snippet Um trecho do verso onde a palavra ocorre.
- * @param word_count_in_song O número de vezes que a palavra aparece na música.
- * @return Um ponteiro para a nova estrutura SongOccurrence.
+ * @param arena A arena onde o novo nó é alocado.
+ * @param entry O registro da palavra.
  */
-SongOccurrence *create_song_occurrence(const char *title, const char *author,
-                                       const char *verse_snippet,
-                                       unsigned int word_count_in_song);
+void insert_word(Arena *arena, WordEntry *entry);
+
 /**
- * @brief Insere um novo nó em uma árvore de busca binária (BST).
+ * @brief Insere um nó em uma BST sem balanceamento (iterativamente).
  *
- * Se a árvore estiver vazia, o novo nó se torna a raiz. Caso contrário,
- * ele é inserido recursivamente na posição correta com base na ordem
- * alfabética.
+ * Não usa recursão, de modo que uma árvore degenerada (palavras inseridas em
+ * ordem alfabética) não esgota a pilha.
  *
- * @param new_node O nó a ser inserido.
+ * @param root Endereço da raiz da árvore.
+ * @param new_node O novo nó a ser inserido.
  */
-void insert_node(Node *new_node);
+void insert_node_bst(Node **root, Node *new_node);
 
 /**
- * @brief Insere um novo nó em uma árvore AVL.
+ * @brief Insere um nó em uma treap (recursivamente).
+ *
+ * O nó desce como em uma BST e sobe por rotações enquanto sua prioridade
+ * for maior que a do pai, o que mantém a profundidade esperada em
+ * O(log n) independentemente da ordem de inserção.
  *
- * Insere o nó e depois realiza as rotações necessárias para
+ * @param current O nó atual na recursão.
+ * @param new_node O novo nó, com a prioridade já sorteada.
+ * @return A nova raiz da subárvore.
+ */
+Node *insert_node_treap_recursive(Node *current, Node *new_node);
+
+/**
+ * @brief Indexa um registro na árvore AVL global.
+ *
+ * Igual a insert_word, mas realiza as rotações necessárias para
  * manter a propriedade de balanceamento da árvore AVL.
  *
- * @param new_node O nó a ser inserido.
+ * @param arena A arena onde o novo nó é alocado.
+ * @param entry O registro da palavra.
+ */
+void insert_word_avl(Arena *arena, WordEntry *entry);
+
+/**
+ * @brief Insere um nó em uma árvore AVL ordenada pela palavra
+ * (recursivamente).
+ *
+ * @param current O nó atual na recursão.
+ * @param new_node O novo nó a ser inserido.
+ * @return A nova raiz da subárvore.
  */
-void insert_node_avl(Node *new_node);
+Node *insert_node_avl_recursive(Node *current, Node *new_node);
 
 /**
  * @brief Executa uma rotação para a esquerda no nó fornecido.
@@ -141,56 +250,50 @@ Node *right_rotate(Node *y);
 /**
  * @brief Busca por uma palavra em uma árvore de busca binária (BST).
  *
+ * A busca é iterativa e serve tanto para a BST simples quanto para a treap.
+ *
  * @param root A raiz da árvore onde a busca será realizada.
  * @param word A palavra a ser procurada.
- * @return Um ponteiro para o nó encontrado, ou NULL se a palavra não for
- * encontrada.
+ * @return Um ponteiro para o registro encontrado, ou NULL se a palavra não
+ * for encontrada.
  */
-Node *search_bst(Node *root, const char *word);
+WordEntry *search_bst(Node *root, const char *word);
 
 /**
  * @brief Busca por uma palavra em uma árvore AVL.
  *
  * @param root A raiz da árvore AVL onde a busca será realizada.
  * @param word A palavra a ser procurada.
- * @return Um ponteiro para o nó encontrado, ou NULL se a palavra não for
- * encontrada.
- */
-Node *search_avl(Node *root, const char *word);
-
-/**
- * @brief Libera toda a memória alocada por uma árvore.
- *
- * Percorre a árvore em pós-ordem para liberar todos os nós,
- * incluindo as ocorrências de músicas e as palavras.
- *
- * @param node A raiz da árvore a ser liberada.
+ * @return Um ponteiro para o registro encontrado, ou NULL se a palavra não
+ * for encontrada.
  */
-void free_tree(Node *node);
+WordEntry *search_avl(Node *root, const char *word);
 
 /**
  * @brief Cria e inicializa um array de palavras (WordArray).
  *
- * Aloca memória para a estrutura WordArray e seu array interno de nós.
+ * Aloca memória para a estrutura WordArray e seu array interno de
+ * registros.
  *
  * @return Um ponteiro para o novo WordArray.
  */
 WordArray *create_word_array();
 
 /**
- * @brief Adiciona um nó a um WordArray.
+ * @brief Adiciona um registro a um WordArray.
  *
- * Se necessário, redimensiona o array para acomodar mais nós.
+ * Se necessário, redimensiona o array para acomodar mais registros.
  *
- * @param arr O WordArray ao qual o nó será adicionado.
- * @param node O nó a ser adicionado.
+ * @param arr O WordArray ao qual o registro será adicionado.
+ * @param entry O registro a ser adicionado.
  */
-void add_node_to_array(WordArray *arr, Node *node);
+void add_entry_to_array(WordArray *arr, WordEntry *entry);
 
 /**
  * @brief Ordena um WordArray em ordem alfabética.
  *
- * Utiliza a função qsort para ordenar o array de nós com base na palavra.
+ * Utiliza a função qsort para ordenar o array de registros com base na
+ * palavra.
  *
  * @param arr O WordArray a ser ordenado.
  */
@@ -201,42 +304,113 @@ void sort_word_array(WordArray *arr);
  *
  * @param arr O WordArray (que deve estar ordenado).
  * @param word A palavra a ser procurada.
- * @return Um ponteiro para o nó encontrado, ou NULL se não for encontrado.
+ * @return Um ponteiro para o registro encontrado, ou NULL se não for
+ * encontrado.
+ */
+WordEntry *binary_search_array(WordArray *arr, const char *word);
+
+/**
+ * @brief Intercala registros novos em um WordArray ordenado.
+ *
+ * Os acréscimos são ordenados e intercalados a partir do final do array, sem
+ * reordenar os registros existentes.
+ *
+ * @param arr O WordArray ordenado.
+ * @param additions Os registros a acrescentar (ordenados no lugar).
  */
-Node *binary_search_array(WordArray *arr, const char *word);
+void merge_into_word_array(WordArray *arr, WordArray *additions);
 
 /**
  * @brief Libera a memória alocada por um WordArray.
  *
- * Libera o array de nós e a própria estrutura WordArray.
+ * Libera o array de ponteiros e a própria estrutura WordArray. Os registros
+ * pertencem ao dicionário e não são liberados.
  *
  * @param arr O WordArray a ser liberado.
  */
 void free_word_array(WordArray *arr);
 
 /**
- * @brief Preenche um WordArray com os nós de uma árvore.
+ * @brief Calcula o prefixo de comparação de uma palavra.
  *
- * Percorre a árvore em-ordem e adiciona cada nó ao array.
+ * Os até 8 primeiros bytes da palavra, em big-endian e completados com
+ * zeros, de modo que a ordem dos prefixos como inteiros é a ordem de strcmp
+ * e prefixos diferentes decidem a comparação.
  *
- * @param node A raiz da árvore.
- * @param arr O WordArray a ser preenchido.
+ * @param word A palavra.
+ * @return O prefixo.
  */
-void populate_array_from_tree(Node *node, WordArray *arr);
+uint64_t word_prefix(const char *word);
+
+/**
+ * @brief Monta a chave de busca de uma palavra.
+ *
+ * @param word A palavra.
+ * @return A chave, que aponta para a palavra sem copiá-la.
+ */
+WordKey make_word_key(const char *word);
+
+/**
+ * @brief Compara uma chave com a palavra de um nó, na ordem de strcmp.
+ *
+ * Prefixos diferentes decidem a comparação. Com prefixos iguais, se uma das
+ * palavras tem até 8 bytes ela é prefixo da outra, e o comprimento decide.
+ * Só quando as duas são mais longas a string do nó é acessada.
+ *
+ * @param key A chave.
+ * @param node O nó.
+ * @return Negativo, zero ou positivo, como strcmp(key->word, palavra do nó).
+ */
+static inline int compare_word_key(const WordKey *key, const Node *node) {
+  if (key->prefix != node->key_prefix)
+    return key->prefix < node->key_prefix ? -1 : 1;
+  if (key->length <= 8 || node->key_length <= 8)
+    return (key->length > node->key_length) - (key->length < node->key_length);
+  return strcmp(key->word + 8, node->entry->word + 8);
+}
+
+/**
+ * @brief Monta a cópia em ordem de Eytzinger de um array ordenado.
+ * @param arr O WordArray ordenado.
+ * @return Um ponteiro para o novo EytzingerArray.
+ */
+EytzingerArray *build_eytzinger_array(const WordArray *arr);
+
+/**
+ * @brief Busca por uma palavra em um EytzingerArray.
+ *
+ * A descida não tem desvios dependentes da comparação e pré-carrega os
+ * prefixos três níveis abaixo.
+ *
+ * @param layout O EytzingerArray.
+ * @param word A palavra a ser procurada.
+ * @return Um ponteiro para o registro encontrado, ou NULL se não for
+ * encontrado.
+ */
+WordEntry *search_eytzinger(const EytzingerArray *layout, const char *word);
+
+/**
+ * @brief Libera a memória alocada por um EytzingerArray.
+ * @param layout O EytzingerArray a ser liberado (pode ser NULL).
+ */
+void free_eytzinger_array(EytzingerArray *layout);
 
 /**
- * @brief Libera a memória de uma árvore AVL de frequência.
+ * @brief Preenche um WordArray com os registros de uma árvore.
  *
- * Percorre a árvore em pós-ordem e libera todos os nós e seus conteúdos.
+ * Percorre a árvore em-ordem, com uma pilha explícita em vez de recursão, e
+ * adiciona o registro de cada nó ao array.
  *
- * @param node A raiz da árvore de frequência.
+ * @param node A raiz da árvore.
+ * @param arr O WordArray a ser preenchido.
  */
-void free_frequency_tree(Node *node);
+void populate_array_from_tree(Node *node, WordArray *arr);
 
 /**
  * @brief Insere um nó em uma árvore AVL de frequência (recursivamente).
  *
- * A inserção é baseada na contagem total de palavras (frequência).
+ * A inserção é baseada na contagem indexada do registro (indexed_count) e,
+ * em caso de empate, na palavra.
  *
  * @param current O nó atual na recursão.
  * @param new_node O novo nó a ser inserido.
@@ -244,23 +418,50 @@ void free_frequency_tree(Node *node);
  */
 Node *insert_node_avl_frequency_recursive(Node *current, Node *new_node);
 
+/**
+ * @brief Remove um nó de uma árvore AVL de frequência (recursivamente).
+ *
+ * @param current O nó atual na recursão.
+ * @param count A contagem com que o registro foi indexado.
+ * @param word A palavra do registro.
+ * @param removed Recebe o nó removido (inalterado se a chave não existir).
+ * @return A nova raiz da subárvore.
+ */
+Node *remove_node_avl_frequency_recursive(Node *current, unsigned int count,
+                                          const char *word, Node **removed);
+
+/**
+ * @brief Atualiza a posição de um registro na árvore AVL de frequência
+ * global.
+ *
+ * Se o registro já estiver indexado, seu nó é removido da posição antiga e
+ * reinserido com a contagem atual; caso contrário, um nó é criado na arena.
+ *
+ * @param arena A arena onde um eventual novo nó é alocado.
+ * @param entry O registro cuja contagem mudou.
+ */
+void reindex_frequency_entry(Arena *arena, WordEntry *entry);
+
 /**
  * @brief Busca por uma frequência específica na árvore AVL de frequência.
  *
  * @param root A raiz da árvore de frequência.
  * @param frequency A frequência a ser buscada.
- * @return Um ponteiro para um nó com a frequência correspondente, ou NULL.
+ * @return Um ponteiro para um registro com a frequência correspondente, ou
+ * NULL.
  */
-Node *search_avl_frequency(Node *root, unsigned int frequency);
+WordEntry *search_avl_frequency(Node *root, unsigned int frequency);
 
 /**
  * @brief Preenche a árvore AVL de frequência a partir de outra árvore.
  *
- * Percorre a árvore principal e insere nós na árvore de frequência.
+ * Percorre a árvore principal e insere na árvore de frequência um nó para
+ * cada registro, sem copiá-lo.
  *
+ * @param arena A arena onde os nós de frequência são alocados.
  * @param node A raiz da árvore principal.
  */
-void populate_frequency_avl_tree(Node *node);
+void populate_frequency_avl_tree(Arena *arena, Node *node);
 
 /**
  * @brief Busca todas as palavras com uma frequência mínima.
@@ -270,7 +471,100 @@ void populate_frequency_avl_tree(Node *node);
  *
  * @param root A raiz da árvore de frequência.
  * @param frequency A frequência mínima desejada.
- * @return Um WordArray contendo os nós que correspondem ao critério.
+ * @return Um WordArray contendo os registros que correspondem ao critério.
  */
 WordArray *search_all_by_frequency(Node *root, unsigned int frequency);
+
+/**
+ * @brief Conta as palavras com frequência em uma faixa, sem listá-las.
+ *
+ * Usa os tamanhos das subárvores da árvore de frequência: custa O(log n)
+ * qualquer que seja o número de palavras na faixa.
+ *
+ * @param root A raiz da árvore de frequência.
+ * @param min_frequency A frequência mínima (inclusive).
+ * @param max_frequency A frequência máxima (inclusive).
+ * @return O número de palavras (0 se min_frequency > max_frequency).
+ */
+size_t count_frequency_range(Node *root, unsigned int min_frequency,
+                             unsigned int max_frequency);
+
+/**
+ * @brief Busca as palavras mais frequentes.
+ *
+ * Percorre a árvore de frequência em ordem decrescente a partir do maior
+ * nó e para após k registros, com custo O(log n + k) independentemente do
+ * tamanho do vocabulário.
+ *
+ * @param root A raiz da árvore de frequência.
+ * @param k O número máximo de palavras.
+ * @return Um WordArray com até k registros, do mais frequente para o menos
+ * frequente (empates em ordem alfabética inversa).
+ */
+WordArray *search_top_frequency(Node *root, size_t k);
+
+/**
+ * @brief Retorna o registro em uma posição da árvore de frequência.
+ *
+ * As posições seguem a ordem crescente de (contagem, palavra), a mesma de
+ * populate_array_from_tree, e são encontradas pelos tamanhos das
+ * subárvores em O(log n).
+ *
+ * @param root A raiz da árvore de frequência.
+ * @param position A posição, a partir de 0.
+ * @return O registro, ou NULL se a posição não existir.
+ */
+WordEntry *select_frequency(Node *root, size_t position);
+
+/**
+ * @brief Conta os registros da árvore de frequência com chave menor que a
+ * de um registro.
+ *
+ * Para um registro indexado, é a sua posição na ordem de select_frequency.
+ *
+ * @param root A raiz da árvore de frequência.
+ * @param entry O registro, comparado por (indexed_count, palavra).
+ * @return O número de registros menores, em O(log n).
+ */
+size_t rank_frequency(Node *root, const WordEntry *entry);
+
+/**
+ * @brief Posiciona um cursor na primeira palavra com frequência mínima.
+ *
+ * @param cursor O cursor.
+ * @param root A raiz da árvore de frequência.
+ * @param min_frequency A frequência mínima (inclusive).
+ * @param max_frequency A frequência máxima (inclusive) dos resultados.
+ */
+void frequency_cursor_start(FrequencyCursor *cursor, Node *root,
+                            unsigned int min_frequency,
+                            unsigned int max_frequency);
+
+/**
+ * @brief Posiciona um cursor logo após uma chave (contagem, palavra).
+ *
+ * A chave é a do último registro de uma página anterior e não precisa
+ * estar na árvore, de modo que a paginação continua correta depois de
+ * novas cargas.
+ *
+ * @param cursor O cursor.
+ * @param root A raiz da árvore de frequência.
+ * @param count A contagem da chave.
+ * @param word A palavra da chave.
+ * @param max_frequency A frequência máxima (inclusive) dos resultados.
+ */
+void frequency_cursor_start_after(FrequencyCursor *cursor, Node *root,
+                                  unsigned int count, const char *word,
+                                  unsigned int max_frequency);
+
+/**
+ * @brief Avança o cursor.
+ *
+ * Cada chamada custa O(1) amortizado, e a primeira, O(log n) após o
+ * posicionamento.
+ *
+ * @param cursor O cursor.
+ * @return O próximo registro, ou NULL ao fim da árvore ou da faixa.
+ */
+WordEntry *frequency_cursor_next(FrequencyCursor *cursor);
 #endif // TREE_H
@@ -0,0 +1,72 @@
+/**
+ * @file tokenize.h
+ * @brief Separação e normalização dos tokens de uma linha.
+ *
+ * Os tokens são separados por espaço, tabulação, '\n' e '\r' (os mesmos
+ * delimitadores do strtok original) e normalizados como remove_punctuation
+ * seguido de to_lowercase: apenas os bytes alfanuméricos ASCII são mantidos,
+ * e as letras maiúsculas viram minúsculas.
+ *
+ * Há uma implementação escalar e, em x86, implementações SSE2 (16 bytes por
+ * passo) e AVX2 (32 bytes por passo), escolhidas em tempo de execução.
+ */
+
+#ifndef TOKENIZE_H
+#define TOKENIZE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Bytes extras que o destino de tokenize_line deve ter além da linha. */
+#define TOKENIZE_PADDING 64
+
+/**
+ * @struct TokenSpan
+ * @brief Posição de um token normalizado no destino de tokenize_line.
+ */
+typedef struct {
+  uint32_t offset; /**< Início do token no destino. */
+  uint32_t length; /**< Comprimento do token normalizado (pode ser 0). */
+} TokenSpan;
+
+/**
+ * @brief Função que separa e normaliza os tokens de uma linha.
+ *
+ * @param line Início da linha (não precisa terminar em '\0').
+ * @param length Comprimento da linha.
+ * @param out Destino com pelo menos length + TOKENIZE_PADDING bytes. Cada
+ * token normalizado começa na mesma posição do token na linha.
+ * @param tokens Recebe os tokens (no máximo length / 2 + 1).
+ * @return O número de tokens.
+ */
+typedef size_t (*TokenizeFunction)(const char *line, size_t length, char *out,
+                                   TokenSpan *tokens);
+
+/**
+ * @struct TokenizerKernel
+ * @brief Uma implementação do tokenizador.
+ */
+typedef struct {
+  const char *name;          /**< Nome da implementação. */
+  TokenizeFunction tokenize; /**< A função. */
+  bool (*supported)(void);   /**< Indica se o processador a suporta. */
+} TokenizerKernel;
+
+/** Implementações disponíveis, da mais simples para a mais rápida. */
+extern const TokenizerKernel tokenizer_kernels[];
+
+/** Número de elementos de tokenizer_kernels. */
+extern const size_t num_tokenizer_kernels;
+
+/**
+ * @brief Separa e normaliza os tokens de uma linha com a implementação mais
+ * rápida suportada pelo processador.
+ *
+ * A escolha é feita na primeira chamada. Os parâmetros são os de
+ * TokenizeFunction.
+ */
+size_t tokenize_line(const char *line, size_t length, char *out,
+                     TokenSpan *tokens);
+
+#endif // TOKENIZE_H
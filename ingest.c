@@ -0,0 +1,235 @@
+/**
+ * @file ingest.c
+ * @brief Implementação da carga paralela de diretórios de músicas.
+ *
+ * Cada thread processa uma faixa contígua dos arquivos (ordenados por nome)
+ * em um repositório privado (catálogo de músicas e dicionário), sem nenhuma
+ * sincronização durante a leitura. Os repositórios privados são então
+ * mesclados, na ordem das faixas, no catálogo, na BST e na AVL globais.
+ */
+
+#include "include/ingest.h"
+#include "include/repository.h"
+#include "include/structures.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @struct MusicFile
+ * @brief Arquivo de música a ser carregado.
+ */
+typedef struct {
+  char *path; /**< Caminho completo do arquivo. */
+  off_t size; /**< Tamanho do arquivo em bytes. */
+} MusicFile;
+
+/**
+ * @struct IngestWorker
+ * @brief Estado de uma thread de carga.
+ */
+typedef struct {
+  MusicFile *files; /**< Primeiro arquivo da faixa da thread. */
+  size_t num_files; /**< Número de arquivos na faixa. */
+  Repository *repo; /**< Catálogo e dicionário privados da thread. */
+  pthread_t thread; /**< Identificador da thread. */
+} IngestWorker;
+
+static int compare_music_files(const void *a, const void *b) {
+  const MusicFile *file_a = (const MusicFile *)a;
+  const MusicFile *file_b = (const MusicFile *)b;
+  return strcmp(file_a->path, file_b->path);
+}
+
+/**
+ * @brief Lista os arquivos regulares (não ocultos) de um diretório.
+ * @param dirpath O caminho para o diretório.
+ * @param num_files Recebe o número de arquivos encontrados.
+ * @return Array de arquivos ordenado por nome, ou NULL em caso de erro.
+ */
+static MusicFile *list_music_files(const char *dirpath, size_t *num_files) {
+  DIR *dir = opendir(dirpath);
+  if (dir == NULL) {
+    perror("Erro ao abrir o diretório");
+    return NULL;
+  }
+
+  size_t count = 0, capacity = 64;
+  MusicFile *files = (MusicFile *)malloc(capacity * sizeof(MusicFile));
+  if (files == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a lista de arquivos.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+
+    size_t path_length = strlen(dirpath) + strlen(entry->d_name) + 2;
+    char *path = (char *)malloc(path_length);
+    if (path == NULL) {
+      fprintf(stderr, "Falha na alocação de memória para o caminho.\n");
+      exit(EXIT_FAILURE);
+    }
+    snprintf(path, path_length, "%s/%s", dirpath, entry->d_name);
+
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+      free(path);
+      continue;
+    }
+
+    if (count == capacity) {
+      capacity *= 2;
+      files = (MusicFile *)realloc(files, capacity * sizeof(MusicFile));
+      if (files == NULL) {
+        fprintf(stderr, "Falha no realloc da lista de arquivos.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    files[count].path = path;
+    files[count].size = info.st_size;
+    count++;
+  }
+  closedir(dir);
+
+  qsort(files, count, sizeof(MusicFile), compare_music_files);
+  *num_files = count;
+  return files;
+}
+
+static void *ingest_worker_run(void *arg) {
+  IngestWorker *worker = (IngestWorker *)arg;
+  for (size_t i = 0; i < worker->num_files; i++) {
+    process_music_file_into_repository(worker->files[i].path, worker->repo);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Soma os registros de um dicionário privado ao dicionário global.
+ *
+ * Os registros são percorridos na ordem de criação, de modo que as palavras
+ * novas chegam às árvores globais na mesma ordem da carga serial. Apenas as
+ * palavras novas ganham nós na BST e na AVL. As listas de ocorrências são
+ * recodificadas no final das globais: as músicas da thread vêm depois de
+ * todas as do catálogo global, de modo que a ordem crescente se mantém.
+ *
+ * @param dictionary O dicionário privado.
+ * @param song_offset Deslocamento dos identificadores de música da thread no
+ * catálogo global.
+ */
+static void merge_private_dictionary(const Dictionary *dictionary,
+                                     unsigned int song_offset) {
+  for (size_t i = 0; i < dictionary->size; i++) {
+    const WordEntry *private_entry = dictionary->entries[i];
+    SongOccurrence occurrence = private_entry->best_song_occurrence;
+    occurrence.song_id += song_offset;
+
+    bool created;
+    WordEntry *entry = add_word_occurrence(
+        &song_repository->dictionary, private_entry->word,
+        private_entry->total_word_count, &occurrence, &created);
+    append_postings(word_postings(&song_repository->dictionary, entry),
+                    &song_repository->dictionary.posting_blocks,
+                    word_postings(dictionary, private_entry), song_offset);
+    if (created) {
+      insert_word(&song_repository->nodes, entry);
+      insert_word_avl(&song_repository->nodes, entry);
+    }
+  }
+}
+
+int process_music_directory(const char *dirpath, int num_threads) {
+  size_t num_files;
+  MusicFile *files = list_music_files(dirpath, &num_files);
+  if (files == NULL) {
+    return -1;
+  }
+
+  if (num_threads <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = cores > 0 ? (int)cores : 1;
+  }
+  if ((size_t)num_threads > num_files) {
+    num_threads = num_files > 0 ? (int)num_files : 1;
+  }
+
+  IngestWorker *workers =
+      (IngestWorker *)calloc(num_threads, sizeof(IngestWorker));
+  if (workers == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para as threads.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Divide os arquivos em faixas contíguas com aproximadamente o mesmo
+  // número de bytes. Manter a ordem dos arquivos dentro e entre as faixas
+  // garante que a mesclagem reproduza a carga serial.
+  off_t total_bytes = 0;
+  for (size_t i = 0; i < num_files; i++) {
+    total_bytes += files[i].size;
+  }
+  size_t next_file = 0;
+  off_t assigned_bytes = 0;
+  for (int t = 0; t < num_threads; t++) {
+    off_t target = total_bytes / num_threads * (t + 1);
+    workers[t].files = files + next_file;
+    while (next_file < num_files &&
+           (t == num_threads - 1 || assigned_bytes < target ||
+            workers[t].num_files == 0)) {
+      assigned_bytes += files[next_file].size;
+      workers[t].num_files++;
+      next_file++;
+    }
+  }
+
+  for (int t = 0; t < num_threads; t++) {
+    workers[t].repo = create_repository();
+    if (pthread_create(&workers[t].thread, NULL, ingest_worker_run,
+                       &workers[t]) != 0) {
+      fprintf(stderr, "Falha ao criar a thread de carga.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (int t = 0; t < num_threads; t++) {
+    pthread_join(workers[t].thread, NULL);
+  }
+
+  if (bin_tree == NULL)
+    initialize_tree(bin_tree);
+  if (avl_tree == NULL)
+    initialize_tree(avl_tree);
+  if (song_repository == NULL)
+    song_repository = create_repository();
+  for (int t = 0; t < num_threads; t++) {
+    unsigned int song_offset = move_songs(song_repository, workers[t].repo);
+    merge_private_dictionary(&workers[t].repo->dictionary, song_offset);
+    free_repository(workers[t].repo);
+  }
+
+  for (size_t i = 0; i < num_files; i++) {
+    free(files[i].path);
+  }
+  free(files);
+  free(workers);
+  return (int)num_files;
+}
+
+bool load_music_path(const char *path) {
+  struct stat info;
+  if (stat(path, &info) != 0) {
+    perror(path);
+    return false;
+  }
+  if (S_ISDIR(info.st_mode)) {
+    return process_music_directory(path, 0) >= 0;
+  }
+  process_music_file_for_word_count(path, NULL, NULL);
+  return true;
+}
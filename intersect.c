@@ -0,0 +1,432 @@
+/**
+ * @file intersect.c
+ * @brief Interseção das listas de ocorrências (escalar, SSE2, AVX2 e busca
+ * exponencial) e consultas com várias palavras.
+ */
+
+#include "include/intersect.h"
+#include "include/tokenize.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INTERSECT_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Interseção por intercalação, sem desvios que dependam dos dados.
+ */
+static size_t intersect_scalar(const uint32_t *a, size_t a_size,
+                               const uint32_t *b, size_t b_size,
+                               uint32_t *out) {
+  size_t i = 0, j = 0, k = 0;
+  while (i < a_size && j < b_size) {
+    uint32_t x = a[i], y = b[j];
+    out[k] = x;
+    k += x == y;
+    i += x <= y;
+    j += y <= x;
+  }
+  return k;
+}
+
+static bool always_supported(void) { return true; }
+
+#ifdef INTERSECT_X86
+
+// Cada passo compara um bloco de a com todas as rotações de um bloco de b:
+// os bits da máscara indicam os valores do bloco de a presentes no de b. O
+// bloco cujo último valor é menor (ou os dois, se iguais) é descartado.
+
+__attribute__((target("sse2"))) static size_t
+intersect_sse2(const uint32_t *a, size_t a_size, const uint32_t *b,
+               size_t b_size, uint32_t *out) {
+  size_t i = 0, j = 0, k = 0;
+  while (i + 4 <= a_size && j + 4 <= b_size) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+    __m128i rotated1 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+    __m128i rotated2 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i rotated3 = _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3));
+    __m128i match =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                                  _mm_cmpeq_epi32(va, rotated1)),
+                     _mm_or_si128(_mm_cmpeq_epi32(va, rotated2),
+                                  _mm_cmpeq_epi32(va, rotated3)));
+    unsigned int mask =
+        (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(match));
+    while (mask != 0) {
+      out[k++] = a[i + __builtin_ctz(mask)];
+      mask &= mask - 1;
+    }
+    uint32_t a_last = a[i + 3], b_last = b[j + 3];
+    i += a_last <= b_last ? 4 : 0;
+    j += b_last <= a_last ? 4 : 0;
+  }
+  return k + intersect_scalar(a + i, a_size - i, b + j, b_size - j, out + k);
+}
+
+/**
+ * @brief Compara va com as quatro rotações, dentro de cada metade de 128
+ * bits, de um bloco de b.
+ */
+__attribute__((target("avx2"))) static inline __m256i
+match_lane_rotations(__m256i va, __m256i vb) {
+  __m256i rotated1 = _mm256_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+  __m256i rotated2 = _mm256_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2));
+  __m256i rotated3 = _mm256_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3));
+  return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(va, vb),
+                                         _mm256_cmpeq_epi32(va, rotated1)),
+                         _mm256_or_si256(_mm256_cmpeq_epi32(va, rotated2),
+                                         _mm256_cmpeq_epi32(va, rotated3)));
+}
+
+__attribute__((target("avx2"))) static size_t
+intersect_avx2(const uint32_t *a, size_t a_size, const uint32_t *b,
+               size_t b_size, uint32_t *out) {
+  size_t i = 0, j = 0, k = 0;
+  while (i + 8 <= a_size && j + 8 <= b_size) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+    // As rotações de cada metade e das metades trocadas cobrem os 8
+    // valores de b.
+    __m256i match = _mm256_or_si256(
+        match_lane_rotations(va, vb),
+        match_lane_rotations(va, _mm256_permute2x128_si256(vb, vb, 1)));
+    unsigned int mask =
+        (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(match));
+    while (mask != 0) {
+      out[k++] = a[i + __builtin_ctz(mask)];
+      mask &= mask - 1;
+    }
+    uint32_t a_last = a[i + 7], b_last = b[j + 7];
+    i += a_last <= b_last ? 8 : 0;
+    j += b_last <= a_last ? 8 : 0;
+  }
+  return k + intersect_scalar(a + i, a_size - i, b + j, b_size - j, out + k);
+}
+
+static bool sse2_supported(void) { return __builtin_cpu_supports("sse2"); }
+
+static bool avx2_supported(void) { return __builtin_cpu_supports("avx2"); }
+
+#endif // INTERSECT_X86
+
+const IntersectKernel intersect_kernels[] = {
+    {"escalar", intersect_scalar, always_supported},
+#ifdef INTERSECT_X86
+    {"sse2", intersect_sse2, sse2_supported},
+    {"avx2", intersect_avx2, avx2_supported},
+#endif
+};
+
+const size_t num_intersect_kernels =
+    sizeof(intersect_kernels) / sizeof(intersect_kernels[0]);
+
+size_t intersect_galloping(const uint32_t *a, size_t a_size,
+                           const uint32_t *b, size_t b_size, uint32_t *out) {
+  size_t k = 0, low = 0;
+  for (size_t i = 0; i < a_size && low < b_size; i++) {
+    uint32_t target = a[i];
+    // Passos crescentes a partir do último encontrado até passar do valor,
+    // e busca binária no último passo.
+    size_t step = 1, high = low;
+    while (high < b_size && b[high] < target) {
+      low = high + 1;
+      high += step;
+      step *= 2;
+    }
+    if (high > b_size)
+      high = b_size;
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (b[mid] < target)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    if (low < b_size && b[low] == target)
+      out[k++] = target;
+  }
+  return k;
+}
+
+// Implementação escolhida na primeira chamada, como em tokenize_line.
+static IntersectFunction selected_intersect = NULL;
+
+size_t intersect_sorted(const uint32_t *a, size_t a_size, const uint32_t *b,
+                        size_t b_size, uint32_t *out) {
+  if (a_size > b_size) {
+    const uint32_t *array = a;
+    a = b;
+    b = array;
+    size_t size = a_size;
+    a_size = b_size;
+    b_size = size;
+  }
+  if (b_size / INTERSECT_GALLOP_RATIO >= a_size)
+    return intersect_galloping(a, a_size, b, b_size, out);
+
+  IntersectFunction intersect =
+      __atomic_load_n(&selected_intersect, __ATOMIC_RELAXED);
+  if (intersect == NULL) {
+    for (size_t i = num_intersect_kernels; i-- > 0;) {
+      if (intersect_kernels[i].supported()) {
+        intersect = intersect_kernels[i].intersect;
+        break;
+      }
+    }
+    __atomic_store_n(&selected_intersect, intersect, __ATOMIC_RELAXED);
+  }
+  return intersect(a, a_size, b, b_size, out);
+}
+
+static void *allocate_or_exit(size_t size) {
+  void *memory = malloc(size > 0 ? size : 1);
+  if (memory == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a consulta.\n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+/**
+ * @brief Limite para o número de ocorrências de um cursor: o informado pela
+ * lista e, em uma lista contígua, o que cabe nos seus bytes (cada
+ * ocorrência ocupa pelo menos 3).
+ */
+static size_t cursor_capacity(const PostingCursor *cursor) {
+  size_t capacity = cursor->num_songs;
+  if (cursor->list == NULL) {
+    size_t fit = (size_t)(cursor->end - cursor->next) / 3;
+    if (fit < capacity)
+      capacity = fit;
+  }
+  return capacity;
+}
+
+/**
+ * @brief Decodifica os identificadores de um cursor, parando se a lista
+ * deixar de ser estritamente crescente (apenas se estiver corrompida).
+ */
+static size_t decode_song_ids(PostingCursor *cursor, uint32_t *out,
+                              size_t max) {
+  size_t n = 0;
+  while (n < max && posting_cursor_next(cursor)) {
+    if (n > 0 && cursor->song_id <= out[n - 1])
+      break;
+    out[n++] = cursor->song_id;
+  }
+  return n;
+}
+
+/**
+ * @brief Mantém em starts apenas os inícios de frase que também são uma
+ * posição da palavra menos offset.
+ * @return O número de inícios mantidos.
+ */
+static size_t keep_phrase_starts(uint32_t *starts, size_t num_starts,
+                                 const uint32_t *positions,
+                                 size_t num_positions, unsigned int offset) {
+  size_t i = 0, j = 0, kept = 0;
+  while (i < num_starts && j < num_positions) {
+    if (positions[j] < offset || positions[j] - offset < starts[i]) {
+      j++;
+    } else if (positions[j] - offset > starts[i]) {
+      i++;
+    } else {
+      starts[kept++] = starts[i++];
+      j++;
+    }
+  }
+  return kept;
+}
+
+/**
+ * @brief Confere pelas posições quais candidatas contêm a frase.
+ *
+ * @param terms As palavras, com os cursores no início das listas.
+ * @param order As palavras em ordem crescente de número de músicas.
+ * @return O número de candidatas mantidas (no início de candidates).
+ */
+static size_t filter_phrases(QueryTerm *terms, const size_t *order,
+                             size_t num_terms, uint32_t *candidates,
+                             size_t num_candidates) {
+  size_t starts_capacity = 0, positions_capacity = 0;
+  uint32_t *starts = NULL, *positions = NULL;
+  size_t kept = 0;
+  for (size_t c = 0; c < num_candidates; c++) {
+    uint32_t song_id = candidates[c];
+    size_t num_starts = 0;
+    for (size_t t = 0; t < num_terms; t++) {
+      QueryTerm *term = &terms[order[t]];
+      if (!posting_cursor_seek(&term->cursor, song_id) ||
+          term->cursor.song_id != song_id) {
+        num_starts = 0;
+        break;
+      }
+      size_t count = term->cursor.count;
+      uint32_t **buffer = t == 0 ? &starts : &positions;
+      size_t *capacity = t == 0 ? &starts_capacity : &positions_capacity;
+      if (count > *capacity) {
+        *capacity = 2 * count;
+        free(*buffer);
+        *buffer = (uint32_t *)allocate_or_exit(*capacity * sizeof(uint32_t));
+      }
+      size_t decoded = posting_cursor_positions(&term->cursor, *buffer);
+      if (t == 0) {
+        for (size_t p = 0; p < decoded; p++) {
+          if (starts[p] >= term->offset)
+            starts[num_starts++] = starts[p] - term->offset;
+        }
+      } else {
+        num_starts = keep_phrase_starts(starts, num_starts, positions,
+                                        decoded, term->offset);
+      }
+      if (num_starts == 0)
+        break;
+    }
+    if (num_starts > 0)
+      candidates[kept++] = song_id;
+  }
+  free(starts);
+  free(positions);
+  return kept;
+}
+
+size_t match_terms(QueryTerm *terms, size_t num_terms, bool phrase,
+                   uint32_t **songs) {
+  // Ordem crescente de número de músicas (as consultas têm poucas
+  // palavras).
+  size_t *order = (size_t *)allocate_or_exit(num_terms * sizeof(size_t));
+  for (size_t i = 0; i < num_terms; i++) {
+    size_t j = i;
+    while (j > 0 && terms[order[j - 1]].cursor.num_songs >
+                        terms[i].cursor.num_songs) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+  PostingCursor *starts = NULL;
+  if (phrase && num_terms > 1) {
+    starts = (PostingCursor *)allocate_or_exit(num_terms *
+                                               sizeof(PostingCursor));
+    for (size_t i = 0; i < num_terms; i++)
+      starts[i] = terms[i].cursor;
+  }
+
+  size_t capacity = cursor_capacity(&terms[order[0]].cursor);
+  uint32_t *candidates =
+      (uint32_t *)allocate_or_exit(capacity * sizeof(uint32_t));
+  uint32_t *next = (uint32_t *)allocate_or_exit(capacity * sizeof(uint32_t));
+  size_t num_candidates =
+      decode_song_ids(&terms[order[0]].cursor, candidates, capacity);
+
+  uint32_t *decoded = NULL;
+  size_t decoded_capacity = 0;
+  for (size_t t = 1; t < num_terms && num_candidates > 0; t++) {
+    PostingCursor *cursor = &terms[order[t]].cursor;
+    if (cursor->num_songs / INTERSECT_GALLOP_RATIO >= num_candidates) {
+      // Lista muito maior: saltos até cada candidata.
+      size_t kept = 0;
+      for (size_t i = 0; i < num_candidates; i++) {
+        if (!posting_cursor_seek(cursor, candidates[i]))
+          break;
+        if (cursor->song_id == candidates[i])
+          candidates[kept++] = candidates[i];
+      }
+      num_candidates = kept;
+      continue;
+    }
+    size_t size = cursor_capacity(cursor);
+    if (size > decoded_capacity) {
+      free(decoded);
+      decoded_capacity = size;
+      decoded = (uint32_t *)allocate_or_exit(size * sizeof(uint32_t));
+    }
+    size = decode_song_ids(cursor, decoded, size);
+    num_candidates =
+        intersect_sorted(candidates, num_candidates, decoded, size, next);
+    uint32_t *swap = candidates;
+    candidates = next;
+    next = swap;
+  }
+  free(decoded);
+  free(next);
+
+  if (starts != NULL) {
+    for (size_t i = 0; i < num_terms; i++)
+      terms[i].cursor = starts[i];
+    num_candidates = filter_phrases(terms, order, num_terms, candidates,
+                                    num_candidates);
+    free(starts);
+  }
+  free(order);
+  *songs = candidates;
+  return num_candidates;
+}
+
+bool lookup_dictionary_term(const void *index, const char *word,
+                            PostingCursor *cursor) {
+  const Dictionary *dictionary = (const Dictionary *)index;
+  const WordEntry *entry = find_word(dictionary, word);
+  if (entry == NULL)
+    return false;
+  open_posting_list(cursor, word_postings(dictionary, entry));
+  return true;
+}
+
+bool lookup_snapshot_term(const void *index, const char *word,
+                          PostingCursor *cursor) {
+  const Snapshot *snapshot = (const Snapshot *)index;
+  const SnapshotWord *found = snapshot_find_word(snapshot, word);
+  if (found == NULL)
+    return false;
+  snapshot_word_cursor(snapshot, found, cursor);
+  return true;
+}
+
+size_t search_text(const char *text, bool phrase, TermLookup lookup,
+                   const void *index, uint32_t **songs, size_t *num_terms) {
+  size_t length = strlen(text);
+  char *normalized = (char *)allocate_or_exit(length + TOKENIZE_PADDING);
+  TokenSpan *tokens =
+      (TokenSpan *)allocate_or_exit((length / 2 + 1) * sizeof(TokenSpan));
+  size_t num_tokens = tokenize_line(text, length, normalized, tokens);
+  QueryTerm *terms =
+      (QueryTerm *)allocate_or_exit((num_tokens + 1) * sizeof(QueryTerm));
+
+  // Cada token termina antes do início do seguinte, de modo que o '\0'
+  // pode ser escrito logo após ele.
+  // As posições seguem as de scan_music_file: um token vazio (só
+  // pontuação) não ocupa posição.
+  bool missing = false;
+  unsigned int position = 0;
+  *num_terms = 0;
+  for (size_t t = 0; t < num_tokens; t++) {
+    if (tokens[t].length == 0)
+      continue;
+    position++;
+    if (tokens[t].length < 3)
+      continue;
+    char *word = normalized + tokens[t].offset;
+    word[tokens[t].length] = '\0';
+    QueryTerm *term = &terms[(*num_terms)++];
+    term->offset = position - 1;
+    if (!lookup(index, word, &term->cursor))
+      missing = true;
+  }
+
+  size_t num_songs = 0;
+  if (*num_terms == 0 || missing)
+    *songs = (uint32_t *)allocate_or_exit(sizeof(uint32_t));
+  else
+    num_songs = match_terms(terms, *num_terms, phrase, songs);
+  free(terms);
+  free(tokens);
+  free(normalized);
+  return num_songs;
+}
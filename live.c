@@ -0,0 +1,162 @@
+/**
+ * @file live.c
+ * @brief Publicação de versões do índice e liberação por épocas.
+ *
+ * Todos os acessos compartilhados são sequencialmente consistentes. Na
+ * leitora, a anotação da época precede a leitura do ponteiro da versão; na
+ * escritora, a troca do ponteiro precede o incremento da época, que precede
+ * a varredura das posições. Assim, se a varredura não vê a época de uma
+ * leitora, a leitura do ponteiro dessa leitora já vê a versão nova.
+ */
+
+#include "include/live.h"
+#include "include/repository.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static LiveVersion *create_version(Snapshot *snapshot, uint64_t number) {
+  LiveVersion *version = (LiveVersion *)malloc(sizeof(LiveVersion));
+  if (version == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para LiveVersion.\n");
+    exit(EXIT_FAILURE);
+  }
+  version->snapshot = snapshot;
+  version->counts = build_snapshot_count_index(snapshot);
+  version->number = number;
+  version->retired_at = 0;
+  version->older = NULL;
+  return version;
+}
+
+static void free_version(LiveVersion *version) {
+  free_count_index(version->counts);
+  free_snapshot(version->snapshot);
+  free(version);
+}
+
+LiveIndex *create_live_index(void) {
+  LiveIndex *index =
+      (LiveIndex *)aligned_alloc(LIVE_CACHE_LINE, sizeof(LiveIndex));
+  if (index == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para LiveIndex.\n");
+    exit(EXIT_FAILURE);
+  }
+  memset(index, 0, sizeof(LiveIndex));
+  index->epoch = 1;
+  if (!live_index_refresh(index)) {
+    free(index);
+    return NULL;
+  }
+  return index;
+}
+
+void free_live_index(LiveIndex *index) {
+  if (index == NULL)
+    return;
+  live_index_synchronize(index);
+  if (index->current != NULL)
+    free_version(index->current);
+  free(index);
+}
+
+LiveReader *live_index_register(LiveIndex *index) {
+  for (size_t i = 0; i < LIVE_MAX_READERS; i++) {
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&index->readers[i].in_use, &expected, 1,
+                                    false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED))
+      return &index->readers[i];
+  }
+  return NULL;
+}
+
+void live_index_unregister(LiveReader *reader) {
+  if (reader != NULL)
+    __atomic_store_n(&reader->in_use, 0, __ATOMIC_RELEASE);
+}
+
+const LiveVersion *live_index_begin(LiveIndex *index, LiveReader *reader) {
+  uint64_t epoch = __atomic_load_n(&index->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&index->current, __ATOMIC_SEQ_CST);
+}
+
+void live_index_end(LiveReader *reader) {
+  __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Menor época entre as leitoras em consulta, ou UINT64_MAX.
+ */
+static uint64_t oldest_reader_epoch(LiveIndex *index) {
+  uint64_t oldest = UINT64_MAX;
+  for (size_t i = 0; i < LIVE_MAX_READERS; i++) {
+    uint64_t epoch =
+        __atomic_load_n(&index->readers[i].epoch, __ATOMIC_SEQ_CST);
+    if (epoch != 0 && epoch < oldest)
+      oldest = epoch;
+  }
+  return oldest;
+}
+
+size_t live_index_reclaim(LiveIndex *index) {
+  if (index->retired == NULL)
+    return 0;
+  // Uma versão substituída na época e pode estar com as leitoras que
+  // anotaram e ou menos.
+  uint64_t oldest = oldest_reader_epoch(index);
+  size_t reclaimed = 0;
+  LiveVersion **link = &index->retired;
+  while (*link != NULL) {
+    LiveVersion *version = *link;
+    if (version->retired_at < oldest) {
+      *link = version->older;
+      free_version(version);
+      reclaimed++;
+    } else {
+      link = &version->older;
+    }
+  }
+  index->num_retired -= reclaimed;
+  index->num_reclaimed += reclaimed;
+  return reclaimed;
+}
+
+void live_index_synchronize(LiveIndex *index) {
+  while (live_index_reclaim(index), index->retired != NULL)
+    sched_yield();
+}
+
+void live_index_publish(LiveIndex *index, Snapshot *snapshot) {
+  LiveVersion *version = create_version(snapshot, ++index->num_published);
+  LiveVersion *previous =
+      __atomic_exchange_n(&index->current, version, __ATOMIC_SEQ_CST);
+  if (previous == NULL)
+    return;
+  previous->retired_at = __atomic_fetch_add(&index->epoch, 1,
+                                            __ATOMIC_SEQ_CST);
+  previous->older = index->retired;
+  index->retired = previous;
+  index->num_retired++;
+
+  live_index_reclaim(index);
+  while (index->num_retired > LIVE_MAX_RETIRED) {
+    sched_yield();
+    live_index_reclaim(index);
+  }
+}
+
+bool live_index_refresh(LiveIndex *index) {
+  if (song_repository == NULL)
+    song_repository = create_repository();
+  update_search_structures(song_repository);
+  Snapshot *snapshot = build_snapshot(
+      song_repository, sorted_word_array,
+      avl_frequency_tree != NULL ? avl_frequency_tree->root : NULL);
+  if (snapshot == NULL)
+    return false;
+  live_index_publish(index, snapshot);
+  return true;
+}
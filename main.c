@@ -7,78 +7,334 @@
  * frequência.
  */
 
+#include "include/ingest.h"
+#include "include/intersect.h"
+#include "include/prefix.h"
+#include "include/query.h"
+#include "include/rank.h"
 #include "include/repository.h"
+#include "include/server.h"
+#include "include/snapshot.h"
 #include "include/structures.h"
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// Palavras exibidas antes de perguntar se a busca por frequência continua.
+#define FREQUENCY_PAGE_SIZE 20
+
 /**
- * @brief Exibe as informações de um nó da árvore.
- * @param node O nó a ser exibido.
+ * @brief Exibe a palavra, a contagem total e a melhor ocorrência.
  */
-void display_word_info(Node *node) {
-  if (node == NULL) {
+static void print_word_info(const char *word, unsigned int total_word_count,
+                            const char *title, const char *author,
+                            const char *verse,
+                            unsigned int word_count_in_song) {
+  printf("Palavra: %s\n", word);
+  printf("Total de ocorrências no repositório: %u\n", total_word_count);
+  printf("  Melhor música: %s\n", title);
+  printf("  Autor: %s\n", author);
+  printf("  Trecho do verso: %s\n", verse);
+  printf("  Ocorrências na música: %u\n", word_count_in_song);
+}
+
+/**
+ * @brief Exibe as informações do registro de uma palavra.
+ * @param entry O registro a ser exibido.
+ */
+void display_word_info(const WordEntry *entry) {
+  if (entry == NULL) {
     printf("Palavra não encontrada.\n");
     return;
   }
-  printf("Palavra: %s\n", node->word);
-  printf("Total de ocorrências no repositório: %u\n", node->total_word_count);
-  if (node->best_song_occurrence != NULL) {
-    printf("  Melhor música: %s\n", node->best_song_occurrence->title);
-    printf("  Autor: %s\n", node->best_song_occurrence->author);
-    printf("  Trecho do verso: %s\n",
-           node->best_song_occurrence->verse_snippet);
-    printf("  Ocorrências na música: %u\n",
-           node->best_song_occurrence->word_count_in_song);
+  const SongOccurrence *best = &entry->best_song_occurrence;
+  const Song *song = get_song(song_repository, best->song_id);
+  print_word_info(entry->word, entry->total_word_count, song->title,
+                  song->author, song->lyrics_lines[best->verse_line],
+                  best->word_count_in_song);
+}
+
+/**
+ * @brief Exibe as informações de um registro do índice salvo.
+ * @param snapshot O índice.
+ * @param word O registro a ser exibido.
+ */
+void display_snapshot_word(const Snapshot *snapshot, const SnapshotWord *word) {
+  if (word == NULL) {
+    printf("Palavra não encontrada.\n");
+    return;
+  }
+  SnapshotWordText text = snapshot_word_text(snapshot, word);
+  print_word_info(text.word, word->total_word_count, text.title, text.author,
+                  text.verse, word->word_count_in_song);
+}
+
+/**
+ * @brief Pergunta se a próxima página de resultados deve ser exibida.
+ * @param shown O número de resultados já exibidos.
+ * @param total O número total de resultados.
+ * @param noun O nome dos resultados ("palavra(s)", "música(s)").
+ * @return true se o usuário respondeu 's'.
+ */
+static bool ask_next_page(size_t shown, size_t total, const char *noun) {
+  char answer;
+  printf("Exibida(s) %zu de %zu %s. Mostrar mais? (s/n): ", shown, total,
+         noun);
+  if (scanf(" %c", &answer) != 1)
+    return false;
+  return answer == 's' || answer == 'S';
+}
+
+/**
+ * @brief Copia o índice salvo para o repositório e as árvores globais, que
+ * passam a responder as buscas.
+ *
+ * Usada antes de uma carga de arquivos ou de salvar o índice, que alteram
+ * ou percorrem as estruturas em memória.
+ *
+ * @param snapshot Endereço do índice; passa a ser NULL se a cópia der certo.
+ * @return true se não havia índice ou se ele foi copiado.
+ */
+static bool thaw_snapshot(Snapshot **snapshot) {
+  if (*snapshot == NULL) {
+    return true;
+  }
+  if (song_repository == NULL) {
+    song_repository = create_repository();
   }
+  if (!restore_snapshot(*snapshot, song_repository)) {
+    return false;
+  }
+  update_search_structures(song_repository);
+  free_snapshot(*snapshot);
+  *snapshot = NULL;
+  return true;
+}
+
+/**
+ * @brief Libera as estruturas globais e o índice salvo.
+ *
+ * Os registros e os nós das árvores ficam nas arenas do repositório e são
+ * liberados junto com ele, sem percorrer as árvores.
+ */
+static void free_index(Snapshot *snapshot) {
+  free(bin_tree);
+  free(avl_tree);
+  free_word_array(sorted_word_array);
+  free_eytzinger_array(eytzinger_array);
+  free_count_index(count_index);
+  free(avl_frequency_tree);
+  free_repository(song_repository);
+  free_snapshot(snapshot);
 }
 
 /**
- * @brief Constrói uma árvore AVL de frequência a partir da árvore AVL
- * principal.
- * @param root A raiz da árvore AVL principal.
+ * @brief Executa as consultas do modo em lote e informa a vazão em stderr.
+ *
+ * @param snapshot O índice salvo, ou NULL.
+ * @param engine_name A estrutura escolhida, ou NULL para a padrão (o índice
+ * salvo, se houver, ou a AVL).
+ * @param queries_path O arquivo de consultas, ou NULL ou "-" para stdin.
+ * @return 0 se as consultas foram executadas, 1 caso contrário.
  */
-void build_frequency_avl_tree_from_main_avl(Node *root) {
-  if (avl_frequency_tree != NULL) {
-    free_frequency_tree(avl_frequency_tree->root);
-    free(avl_frequency_tree);
-    avl_frequency_tree = NULL;
+static int run_batch(Snapshot **snapshot, const char *engine_name,
+                     const char *queries_path) {
+  QueryContext context = {QUERY_ENGINE_AVL, NULL, NULL, 0, 0};
+  if (engine_name == NULL) {
+    context.engine =
+        *snapshot != NULL ? QUERY_ENGINE_SNAPSHOT : QUERY_ENGINE_AVL;
+  } else if (!parse_query_engine(engine_name, &context.engine)) {
+    fprintf(stderr, "Estrutura desconhecida: %s\n", engine_name);
+    return 1;
   }
 
-  avl_frequency_tree = (Tree *)malloc(sizeof(Tree));
-  if (avl_frequency_tree == NULL) {
-    fprintf(stderr, "Falha na alocação de memória para avl_frequency_tree.\n");
-    exit(EXIT_FAILURE);
+  if (context.engine == QUERY_ENGINE_SNAPSHOT) {
+    if (*snapshot == NULL) {
+      fprintf(stderr, "A estrutura snapshot exige --snapshot.\n");
+      return 1;
+    }
+    context.snapshot = *snapshot;
+  } else if (!thaw_snapshot(snapshot)) {
+    return 1;
   }
-  avl_frequency_tree->root = NULL;
 
-  populate_frequency_avl_tree(root);
+  FILE *in = stdin;
+  if (queries_path != NULL && strcmp(queries_path, "-") != 0) {
+    in = fopen(queries_path, "r");
+    if (in == NULL) {
+      perror(queries_path);
+      return 1;
+    }
+  }
+
+  // As respostas são escritas em blocos, não linha a linha.
+  static char output_buffer[1 << 16];
+  setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  run_query_stream(&context, in, stdout);
+  fflush(stdout);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (in != stdin) {
+    fclose(in);
+  }
+  free_count_index(context.snapshot_counts);
+
+  double elapsed =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  fprintf(stderr, "%zu consulta(s) (%zu inválida(s)) em %f segundos: %.0f "
+                  "consultas/s\n",
+          context.num_queries, context.num_errors, elapsed,
+          elapsed > 0 ? context.num_queries / elapsed : 0.0);
+  return 0;
 }
 
 /**
  * @brief Função principal que executa o menu do programa.
+ *
+ * Com a opção --treap, a BST é mantida como treap, o que evita a degeneração
+ * quando as palavras chegam em ordem alfabética. Com --snapshot, um índice
+ * salvo pela opção 5 é mapeado na inicialização e responde as buscas sem
+ * montar as árvores; --verify-snapshot também confere a soma de verificação
+ * do arquivo inteiro. Cada --load carrega um arquivo ou diretório antes do
+ * menu.
+ *
+ * Com --batch, o menu não é exibido: as consultas de --queries (ou da
+ * entrada padrão) são executadas na estrutura escolhida por --engine e as
+ * respostas são escritas na saída padrão no formato descrito em query.h.
+ *
+ * Com --serve, o programa atende as mesmas consultas em um socket local
+ * (server.h) até receber SIGINT ou SIGTERM, com --workers threads de
+ * trabalho; os caminhos de --load são carregados em segundo plano.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos da linha de comando.
  * @return 0 se o programa for executado com sucesso, 1 caso contrário.
  */
-int main() {
+int main(int argc, char **argv) {
+  const char *snapshot_path = NULL;
+  bool verify_snapshot = false;
+  bool batch = false;
+  const char *engine_name = NULL;
+  const char *queries_path = NULL;
+  const char *serve_address = NULL;
+  int num_workers = 0;
+  const char **load_paths = (const char **)malloc(argc * sizeof(char *));
+  int num_load_paths = 0;
+  if (load_paths == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para os argumentos.\n");
+    return 1;
+  }
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--treap") == 0) {
+      bst_treap_mode = true;
+    } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+      snapshot_path = argv[++i];
+    } else if (strcmp(argv[i], "--verify-snapshot") == 0) {
+      verify_snapshot = true;
+    } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+      load_paths[num_load_paths++] = argv[++i];
+    } else if (strcmp(argv[i], "--batch") == 0) {
+      batch = true;
+    } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+      engine_name = argv[++i];
+    } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+      queries_path = argv[++i];
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+      serve_address = argv[++i];
+    } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      num_workers = atoi(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "Uso: %s [--treap] [--snapshot arquivo [--verify-snapshot]] "
+              "[--load caminho]...\n"
+              "       [--batch [--engine bst|avl|array|eytzinger|snapshot] "
+              "[--queries arquivo]]\n"
+              "       [--serve endereço [--workers n]]\n",
+              argv[0]);
+      free(load_paths);
+      return 1;
+    }
+  }
+  const char *bst_name = bst_treap_mode ? "Treap" : "BST";
+
   initialize_tree(bin_tree);
   initialize_tree(avl_tree);
 
   int choice;
   char filepath[256];
   char search_word[256];
+  char search_line[1024];
   unsigned int search_frequency;
   clock_t start_time, end_time;
+  struct timespec wall_start, wall_end;
   double cpu_time_used;
-  Node *found_node;
+  WordEntry *found_entry;
   bool has_file = false;
 
+  // Índice salvo que responde as buscas enquanto nenhuma carga for feita, e
+  // as suas contagens para o autocompletar (montadas na primeira consulta).
+  Snapshot *snapshot = NULL;
+  CountIndex *snapshot_counts = NULL;
+  if (snapshot_path != NULL) {
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    snapshot = load_snapshot(snapshot_path, verify_snapshot);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    if (snapshot == NULL) {
+      free(load_paths);
+      return 1;
+    }
+    cpu_time_used = (wall_end.tv_sec - wall_start.tv_sec) +
+                    (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    fprintf(batch || serve_address != NULL ? stderr : stdout,
+            "Índice carregado: %u palavra(s) de %u música(s). Tempo "
+            "decorrido: %f segundos\n",
+            snapshot->num_words, snapshot->num_songs, cpu_time_used);
+    has_file = true;
+  }
+
+  if (serve_address != NULL) {
+    ServerOptions options = {serve_address, num_workers, load_paths,
+                             num_load_paths, snapshot};
+    int status = run_server(&options);
+    free(load_paths);
+    free_index(NULL);
+    return status;
+  }
+
+  for (int i = 0; i < num_load_paths; i++) {
+    if (!thaw_snapshot(&snapshot) || !load_music_path(load_paths[i])) {
+      free(load_paths);
+      return 1;
+    }
+    update_search_structures(song_repository);
+    has_file = true;
+  }
+  free(load_paths);
+
+  if (batch) {
+    int status = run_batch(&snapshot, engine_name, queries_path);
+    free_index(snapshot);
+    return status;
+  }
+
   do {
     printf("\n--- Menu do Repositório de Músicas ---\n");
     printf("1. Carregar arquivo de música\n");
     printf("2. Buscar palavra\n");
     printf("3. Buscar por frequência\n");
+    printf("4. Carregar diretório de músicas (em paralelo)\n");
+    printf("5. Salvar índice em arquivo\n");
+    printf("6. Palavras mais frequentes\n");
+    printf("7. Contar palavras por faixa de frequência\n");
+    printf("8. Autocompletar (palavras por prefixo)\n");
+    printf("9. Músicas que contêm uma palavra\n");
+    printf("10. Buscar músicas por trecho (várias palavras)\n");
+    printf("11. Músicas mais relevantes para um trecho\n");
     printf("0. Sair\n");
     printf("Digite sua escolha: ");
     scanf("%d", &choice);
@@ -87,6 +343,9 @@ int main() {
     case 1:
       printf("Digite o caminho para o arquivo de música: ");
       scanf("%s", filepath);
+      if (!thaw_snapshot(&snapshot)) {
+        break;
+      }
       start_time = clock();
       process_music_file_for_word_count(filepath, NULL, NULL);
       end_time = clock();
@@ -94,15 +353,33 @@ int main() {
       printf("Arquivo carregado. Tempo decorrido: %f segundos\n",
              cpu_time_used);
 
-      if (sorted_word_array != NULL) {
-        free_word_array(sorted_word_array);
-      }
-      sorted_word_array = create_word_array();
-      populate_array_from_tree(bin_tree->root, sorted_word_array);
-      sort_word_array(sorted_word_array);
-      build_frequency_avl_tree_from_main_avl(avl_tree->root);
+      update_search_structures(song_repository);
       has_file = true;
       break;
+    case 4:
+      printf("Digite o caminho para o diretório de músicas: ");
+      scanf("%s", filepath);
+      if (!thaw_snapshot(&snapshot)) {
+        break;
+      }
+      // clock() soma o tempo de CPU de todas as threads; para a carga
+      // paralela interessa o tempo de parede.
+      clock_gettime(CLOCK_MONOTONIC, &wall_start);
+      int loaded_files = process_music_directory(filepath, 0);
+      clock_gettime(CLOCK_MONOTONIC, &wall_end);
+      if (loaded_files < 0) {
+        break;
+      }
+      cpu_time_used = (wall_end.tv_sec - wall_start.tv_sec) +
+                      (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+      printf("%d arquivo(s) carregado(s). Tempo decorrido: %f segundos\n",
+             loaded_files, cpu_time_used);
+
+      if (loaded_files > 0) {
+        update_search_structures(song_repository);
+        has_file = true;
+      }
+      break;
     case 2:
       if (!has_file) {
         printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
@@ -112,31 +389,56 @@ int main() {
       printf("Digite a palavra para buscar: ");
       scanf("%s", search_word);
 
-      // Busca na BST
+      if (snapshot != NULL) {
+        start_time = clock();
+        const SnapshotWord *found_word =
+            snapshot_find_word(snapshot, search_word);
+        end_time = clock();
+        cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+        printf("\n--- Resultado da Busca no Índice Salvo ---\n");
+        display_snapshot_word(snapshot, found_word);
+        printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+        break;
+      }
+
+      // Busca na BST (ou treap)
       start_time = clock();
-      found_node = search_bst(bin_tree->root, search_word);
+      found_entry = search_bst(bin_tree->root, search_word);
       end_time = clock();
       cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-      printf("\n--- Resultado da Busca na BST ---\n");
-      display_word_info(found_node);
+      printf("\n--- Resultado da Busca na %s ---\n", bst_name);
+      display_word_info(found_entry);
       printf("Tempo decorrido: %f segundos\n", cpu_time_used);
 
       // Busca na AVL
       start_time = clock();
-      found_node = search_avl(avl_tree->root, search_word);
+      found_entry = search_avl(avl_tree->root, search_word);
       end_time = clock();
       cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
       printf("\n--- Resultado da Busca na AVL ---\n");
-      display_word_info(found_node);
+      display_word_info(found_entry);
       printf("Tempo decorrido: %f segundos\n", cpu_time_used);
 
       // Busca no Array
       start_time = clock();
-      found_node = binary_search_array(sorted_word_array, search_word);
+      found_entry = binary_search_array(sorted_word_array, search_word);
       end_time = clock();
       cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
       printf("\n--- Resultado da Busca Binária (Array) ---\n");
-      display_word_info(found_node);
+      display_word_info(found_entry);
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+
+      // Busca no array em ordem de Eytzinger, montado fora da medição se a
+      // última carga trouxe palavras novas.
+      if (eytzinger_array == NULL) {
+        eytzinger_array = build_eytzinger_array(sorted_word_array);
+      }
+      start_time = clock();
+      found_entry = search_eytzinger(eytzinger_array, search_word);
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+      printf("\n--- Resultado da Busca no Array de Eytzinger ---\n");
+      display_word_info(found_entry);
       printf("Tempo decorrido: %f segundos\n", cpu_time_used);
       break;
     case 3:
@@ -148,29 +450,373 @@ int main() {
       printf("Digite a frequência mínima para buscar: ");
       scanf("%u", &search_frequency);
 
+      // As palavras são exibidas em páginas à medida que são percorridas,
+      // sem copiar os resultados; o total vem dos tamanhos das subárvores.
+      size_t num_results, first_position = 0;
+      FrequencyCursor frequency_cursor;
       start_time = clock();
-      WordArray *frequency_results =
-          search_all_by_frequency(avl_frequency_tree->root, search_frequency);
+      if (snapshot != NULL) {
+        num_results = snapshot_frequency_range(snapshot, search_frequency,
+                                               UINT_MAX, &first_position);
+      } else {
+        num_results = count_frequency_range(avl_frequency_tree->root,
+                                            search_frequency, UINT_MAX);
+        frequency_cursor_start(&frequency_cursor, avl_frequency_tree->root,
+                               search_frequency, UINT_MAX);
+      }
       end_time = clock();
       cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
 
       printf("\n--- Resultado da Busca por Frequência Mínima ---\n");
-      if (frequency_results->size == 0) {
+      if (num_results == 0) {
         printf("Nenhuma palavra encontrada com frequência >= %u\n",
                search_frequency);
       } else {
-        printf("Encontrada(s) %d palavra(s) com frequência >= %u:\n\n",
-               frequency_results->size, search_frequency);
-        for (size_t i = 0; i < frequency_results->size; i++) {
+        printf("Encontrada(s) %zu palavra(s) com frequência >= %u:\n\n",
+               num_results, search_frequency);
+        for (size_t i = 0; i < num_results; i++) {
+          if (i > 0 && i % FREQUENCY_PAGE_SIZE == 0 &&
+              !ask_next_page(i, num_results, "palavra(s)")) {
+            break;
+          }
           printf("Palavra %zu:\n", i + 1);
-          display_word_info(frequency_results->nodes[i]);
+          if (snapshot != NULL) {
+            display_snapshot_word(snapshot, snapshot_frequency_word(
+                                                snapshot, first_position + i));
+          } else {
+            display_word_info(frequency_cursor_next(&frequency_cursor));
+          }
           printf("\n");
         }
       }
       printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      break;
+    case 5:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite o caminho para o arquivo do índice: ");
+      scanf("%s", filepath);
+      if (!thaw_snapshot(&snapshot)) {
+        break;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &wall_start);
+      bool saved = save_snapshot(filepath, song_repository, sorted_word_array,
+                                 avl_frequency_tree->root);
+      clock_gettime(CLOCK_MONOTONIC, &wall_end);
+      if (saved) {
+        cpu_time_used = (wall_end.tv_sec - wall_start.tv_sec) +
+                        (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+        printf("Índice salvo. Tempo decorrido: %f segundos\n", cpu_time_used);
+      }
+      break;
+    case 6:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite o número de palavras: ");
+      scanf("%u", &search_frequency);
+
+      printf("\n--- Palavras Mais Frequentes ---\n");
+      if (snapshot != NULL) {
+        // A ordem de frequência salva é crescente; as últimas posições são
+        // as mais frequentes.
+        size_t count = search_frequency < snapshot->num_words
+                           ? search_frequency
+                           : snapshot->num_words;
+        for (size_t i = 1; i <= count; i++) {
+          printf("%zu.º lugar:\n", i);
+          display_snapshot_word(
+              snapshot,
+              snapshot_frequency_word(snapshot, snapshot->num_words - i));
+          printf("\n");
+        }
+        break;
+      }
 
-      free(frequency_results->nodes);
-      free(frequency_results);
+      start_time = clock();
+      WordArray *top_results =
+          search_top_frequency(avl_frequency_tree->root, search_frequency);
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+      for (int i = 0; i < top_results->size; i++) {
+        printf("%d.º lugar:\n", i + 1);
+        display_word_info(top_results->entries[i]);
+        printf("\n");
+      }
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      free_word_array(top_results);
+      break;
+    case 7:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      unsigned int max_frequency;
+      printf("Digite a frequência mínima e a máxima: ");
+      scanf("%u %u", &search_frequency, &max_frequency);
+
+      // Só a contagem: nenhuma palavra é listada nem copiada.
+      size_t range_count, range_first;
+      start_time = clock();
+      if (snapshot != NULL) {
+        range_count = snapshot_frequency_range(snapshot, search_frequency,
+                                               max_frequency, &range_first);
+      } else {
+        range_count = count_frequency_range(avl_frequency_tree->root,
+                                            search_frequency, max_frequency);
+      }
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+      printf("%zu palavra(s) com frequência entre %u e %u\n", range_count,
+             search_frequency, max_frequency);
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      break;
+    case 8:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite o prefixo e o número de sugestões: ");
+      scanf("%255s %u", search_word, &search_frequency);
+
+      // Sugestões da maior contagem total para a menor; não há mais
+      // sugestões que palavras com o prefixo.
+      size_t num_completions, completion_first;
+      start_time = clock();
+      if (snapshot != NULL) {
+        num_completions =
+            snapshot_prefix_range(snapshot, search_word, &completion_first);
+      } else {
+        num_completions =
+            prefix_range(sorted_word_array, search_word, &completion_first);
+      }
+      size_t num_wanted = num_completions < search_frequency
+                              ? num_completions
+                              : search_frequency;
+      size_t *completions = malloc((num_wanted + 1) * sizeof(size_t));
+      if (completions == NULL) {
+        fprintf(stderr, "Falha na alocação de memória para as sugestões.\n");
+        break;
+      }
+      if (snapshot != NULL) {
+        if (snapshot_counts == NULL)
+          snapshot_counts = build_snapshot_count_index(snapshot);
+        num_completions = top_counts_in_range(
+            snapshot_counts, completion_first,
+            completion_first + num_completions, num_wanted, completions);
+      } else {
+        if (count_index == NULL)
+          count_index = build_word_array_count_index(sorted_word_array);
+        num_completions = top_counts_in_range(
+            count_index, completion_first, completion_first + num_completions,
+            num_wanted, completions);
+      }
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+
+      printf("\n--- Sugestões para \"%s\" ---\n", search_word);
+      if (num_completions == 0) {
+        printf("Nenhuma palavra começa com \"%s\"\n", search_word);
+      }
+      for (size_t i = 0; i < num_completions; i++) {
+        if (snapshot != NULL) {
+          const SnapshotWord *word = &snapshot->words[completions[i]];
+          printf("%zu. %s (%u)\n", i + 1,
+                 snapshot_word_text(snapshot, word).word,
+                 word->total_word_count);
+        } else {
+          const WordEntry *entry = sorted_word_array->entries[completions[i]];
+          printf("%zu. %s (%u)\n", i + 1, entry->word,
+                 entry->total_word_count);
+        }
+      }
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      free(completions);
+      break;
+    case 9:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite a palavra para buscar: ");
+      scanf("%255s", search_word);
+
+      // A lista de ocorrências é decodificada inteira, em ordem de
+      // identificador da música.
+      const SnapshotWord *postings_word = NULL;
+      const PostingList *posting_list = NULL;
+      size_t num_songs = 0;
+      start_time = clock();
+      if (snapshot != NULL) {
+        postings_word = snapshot_find_word(snapshot, search_word);
+        if (postings_word != NULL)
+          num_songs = postings_word->num_songs;
+      } else {
+        found_entry = find_word(&song_repository->dictionary, search_word);
+        if (found_entry != NULL) {
+          posting_list = word_postings(&song_repository->dictionary,
+                                       found_entry);
+          num_songs = posting_list->num_songs;
+        }
+      }
+      Posting *postings = malloc((num_songs + 1) * sizeof(Posting));
+      if (postings == NULL) {
+        fprintf(stderr, "Falha na alocação de memória para as ocorrências.\n");
+        break;
+      }
+      if (postings_word != NULL)
+        num_songs = snapshot_word_postings(snapshot, postings_word, postings,
+                                           num_songs);
+      else if (posting_list != NULL)
+        num_songs = decode_postings(posting_list, postings, num_songs);
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+
+      printf("\n--- Músicas com \"%s\" ---\n", search_word);
+      if (num_songs == 0) {
+        printf("Palavra não encontrada.\n");
+      } else {
+        printf("A palavra aparece em %zu música(s):\n\n", num_songs);
+      }
+      for (size_t i = 0; i < num_songs; i++) {
+        if (i > 0 && i % FREQUENCY_PAGE_SIZE == 0 &&
+            !ask_next_page(i, num_songs, "música(s)")) {
+          break;
+        }
+        const char *title, *author;
+        if (snapshot != NULL) {
+          snapshot_song_text(snapshot, postings[i].song_id, &title, &author);
+        } else {
+          const Song *song = get_song(song_repository, postings[i].song_id);
+          title = song->title;
+          author = song->author;
+        }
+        printf("%zu. %s - %s (%u ocorrência(s))\n", i + 1, title, author,
+               postings[i].count);
+      }
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      free(postings);
+      break;
+    case 10:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite o trecho para buscar: ");
+      if (scanf(" %1023[^\n]", search_line) != 1)
+        break;
+      char phrase_answer = 'n';
+      printf("Exigir as palavras em sequência, como frase? (s/n): ");
+      scanf(" %c", &phrase_answer);
+      bool phrase = phrase_answer == 's' || phrase_answer == 'S';
+
+      // As listas de ocorrências das palavras são intersectadas, da menor
+      // para a maior; as frases são conferidas pelas posições.
+      uint32_t *matches;
+      size_t num_terms, num_matches;
+      start_time = clock();
+      if (snapshot != NULL)
+        num_matches = search_text(search_line, phrase, lookup_snapshot_term,
+                                  snapshot, &matches, &num_terms);
+      else
+        num_matches = search_text(search_line, phrase,
+                                  lookup_dictionary_term,
+                                  &song_repository->dictionary, &matches,
+                                  &num_terms);
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+
+      printf("\n--- Músicas com \"%s\" ---\n", search_line);
+      if (num_terms == 0) {
+        printf("O trecho não tem palavras de 3 letras ou mais.\n");
+      } else if (num_matches == 0) {
+        printf("Nenhuma música encontrada.\n");
+      } else {
+        printf("O trecho aparece em %zu música(s):\n\n", num_matches);
+      }
+      for (size_t i = 0; i < num_matches; i++) {
+        if (i > 0 && i % FREQUENCY_PAGE_SIZE == 0 &&
+            !ask_next_page(i, num_matches, "música(s)")) {
+          break;
+        }
+        const char *title, *author;
+        if (snapshot != NULL) {
+          snapshot_song_text(snapshot, matches[i], &title, &author);
+        } else {
+          const Song *song = get_song(song_repository, matches[i]);
+          title = song->title;
+          author = song->author;
+        }
+        printf("%zu. %s - %s\n", i + 1, title, author);
+      }
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      free(matches);
+      break;
+    case 11:
+      if (!has_file) {
+        printf("Erro: Nenhum arquivo de música foi carregado ainda. Por favor, "
+               "use a opção 1 primeiro.\n");
+        break;
+      }
+      printf("Digite o trecho para buscar: ");
+      if (scanf(" %1023[^\n]", search_line) != 1)
+        break;
+      printf("Digite o número de músicas: ");
+      scanf("%u", &search_frequency);
+
+      // BM25 com max-score: as palavras comuns só são consultadas nas
+      // músicas que ainda podem entrar no resultado.
+      RankedSong *ranked;
+      size_t num_words, num_ranked;
+      RankCorpus corpus;
+      start_time = clock();
+      if (snapshot != NULL) {
+        snapshot_rank_corpus(snapshot, &corpus);
+        num_ranked = rank_text(search_line, rank_snapshot_term, snapshot,
+                               &corpus, search_frequency, &ranked,
+                               &num_words);
+      } else {
+        repository_rank_corpus(song_repository, &corpus);
+        num_ranked = rank_text(search_line, rank_repository_term,
+                               song_repository, &corpus, search_frequency,
+                               &ranked, &num_words);
+      }
+      end_time = clock();
+      cpu_time_used = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+      if (ranked == NULL) {
+        fprintf(stderr, "Falha na alocação de memória para o resultado.\n");
+        break;
+      }
+
+      printf("\n--- Músicas mais relevantes para \"%s\" ---\n", search_line);
+      if (num_words == 0) {
+        printf("O trecho não tem palavras de 3 letras ou mais.\n");
+      } else if (num_ranked == 0) {
+        printf("Nenhuma música encontrada.\n");
+      }
+      for (size_t i = 0; i < num_ranked; i++) {
+        const char *title, *author;
+        if (snapshot != NULL) {
+          snapshot_song_text(snapshot, ranked[i].song_id, &title, &author);
+        } else {
+          const Song *song = get_song(song_repository, ranked[i].song_id);
+          title = song->title;
+          author = song->author;
+        }
+        printf("%zu. %s - %s (relevância %.3f)\n", i + 1, title, author,
+               ranked[i].score);
+      }
+      printf("Tempo decorrido: %f segundos\n", cpu_time_used);
+      free(ranked);
       break;
     case 0:
       printf("Saindo do programa.\n");
@@ -180,18 +826,7 @@ int main() {
     }
   } while (choice != 0);
 
-  if (has_file) {
-    free_tree(bin_tree->root);
-    free(bin_tree);
-    free_tree(avl_tree->root);
-    free(avl_tree);
-    free_word_array(sorted_word_array);
-
-    if (avl_frequency_tree != NULL) {
-      free_frequency_tree(avl_frequency_tree->root);
-      free(avl_frequency_tree);
-    }
-  }
-
+  free_count_index(snapshot_counts);
+  free_index(snapshot);
   return 0;
 }
@@ -0,0 +1,387 @@
+/**
+ * @file postings.c
+ * @brief Codificação e decodificação das listas de ocorrências.
+ */
+
+#include "include/postings.h"
+#include <stdalign.h>
+#include <string.h>
+
+/**
+ * @brief Tamanho, com o cabeçalho, do bloco seguinte a um bloco de tamanho
+ * total.
+ */
+static inline size_t next_block_size(size_t total) {
+  return 2 * total < POSTING_BLOCK_MAX ? 2 * total : POSTING_BLOCK_MAX;
+}
+
+static void write_byte(PostingList *list, Arena *arena, unsigned char byte) {
+  if (list->last == NULL || list->last_size == list->last_capacity) {
+    size_t total = POSTING_BLOCK_MIN;
+    if (list->last != NULL)
+      total = next_block_size(sizeof(PostingBlock) + list->last_capacity);
+    PostingBlock *block = (PostingBlock *)arena_alloc_aligned(
+        arena, total, alignof(PostingBlock));
+    block->next = NULL;
+    if (list->last != NULL)
+      list->last->next = block;
+    else
+      list->first = block;
+    list->last = block;
+    list->last_size = 0;
+    list->last_capacity = (uint32_t)(total - sizeof(PostingBlock));
+  }
+  list->last->bytes[list->last_size++] = byte;
+}
+
+static void write_varint(PostingList *list, Arena *arena, uint32_t value) {
+  while (value >= 0x80) {
+    write_byte(list, arena, (unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  write_byte(list, arena, (unsigned char)value);
+}
+
+static inline uint32_t varint_size(uint32_t value) {
+  uint32_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/**
+ * @brief Registra um ponto de salto antes da próxima ocorrência.
+ *
+ * Os pontos ficam em um array na arena, realocado com o dobro da
+ * capacidade quando enche (as cópias antigas são abandonadas na arena).
+ */
+static void add_skip(PostingList *list, Arena *arena) {
+  unsigned int n = list->num_songs / POSTING_SKIP_INTERVAL - 1;
+  if ((n & (n - 1)) == 0) {
+    size_t capacity = n > 0 ? 2 * (size_t)n : 1;
+    PostingSkip *skips = (PostingSkip *)arena_alloc_aligned(
+        arena, capacity * sizeof(PostingSkip), alignof(PostingSkip));
+    if (n > 0)
+      memcpy(skips, list->skips, n * sizeof(PostingSkip));
+    list->skips = skips;
+  }
+  PostingSkip *skip = &list->skips[n];
+  skip->block = list->last;
+  skip->song_id = list->last_song_id;
+  skip->offset = (uint16_t)list->last_size;
+  skip->total = (uint16_t)(sizeof(PostingBlock) + list->last_capacity);
+}
+
+/**
+ * @brief Grava o cabeçalho de uma ocorrência; as posições vêm em seguida.
+ */
+static void start_posting(PostingList *list, Arena *arena,
+                          unsigned int song_id, unsigned int count,
+                          uint32_t positions_size) {
+  if (list->num_songs > 0 && list->num_songs % POSTING_SKIP_INTERVAL == 0)
+    add_skip(list, arena);
+  write_varint(list, arena,
+               list->num_songs > 0 ? song_id - list->last_song_id : song_id);
+  write_varint(list, arena, count);
+  write_varint(list, arena, positions_size);
+  list->num_songs++;
+  list->last_song_id = song_id;
+}
+
+void add_posting(PostingList *list, Arena *arena, unsigned int song_id,
+                 unsigned int count, const uint32_t *positions) {
+  uint32_t positions_size = 0, previous = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    positions_size += varint_size(positions[i] - previous);
+    previous = positions[i];
+  }
+  start_posting(list, arena, song_id, count, positions_size);
+  previous = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    write_varint(list, arena, positions[i] - previous);
+    previous = positions[i];
+  }
+}
+
+static void enter_block(PostingCursor *cursor) {
+  const PostingBlock *block = cursor->block;
+  cursor->next = block->bytes;
+  cursor->end = block->bytes + (block == cursor->list->last
+                                    ? cursor->list->last_size
+                                    : cursor->total - sizeof(PostingBlock));
+}
+
+void open_posting_list(PostingCursor *cursor, const PostingList *list) {
+  memset(cursor, 0, sizeof(*cursor));
+  cursor->list = list;
+  cursor->block = list->first;
+  cursor->total = POSTING_BLOCK_MIN;
+  cursor->num_songs = list->num_songs;
+  cursor->num_skips = posting_skip_count(list->num_songs);
+  if (cursor->block != NULL)
+    enter_block(cursor);
+}
+
+void open_posting_bytes(PostingCursor *cursor, const unsigned char *bytes,
+                        size_t size, unsigned int num_songs,
+                        const PostingByteSkip *skips) {
+  memset(cursor, 0, sizeof(*cursor));
+  cursor->bytes = bytes;
+  cursor->byte_skips = skips;
+  cursor->next = bytes;
+  cursor->end = bytes + size;
+  cursor->num_songs = num_songs;
+  cursor->num_skips = skips != NULL ? posting_skip_count(num_songs) : 0;
+}
+
+/**
+ * @brief Lê o próximo byte da lista.
+ *
+ * Em uma lista contígua, ler além do fim marca o cursor como truncado e
+ * devolve 0, que encerra qualquer varint em leitura.
+ */
+static inline unsigned char read_byte(PostingCursor *cursor) {
+  if (__builtin_expect(cursor->next == cursor->end, 0)) {
+    if (cursor->list == NULL) {
+      cursor->truncated = true;
+      return 0;
+    }
+    cursor->block = cursor->block->next;
+    cursor->total = next_block_size(cursor->total);
+    enter_block(cursor);
+  }
+  return *cursor->next++;
+}
+
+static inline uint32_t read_varint(PostingCursor *cursor) {
+  uint32_t result = 0;
+  for (int shift = 0;; shift += 7) {
+    unsigned char byte = read_byte(cursor);
+    if (shift < 32)
+      result |= (uint32_t)(byte & 0x7F) << shift;
+    if (byte < 0x80)
+      return result;
+  }
+}
+
+/**
+ * @brief Pula bytes da lista sem lê-los.
+ */
+static void skip_bytes(PostingCursor *cursor, size_t size) {
+  while (size > (size_t)(cursor->end - cursor->next)) {
+    if (cursor->list == NULL) {
+      cursor->next = cursor->end;
+      cursor->truncated = true;
+      return;
+    }
+    size -= (size_t)(cursor->end - cursor->next);
+    cursor->block = cursor->block->next;
+    cursor->total = next_block_size(cursor->total);
+    enter_block(cursor);
+  }
+  cursor->next += size;
+}
+
+bool posting_cursor_next(PostingCursor *cursor) {
+  if (cursor->positions_size > 0) {
+    skip_bytes(cursor, cursor->positions_size);
+    cursor->positions_size = 0;
+  }
+  if (cursor->index >= cursor->num_songs || cursor->truncated)
+    return false;
+  cursor->song_id += read_varint(cursor);
+  cursor->count = read_varint(cursor);
+  cursor->positions_size = read_varint(cursor);
+  cursor->index++;
+  // Cada posição ocupa pelo menos um byte.
+  if (cursor->list == NULL &&
+      (cursor->truncated || cursor->count > cursor->positions_size ||
+       cursor->positions_size > (size_t)(cursor->end - cursor->next))) {
+    cursor->truncated = true;
+    cursor->positions_size = 0;
+    return false;
+  }
+  return true;
+}
+
+static inline uint32_t skip_song_id(const PostingCursor *cursor,
+                                    unsigned int i) {
+  return cursor->list != NULL ? cursor->list->skips[i].song_id
+                              : cursor->byte_skips[i].song_id;
+}
+
+/**
+ * @brief Posiciona o cursor no ponto de salto i, antes da ocorrência
+ * (i + 1) * POSTING_SKIP_INTERVAL.
+ */
+static void jump_to_skip(PostingCursor *cursor, unsigned int i) {
+  if (cursor->list != NULL) {
+    const PostingSkip *skip = &cursor->list->skips[i];
+    cursor->block = skip->block;
+    cursor->total = skip->total;
+    enter_block(cursor);
+    cursor->next += skip->offset;
+  } else {
+    const PostingByteSkip *skip = &cursor->byte_skips[i];
+    if (skip->offset > (size_t)(cursor->end - cursor->bytes))
+      return;
+    cursor->next = cursor->bytes + skip->offset;
+  }
+  cursor->song_id = skip_song_id(cursor, i);
+  cursor->index = (i + 1) * POSTING_SKIP_INTERVAL;
+  cursor->positions_size = 0;
+}
+
+bool posting_cursor_seek(PostingCursor *cursor, unsigned int song_id) {
+  if (cursor->index > 0 && cursor->song_id >= song_id &&
+      !cursor->truncated)
+    return true;
+
+  // Último ponto adiante da posição atual cuja ocorrência anterior é menor
+  // que song_id: busca exponencial e depois binária.
+  unsigned int low = cursor->index / POSTING_SKIP_INTERVAL;
+  if (low < cursor->num_skips && skip_song_id(cursor, low) < song_id) {
+    unsigned int step = 1, high = low + 1;
+    while (high < cursor->num_skips && skip_song_id(cursor, high) < song_id) {
+      low = high;
+      step *= 2;
+      high = low + step;
+    }
+    if (high > cursor->num_skips)
+      high = cursor->num_skips;
+    while (high - low > 1) {
+      unsigned int mid = low + (high - low) / 2;
+      if (skip_song_id(cursor, mid) < song_id)
+        low = mid;
+      else
+        high = mid;
+    }
+    jump_to_skip(cursor, low);
+  }
+
+  while (posting_cursor_next(cursor)) {
+    if (cursor->song_id >= song_id)
+      return true;
+  }
+  return false;
+}
+
+size_t posting_cursor_positions(const PostingCursor *cursor,
+                                uint32_t *positions) {
+  PostingCursor reader = *cursor;
+  if (reader.list == NULL)
+    reader.end = reader.next + reader.positions_size;
+  uint32_t position = 0;
+  size_t decoded = 0;
+  for (; decoded < cursor->count; decoded++) {
+    position += read_varint(&reader);
+    if (reader.truncated)
+      break;
+    positions[decoded] = position;
+  }
+  return decoded;
+}
+
+void append_posting_cursor(PostingList *destination, Arena *arena,
+                           PostingCursor *source, unsigned int song_offset) {
+  while (posting_cursor_next(source)) {
+    uint32_t size = source->positions_size;
+    start_posting(destination, arena, song_offset + source->song_id,
+                  source->count, size);
+    for (uint32_t i = 0; i < size; i++)
+      write_byte(destination, arena, read_byte(source));
+    source->positions_size = 0;
+  }
+}
+
+void append_postings(PostingList *destination, Arena *arena,
+                     const PostingList *source, unsigned int song_offset) {
+  PostingCursor cursor;
+  open_posting_list(&cursor, source);
+  append_posting_cursor(destination, arena, &cursor, song_offset);
+}
+
+size_t decode_postings(const PostingList *list, Posting *postings,
+                       size_t max) {
+  PostingCursor cursor;
+  open_posting_list(&cursor, list);
+  size_t decoded = 0;
+  while (decoded < max && posting_cursor_next(&cursor)) {
+    postings[decoded].song_id = cursor.song_id;
+    postings[decoded++].count = cursor.count;
+  }
+  return decoded;
+}
+
+size_t decode_posting_bytes(const unsigned char *bytes, size_t size,
+                            unsigned int num_songs, Posting *postings,
+                            size_t max) {
+  PostingCursor cursor;
+  open_posting_bytes(&cursor, bytes, size, num_songs, NULL);
+  size_t decoded = 0;
+  while (decoded < max && posting_cursor_next(&cursor)) {
+    postings[decoded].song_id = cursor.song_id;
+    postings[decoded++].count = cursor.count;
+  }
+  return decoded;
+}
+
+size_t copy_posting_bytes(const PostingList *list, unsigned char *out) {
+  size_t size = 0, total = POSTING_BLOCK_MIN;
+  for (const PostingBlock *block = list->first; block != NULL;
+       block = block->next) {
+    size_t used = block == list->last ? list->last_size
+                                      : total - sizeof(PostingBlock);
+    memcpy(out + size, block->bytes, used);
+    size += used;
+    total = next_block_size(total);
+  }
+  return size;
+}
+
+size_t copy_posting_skips(const PostingList *list, PostingByteSkip *out) {
+  unsigned int num_skips = posting_skip_count(list->num_songs);
+  const PostingBlock *block = list->first;
+  size_t start = 0, total = POSTING_BLOCK_MIN;
+  for (unsigned int i = 0; i < num_skips; i++) {
+    const PostingSkip *skip = &list->skips[i];
+    while (block != skip->block) {
+      start += total - sizeof(PostingBlock);
+      total = next_block_size(total);
+      block = block->next;
+    }
+    out[i].song_id = skip->song_id;
+    out[i].offset = (uint32_t)(start + skip->offset);
+  }
+  return num_skips;
+}
+
+size_t posting_list_size(const PostingList *list) {
+  size_t size = 0, total = POSTING_BLOCK_MIN;
+  for (const PostingBlock *block = list->first; block != NULL;
+       block = block->next) {
+    size += block == list->last ? list->last_size
+                                : total - sizeof(PostingBlock);
+    total = next_block_size(total);
+  }
+  return size;
+}
+
+size_t posting_list_allocated(const PostingList *list) {
+  size_t allocated = 0, total = POSTING_BLOCK_MIN;
+  for (const PostingBlock *block = list->first; block != NULL;
+       block = block->next) {
+    allocated += total;
+    total = next_block_size(total);
+  }
+  unsigned int num_skips = posting_skip_count(list->num_songs);
+  if (num_skips > 0) {
+    size_t capacity = 1;
+    while (capacity < num_skips)
+      capacity *= 2;
+    allocated += capacity * sizeof(PostingSkip);
+  }
+  return allocated;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file prefix.c
+ * @brief Busca por prefixo e ordenação das sugestões pela contagem.
+ */
+
+#include "include/prefix.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CountIndex *count_index = NULL;
+
+#define NO_POSITION UINT32_MAX
+
+size_t prefix_range(const WordArray *arr, const char *prefix, size_t *first) {
+  size_t length = strlen(prefix);
+  size_t low = 0, high = arr->size;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (strcmp(arr->entries[mid]->word, prefix) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  *first = low;
+
+  // A partir de first, as palavras com o prefixo são as que comparam como
+  // iguais a ele nos primeiros length bytes.
+  high = arr->size;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (strncmp(arr->entries[mid]->word, prefix, length) <= 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low - *first;
+}
+
+/**
+ * @brief Escolhe, entre duas posições, a de maior contagem (a menor
+ * posição, nos empates).
+ */
+static inline uint32_t better_position(const CountIndex *index, uint32_t a,
+                                       uint32_t b) {
+  if (b == NO_POSITION)
+    return a;
+  if (a == NO_POSITION)
+    return b;
+  if (index->counts[a] != index->counts[b])
+    return index->counts[a] > index->counts[b] ? a : b;
+  return a < b ? a : b;
+}
+
+CountIndex *build_count_index(uint32_t *counts, size_t size) {
+  CountIndex *index = (CountIndex *)malloc(sizeof(CountIndex));
+  if (index == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para o CountIndex.\n");
+    exit(EXIT_FAILURE);
+  }
+  index->counts = counts;
+  index->size = size;
+  index->leaves = 1;
+  while (index->leaves < size)
+    index->leaves *= 2;
+  index->tree = (uint32_t *)malloc(2 * index->leaves * sizeof(uint32_t));
+  if (index->tree == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para o CountIndex.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i < index->leaves; i++)
+    index->tree[index->leaves + i] = i < size ? (uint32_t)i : NO_POSITION;
+  for (size_t k = index->leaves - 1; k >= 1; k--)
+    index->tree[k] =
+        better_position(index, index->tree[2 * k], index->tree[2 * k + 1]);
+  index->tree[0] = NO_POSITION;
+  return index;
+}
+
+static uint32_t *allocate_counts(size_t size) {
+  uint32_t *counts = (uint32_t *)malloc((size > 0 ? size : 1) *
+                                        sizeof(uint32_t));
+  if (counts == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para as contagens.\n");
+    exit(EXIT_FAILURE);
+  }
+  return counts;
+}
+
+CountIndex *build_word_array_count_index(const WordArray *arr) {
+  uint32_t *counts = allocate_counts(arr->size);
+  for (int i = 0; i < arr->size; i++)
+    counts[i] = arr->entries[i]->total_word_count;
+  return build_count_index(counts, arr->size);
+}
+
+CountIndex *build_snapshot_count_index(const Snapshot *snapshot) {
+  uint32_t *counts = allocate_counts(snapshot->num_words);
+  for (uint32_t i = 0; i < snapshot->num_words; i++)
+    counts[i] = snapshot->words[i].total_word_count;
+  return build_count_index(counts, snapshot->num_words);
+}
+
+/**
+ * @brief Posição de maior contagem em [first, end), que não pode ser vazio.
+ */
+static uint32_t range_maximum(const CountIndex *index, size_t first,
+                              size_t end) {
+  uint32_t best = NO_POSITION;
+  for (size_t l = first + index->leaves, r = end + index->leaves; l < r;
+       l >>= 1, r >>= 1) {
+    if (l & 1)
+      best = better_position(index, best, index->tree[l++]);
+    if (r & 1)
+      best = better_position(index, best, index->tree[--r]);
+  }
+  return best;
+}
+
+/**
+ * @struct RangeCandidate
+ * @brief Subintervalo na fila de prioridade de top_counts_in_range.
+ */
+typedef struct {
+  uint32_t position; /**< Posição de maior contagem do subintervalo. */
+  size_t first;      /**< Primeira posição do subintervalo. */
+  size_t end;        /**< Posição seguinte à última. */
+} RangeCandidate;
+
+static inline bool candidate_before(const CountIndex *index,
+                                    const RangeCandidate *a,
+                                    const RangeCandidate *b) {
+  return better_position(index, a->position, b->position) == a->position;
+}
+
+static void push_candidate(const CountIndex *index, RangeCandidate *heap,
+                           size_t *size, size_t first, size_t end) {
+  if (first >= end)
+    return;
+  RangeCandidate candidate = {range_maximum(index, first, end), first, end};
+  size_t i = (*size)++;
+  while (i > 0 && candidate_before(index, &candidate, &heap[(i - 1) / 2])) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = candidate;
+}
+
+static RangeCandidate pop_candidate(const CountIndex *index,
+                                    RangeCandidate *heap, size_t *size) {
+  RangeCandidate top = heap[0];
+  RangeCandidate last = heap[--*size];
+  size_t i = 0;
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= *size)
+      break;
+    if (child + 1 < *size &&
+        candidate_before(index, &heap[child + 1], &heap[child]))
+      child++;
+    if (!candidate_before(index, &heap[child], &last))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+size_t top_counts_in_range(const CountIndex *index, size_t first, size_t end,
+                           size_t limit, size_t *positions) {
+  if (end > index->size)
+    end = index->size;
+  if (limit == 0 || first >= end)
+    return 0;
+
+  // Cada retirada acrescenta no máximo um candidato à fila.
+  RangeCandidate *heap =
+      (RangeCandidate *)malloc((limit + 1) * sizeof(RangeCandidate));
+  if (heap == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a fila.\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t heap_size = 0, written = 0;
+  push_candidate(index, heap, &heap_size, first, end);
+  while (written < limit && heap_size > 0) {
+    RangeCandidate top = pop_candidate(index, heap, &heap_size);
+    positions[written++] = top.position;
+    push_candidate(index, heap, &heap_size, top.first, top.position);
+    push_candidate(index, heap, &heap_size, top.position + 1, top.end);
+  }
+  free(heap);
+  return written;
+}
+
+void free_count_index(CountIndex *index) {
+  if (index == NULL)
+    return;
+  free(index->counts);
+  free(index->tree);
+  free(index);
+}
+
+WordArray *search_prefix(const WordArray *arr, const CountIndex *index,
+                         const char *prefix, size_t limit, size_t *total) {
+  size_t first;
+  size_t count = prefix_range(arr, prefix, &first);
+  if (total != NULL)
+    *total = count;
+
+  WordArray *results = create_word_array();
+  size_t wanted = limit < count ? limit : count;
+  if (index == NULL) {
+    for (size_t i = 0; i < wanted; i++)
+      add_entry_to_array(results, arr->entries[first + i]);
+    return results;
+  }
+
+  size_t *positions = (size_t *)malloc((wanted + 1) * sizeof(size_t));
+  if (positions == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para as posições.\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t found =
+      top_counts_in_range(index, first, first + count, wanted, positions);
+  for (size_t i = 0; i < found; i++)
+    add_entry_to_array(results, arr->entries[positions[i]]);
+  free(positions);
+  return results;
+}
@@ -0,0 +1,839 @@
+/**
+ * @file query.c
+ * @brief Execução das consultas em modo texto.
+ */
+
+#include "include/query.h"
+#include "include/intersect.h"
+#include "include/prefix.h"
+#include "include/rank.h"
+#include "include/repository.h"
+#include "include/structures.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool parse_query_engine(const char *name, QueryEngine *engine) {
+  static const struct {
+    const char *name;
+    QueryEngine engine;
+  } engines[] = {{"bst", QUERY_ENGINE_BST},
+                 {"avl", QUERY_ENGINE_AVL},
+                 {"array", QUERY_ENGINE_ARRAY},
+                 {"eytzinger", QUERY_ENGINE_EYTZINGER},
+                 {"snapshot", QUERY_ENGINE_SNAPSHOT}};
+  for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+    if (strcmp(name, engines[i].name) == 0) {
+      *engine = engines[i].engine;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Escreve um campo de texto, trocando tabulações e quebras de linha
+ * por espaços.
+ */
+static void write_field(FILE *out, const char *text) {
+  for (const char *p = text; *p != '\0'; p++) {
+    putc(*p == '\t' || *p == '\n' || *p == '\r' ? ' ' : *p, out);
+  }
+}
+
+static void write_hit(FILE *out, const char *word, unsigned int total,
+                      unsigned int count_in_song, const char *title,
+                      const char *author) {
+  fputs("hit\t", out);
+  write_field(out, word);
+  fprintf(out, "\t%u\t%u\t", total, count_in_song);
+  write_field(out, title);
+  putc('\t', out);
+  write_field(out, author);
+  putc('\n', out);
+}
+
+static void write_miss(FILE *out, const char *word) {
+  fputs("miss\t", out);
+  write_field(out, word);
+  putc('\n', out);
+}
+
+static void write_error(QueryContext *context, FILE *out,
+                        const char *message) {
+  context->num_errors++;
+  fprintf(out, "error\t%s\n", message);
+}
+
+static void lookup_word(QueryContext *context, const char *word, FILE *out) {
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const SnapshotWord *found = snapshot_find_word(context->snapshot, word);
+    if (found == NULL) {
+      write_miss(out, word);
+      return;
+    }
+    SnapshotWordText text = snapshot_word_text(context->snapshot, found);
+    write_hit(out, text.word, found->total_word_count,
+              found->word_count_in_song, text.title, text.author);
+    return;
+  }
+
+  WordEntry *entry = NULL;
+  switch (context->engine) {
+  case QUERY_ENGINE_BST:
+    entry = search_bst(bin_tree->root, word);
+    break;
+  case QUERY_ENGINE_AVL:
+    entry = search_avl(avl_tree->root, word);
+    break;
+  case QUERY_ENGINE_ARRAY:
+    if (sorted_word_array == NULL)
+      sorted_word_array = create_word_array();
+    entry = binary_search_array(sorted_word_array, word);
+    break;
+  case QUERY_ENGINE_EYTZINGER:
+    if (eytzinger_array == NULL) {
+      if (sorted_word_array == NULL)
+        sorted_word_array = create_word_array();
+      eytzinger_array = build_eytzinger_array(sorted_word_array);
+    }
+    entry = search_eytzinger(eytzinger_array, word);
+    break;
+  case QUERY_ENGINE_SNAPSHOT:
+    break;
+  }
+  if (entry == NULL) {
+    write_miss(out, word);
+    return;
+  }
+  const SongOccurrence *best = &entry->best_song_occurrence;
+  const Song *song = get_song(song_repository, best->song_id);
+  write_hit(out, entry->word, entry->total_word_count,
+            best->word_count_in_song, song->title, song->author);
+}
+
+static void write_ranked_word(FILE *out, const char *word, unsigned int count) {
+  write_field(out, word);
+  fprintf(out, "\t%u\n", count);
+}
+
+static Node *frequency_root(void) {
+  return avl_frequency_tree == NULL ? NULL : avl_frequency_tree->root;
+}
+
+/**
+ * @brief Completa o cabeçalho já escrito com o número de palavras com
+ * contagem em [min_frequency, max_frequency] e escreve as palavras, em
+ * ordem crescente de frequência.
+ */
+static void write_frequency_range(QueryContext *context,
+                                  unsigned int min_frequency,
+                                  unsigned int max_frequency, FILE *out) {
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    size_t first;
+    size_t count = snapshot_frequency_range(snapshot, min_frequency,
+                                            max_frequency, &first);
+    fprintf(out, "\t%zu\n", count);
+    for (size_t i = first; i < first + count; i++) {
+      const SnapshotWord *word = snapshot_frequency_word(snapshot, i);
+      if (word == NULL) {
+        fputs("\t0\n", out);
+        continue;
+      }
+      write_ranked_word(out, snapshot_word_text(snapshot, word).word,
+                        word->total_word_count);
+    }
+    return;
+  }
+
+  // As palavras são escritas à medida que o cursor avança, sem montar um
+  // array com todos os resultados.
+  Node *root = frequency_root();
+  fprintf(out, "\t%zu\n",
+          count_frequency_range(root, min_frequency, max_frequency));
+  FrequencyCursor cursor;
+  frequency_cursor_start(&cursor, root, min_frequency, max_frequency);
+  for (WordEntry *entry; (entry = frequency_cursor_next(&cursor)) != NULL;) {
+    write_ranked_word(out, entry->word, entry->indexed_count);
+  }
+}
+
+static void query_frequency(QueryContext *context, unsigned int frequency,
+                            FILE *out) {
+  fprintf(out, "frequency\t%u", frequency);
+  write_frequency_range(context, frequency, UINT_MAX, out);
+}
+
+static void query_range(QueryContext *context, unsigned int min_frequency,
+                        unsigned int max_frequency, FILE *out) {
+  fprintf(out, "range\t%u\t%u", min_frequency, max_frequency);
+  write_frequency_range(context, min_frequency, max_frequency, out);
+}
+
+/**
+ * @brief Escreve uma página de até limit palavras com frequência mínima, a
+ * partir do início ou logo após a chave do token "<contagem>:<palavra>".
+ *
+ * O cabeçalho traz o token da página seguinte, ou "-" se não houver mais
+ * palavras.
+ */
+static void query_page(QueryContext *context, unsigned int min_frequency,
+                       unsigned int limit, const char *token, FILE *out) {
+  unsigned int token_count = 0;
+  const char *token_word = NULL;
+  if (token != NULL) {
+    char *end;
+    unsigned long count = strtoul(token, &end, 10);
+    if (*end != ':' || token[0] == '-' || count > 0xFFFFFFFFul) {
+      write_error(context, out, "token inválido");
+      return;
+    }
+    token_count = (unsigned int)count;
+    token_word = end + 1;
+  }
+
+  // A página é escrita em um buffer próprio porque o cabeçalho depende do
+  // que vem depois da última palavra; a memória é limitada pelo limite.
+  char *page = NULL;
+  size_t page_size = 0;
+  FILE *lines = open_memstream(&page, &page_size);
+  if (lines == NULL) {
+    write_error(context, out, "falha ao montar a página");
+    return;
+  }
+  unsigned int written = 0;
+  unsigned int last_count = 0;
+  const char *last_word = NULL;
+  bool more;
+
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    size_t position = snapshot_frequency_lower_bound(snapshot, min_frequency);
+    if (token != NULL) {
+      size_t after =
+          snapshot_frequency_after(snapshot, token_count, token_word);
+      position = after > position ? after : position;
+    }
+    for (; position < snapshot->num_words && written < limit; position++) {
+      const SnapshotWord *word = snapshot_frequency_word(snapshot, position);
+      if (word == NULL)
+        continue;
+      last_word = snapshot_word_text(snapshot, word).word;
+      last_count = word->total_word_count;
+      write_ranked_word(lines, last_word, last_count);
+      written++;
+    }
+    more = position < snapshot->num_words;
+  } else {
+    FrequencyCursor cursor;
+    if (token == NULL || token_count < min_frequency) {
+      frequency_cursor_start(&cursor, frequency_root(), min_frequency,
+                             UINT_MAX);
+    } else {
+      frequency_cursor_start_after(&cursor, frequency_root(), token_count,
+                                   token_word, UINT_MAX);
+    }
+    WordEntry *entry = NULL;
+    while (written < limit &&
+           (entry = frequency_cursor_next(&cursor)) != NULL) {
+      last_word = entry->word;
+      last_count = entry->indexed_count;
+      write_ranked_word(lines, last_word, last_count);
+      written++;
+    }
+    more = frequency_cursor_next(&cursor) != NULL;
+  }
+  fclose(lines);
+
+  fprintf(out, "page\t%u\t%u\t", min_frequency, written);
+  if (more && last_word != NULL) {
+    fprintf(out, "%u:", last_count);
+    write_field(out, last_word);
+  } else {
+    putc('-', out);
+  }
+  putc('\n', out);
+  fwrite(page, 1, page_size, out);
+  free(page);
+}
+
+static void query_count(QueryContext *context, unsigned int min_frequency,
+                        unsigned int max_frequency, FILE *out) {
+  size_t count;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    size_t first;
+    count = snapshot_frequency_range(context->snapshot, min_frequency,
+                                     max_frequency, &first);
+  } else {
+    count = count_frequency_range(frequency_root(), min_frequency,
+                                  max_frequency);
+  }
+  fprintf(out, "count\t%u\t%u\t%zu\n", min_frequency, max_frequency, count);
+}
+
+static void query_top(QueryContext *context, size_t k, FILE *out) {
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    size_t n = k < snapshot->num_words ? k : snapshot->num_words;
+    fprintf(out, "top\t%zu\t%zu\n", k, n);
+    for (size_t i = 1; i <= n; i++) {
+      const SnapshotWord *word =
+          snapshot_frequency_word(snapshot, snapshot->num_words - i);
+      if (word == NULL) {
+        fputs("\t0\n", out);
+        continue;
+      }
+      write_ranked_word(out, snapshot_word_text(snapshot, word).word,
+                        word->total_word_count);
+    }
+    return;
+  }
+
+  WordArray *results = search_top_frequency(frequency_root(), k);
+  fprintf(out, "top\t%zu\t%d\n", k, results->size);
+  for (int i = 0; i < results->size; i++) {
+    write_ranked_word(out, results->entries[i]->word,
+                      results->entries[i]->indexed_count);
+  }
+  free_word_array(results);
+}
+
+/**
+ * @brief Posição de uma palavra entre as mais frequentes (1 para a mais
+ * frequente), na ordem de top.
+ */
+static void query_rank(QueryContext *context, const char *word, FILE *out) {
+  size_t position = 0;
+  unsigned int count = 0;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    const SnapshotWord *found = snapshot_find_word(snapshot, word);
+    size_t index = found == NULL ? snapshot->num_words
+                                 : snapshot_frequency_position(snapshot, found);
+    if (index < snapshot->num_words) {
+      position = snapshot->num_words - index;
+      count = found->total_word_count;
+    }
+  } else {
+    const WordEntry *entry = NULL;
+    if (song_repository != NULL)
+      entry = find_word(&song_repository->dictionary, word);
+    Node *root = frequency_root();
+    if (entry != NULL && entry->indexed_count != 0) {
+      position = size_node(root) - rank_frequency(root, entry);
+      count = entry->indexed_count;
+    }
+  }
+  if (position == 0) {
+    write_miss(out, word);
+    return;
+  }
+  fputs("rank\t", out);
+  write_field(out, word);
+  fprintf(out, "\t%zu\t%u\n", position, count);
+}
+
+static void query_select(QueryContext *context, size_t position, FILE *out) {
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    const SnapshotWord *word =
+        position >= 1 && position <= snapshot->num_words
+            ? snapshot_frequency_word(snapshot, snapshot->num_words - position)
+            : NULL;
+    if (word == NULL) {
+      write_error(context, out, "posição fora do intervalo");
+      return;
+    }
+    fprintf(out, "select\t%zu\t", position);
+    write_ranked_word(out, snapshot_word_text(snapshot, word).word,
+                      word->total_word_count);
+    return;
+  }
+
+  Node *root = frequency_root();
+  size_t size = size_node(root);
+  WordEntry *entry = position >= 1 && position <= size
+                         ? select_frequency(root, size - position)
+                         : NULL;
+  if (entry == NULL) {
+    write_error(context, out, "posição fora do intervalo");
+    return;
+  }
+  fprintf(out, "select\t%zu\t", position);
+  write_ranked_word(out, entry->word, entry->indexed_count);
+}
+
+/**
+ * @brief Escreve as palavras que começam com um prefixo, em ordem
+ * alfabética ou, se ranked, da maior contagem total para a menor.
+ *
+ * O CountIndex usado na ordenação é montado na primeira consulta.
+ */
+static void query_prefix(QueryContext *context, const char *prefix,
+                         size_t limit, bool ranked, FILE *out) {
+  const char *name = ranked ? "complete" : "prefix";
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    const Snapshot *snapshot = context->snapshot;
+    size_t first;
+    size_t total = snapshot_prefix_range(snapshot, prefix, &first);
+    size_t wanted = limit < total ? limit : total;
+    size_t *positions = (size_t *)malloc((wanted + 1) * sizeof(size_t));
+    if (positions == NULL) {
+      write_error(context, out, "falha na alocação das posições");
+      return;
+    }
+    if (ranked) {
+      if (context->snapshot_counts == NULL)
+        context->snapshot_counts = build_snapshot_count_index(snapshot);
+      top_counts_in_range(context->snapshot_counts, first, first + total,
+                          wanted, positions);
+    } else {
+      for (size_t i = 0; i < wanted; i++)
+        positions[i] = first + i;
+    }
+
+    fprintf(out, "%s\t", name);
+    write_field(out, prefix);
+    fprintf(out, "\t%zu\t%zu\n", total, wanted);
+    for (size_t i = 0; i < wanted; i++) {
+      const SnapshotWord *word = &snapshot->words[positions[i]];
+      write_ranked_word(out, snapshot_word_text(snapshot, word).word,
+                        word->total_word_count);
+    }
+    free(positions);
+    return;
+  }
+
+  if (sorted_word_array == NULL)
+    sorted_word_array = create_word_array();
+  if (ranked && count_index == NULL)
+    count_index = build_word_array_count_index(sorted_word_array);
+  size_t total;
+  WordArray *results = search_prefix(sorted_word_array,
+                                     ranked ? count_index : NULL, prefix,
+                                     limit, &total);
+  fprintf(out, "%s\t", name);
+  write_field(out, prefix);
+  fprintf(out, "\t%zu\t%d\n", total, results->size);
+  for (int i = 0; i < results->size; i++) {
+    write_ranked_word(out, results->entries[i]->word,
+                      results->entries[i]->total_word_count);
+  }
+  free_word_array(results);
+}
+
+/**
+ * @brief Escreve o título e o autor de uma música, separados por
+ * tabulação.
+ */
+static void write_song_text(QueryContext *context, unsigned int song_id,
+                            FILE *out) {
+  const char *title, *author;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    snapshot_song_text(context->snapshot, song_id, &title, &author);
+  } else {
+    const Song *song = get_song(song_repository, song_id);
+    title = song->title;
+    author = song->author;
+  }
+  write_field(out, title);
+  putc('\t', out);
+  write_field(out, author);
+}
+
+/**
+ * @brief Escreve as primeiras músicas da lista de ocorrências de uma
+ * palavra, em ordem de identificador.
+ */
+static void query_songs(QueryContext *context, const char *word, size_t limit,
+                        FILE *out) {
+  const SnapshotWord *found = NULL;
+  const PostingList *list = NULL;
+  size_t num_songs = 0;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    found = snapshot_find_word(context->snapshot, word);
+    num_songs = found != NULL ? found->num_songs : 0;
+  } else if (song_repository != NULL) {
+    const WordEntry *entry = find_word(&song_repository->dictionary, word);
+    if (entry != NULL) {
+      list = word_postings(&song_repository->dictionary, entry);
+      num_songs = list->num_songs;
+    }
+  }
+  if (found == NULL && list == NULL) {
+    write_miss(out, word);
+    return;
+  }
+
+  size_t wanted = limit < num_songs ? limit : num_songs;
+  Posting *postings = (Posting *)malloc((wanted + 1) * sizeof(Posting));
+  if (postings == NULL) {
+    write_error(context, out, "falha na alocação das ocorrências");
+    return;
+  }
+  if (found != NULL)
+    wanted = snapshot_word_postings(context->snapshot, found, postings, wanted);
+  else
+    wanted = decode_postings(list, postings, wanted);
+
+  fputs("songs\t", out);
+  write_field(out, word);
+  fprintf(out, "\t%zu\t%zu\n", num_songs, wanted);
+  for (size_t i = 0; i < wanted; i++) {
+    fprintf(out, "%u\t%u\t", postings[i].song_id, postings[i].count);
+    write_song_text(context, postings[i].song_id, out);
+    putc('\n', out);
+  }
+  free(postings);
+}
+
+/**
+ * @brief Escreve as primeiras músicas que contêm todas as palavras de um
+ * texto (ou, se phrase, a frase), em ordem de identificador.
+ */
+static void query_words(QueryContext *context, const char *name,
+                        const char *text, bool phrase, size_t limit,
+                        FILE *out) {
+  uint32_t *songs = NULL;
+  size_t num_songs = 0, num_terms = 0;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    num_songs = search_text(text, phrase, lookup_snapshot_term,
+                            context->snapshot, &songs, &num_terms);
+  } else if (song_repository != NULL) {
+    num_songs = search_text(text, phrase, lookup_dictionary_term,
+                            &song_repository->dictionary, &songs,
+                            &num_terms);
+  }
+  if (songs != NULL && num_terms == 0) {
+    free(songs);
+    write_error(context, out, "nenhuma palavra com 3 letras ou mais");
+    return;
+  }
+
+  size_t wanted = limit < num_songs ? limit : num_songs;
+  fprintf(out, "%s\t%zu\t%zu\n", name, num_songs, wanted);
+  for (size_t i = 0; i < wanted; i++) {
+    fprintf(out, "%u\t", songs[i]);
+    write_song_text(context, songs[i], out);
+    putc('\n', out);
+  }
+  free(songs);
+}
+
+/**
+ * @brief Escreve as músicas mais relevantes para as palavras de um texto,
+ * da mais relevante para a menos relevante.
+ */
+static void query_relevant(QueryContext *context, const char *text,
+                           size_t limit, FILE *out) {
+  RankedSong *songs = NULL;
+  size_t num_songs = 0, num_terms = 0;
+  bool ranked = true;
+  RankCorpus corpus;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    snapshot_rank_corpus(context->snapshot, &corpus);
+    num_songs = rank_text(text, rank_snapshot_term, context->snapshot,
+                          &corpus, limit, &songs, &num_terms);
+  } else if (song_repository != NULL) {
+    repository_rank_corpus(song_repository, &corpus);
+    num_songs = rank_text(text, rank_repository_term, song_repository,
+                          &corpus, limit, &songs, &num_terms);
+  } else {
+    ranked = false;
+  }
+  if (ranked && songs == NULL) {
+    write_error(context, out, "falha na alocação do resultado");
+    return;
+  }
+  if (ranked && num_terms == 0) {
+    free(songs);
+    write_error(context, out, "nenhuma palavra com 3 letras ou mais");
+    return;
+  }
+
+  fprintf(out, "relevant\t%zu\n", num_songs);
+  for (size_t i = 0; i < num_songs; i++) {
+    fprintf(out, "%u\t%.4f\t", songs[i].song_id, songs[i].score);
+    write_song_text(context, songs[i].song_id, out);
+    putc('\n', out);
+  }
+  free(songs);
+}
+
+/**
+ * @brief Escreve o tamanho do índice: músicas, palavras distintas e
+ * ocorrências indexadas.
+ */
+static void query_stats(QueryContext *context, FILE *out) {
+  unsigned long long songs = 0, words = 0, occurrences = 0;
+  if (context->engine == QUERY_ENGINE_SNAPSHOT) {
+    songs = context->snapshot->num_songs;
+    words = context->snapshot->num_words;
+    occurrences = context->snapshot->total_length;
+  } else if (song_repository != NULL) {
+    songs = song_repository->num_songs;
+    words = sorted_word_array != NULL ? sorted_word_array->size : 0;
+    occurrences = song_repository->total_length;
+  }
+  fprintf(out, "stats\t%llu\t%llu\t%llu\n", songs, words, occurrences);
+}
+
+/**
+ * @brief Converte um argumento numérico (de 0 a 2^32 - 1).
+ */
+static bool parse_number(const char *argument, unsigned int *value) {
+  char *end;
+  unsigned long number = strtoul(argument, &end, 10);
+  if (*end != '\0' || argument[0] == '-' || number > 0xFFFFFFFFul)
+    return false;
+  *value = (unsigned int)number;
+  return true;
+}
+
+typedef void (*QueryHandler)(QueryContext *context, char **arguments,
+                             int num_arguments, FILE *out);
+
+static void handle_lookup(QueryContext *context, char **arguments,
+                          int num_arguments, FILE *out) {
+  lookup_word(context, arguments[0], out);
+}
+
+static void handle_rank(QueryContext *context, char **arguments,
+                        int num_arguments, FILE *out) {
+  query_rank(context, arguments[0], out);
+}
+
+static void handle_frequency(QueryContext *context, char **arguments,
+                             int num_arguments, FILE *out) {
+  unsigned int frequency;
+  if (!parse_number(arguments[0], &frequency)) {
+    write_error(context, out, "frequência inválida");
+    return;
+  }
+  query_frequency(context, frequency, out);
+}
+
+static void handle_top(QueryContext *context, char **arguments,
+                       int num_arguments, FILE *out) {
+  unsigned int k;
+  if (!parse_number(arguments[0], &k)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  query_top(context, k, out);
+}
+
+static void handle_select(QueryContext *context, char **arguments,
+                          int num_arguments, FILE *out) {
+  unsigned int position;
+  if (!parse_number(arguments[0], &position)) {
+    write_error(context, out, "posição inválida");
+    return;
+  }
+  query_select(context, position, out);
+}
+
+static void handle_range(QueryContext *context, char **arguments,
+                         int num_arguments, FILE *out) {
+  unsigned int min_frequency, max_frequency;
+  if (!parse_number(arguments[0], &min_frequency) ||
+      !parse_number(arguments[1], &max_frequency)) {
+    write_error(context, out, "frequência inválida");
+    return;
+  }
+  query_range(context, min_frequency, max_frequency, out);
+}
+
+static void handle_count(QueryContext *context, char **arguments,
+                         int num_arguments, FILE *out) {
+  unsigned int min_frequency, max_frequency;
+  if (!parse_number(arguments[0], &min_frequency) ||
+      !parse_number(arguments[1], &max_frequency)) {
+    write_error(context, out, "frequência inválida");
+    return;
+  }
+  query_count(context, min_frequency, max_frequency, out);
+}
+
+static void handle_page(QueryContext *context, char **arguments,
+                        int num_arguments, FILE *out) {
+  unsigned int min_frequency, limit;
+  if (!parse_number(arguments[0], &min_frequency) ||
+      !parse_number(arguments[1], &limit) || limit == 0) {
+    write_error(context, out, "frequência ou limite inválido");
+    return;
+  }
+  query_page(context, min_frequency, limit,
+             num_arguments == 3 ? arguments[2] : NULL, out);
+}
+
+static void handle_prefix(QueryContext *context, char **arguments,
+                          int num_arguments, FILE *out) {
+  unsigned int limit;
+  if (!parse_number(arguments[1], &limit)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  query_prefix(context, arguments[0], limit, false, out);
+}
+
+static void handle_complete(QueryContext *context, char **arguments,
+                            int num_arguments, FILE *out) {
+  unsigned int limit;
+  if (!parse_number(arguments[1], &limit)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  query_prefix(context, arguments[0], limit, true, out);
+}
+
+static void handle_songs(QueryContext *context, char **arguments,
+                         int num_arguments, FILE *out) {
+  unsigned int limit;
+  if (!parse_number(arguments[1], &limit)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  query_songs(context, arguments[0], limit, out);
+}
+
+/**
+ * @brief Junta as palavras de uma consulta (após o limite) em um texto.
+ * @return O texto, que o chamador libera com free, ou NULL se a alocação
+ * falhar.
+ */
+static char *join_words(char **arguments, int num_arguments) {
+  size_t length = 0;
+  for (int i = 1; i < num_arguments; i++)
+    length += strlen(arguments[i]) + 1;
+  char *text = (char *)malloc(length);
+  if (text == NULL)
+    return NULL;
+  char *end = text;
+  for (int i = 1; i < num_arguments; i++) {
+    size_t word_length = strlen(arguments[i]);
+    memcpy(end, arguments[i], word_length);
+    end += word_length;
+    *end++ = i + 1 < num_arguments ? ' ' : '\0';
+  }
+  return text;
+}
+
+/**
+ * @brief Executa uma consulta and ou phrase.
+ */
+static void handle_words(QueryContext *context, const char *name,
+                         bool phrase, char **arguments, int num_arguments,
+                         FILE *out) {
+  unsigned int limit;
+  if (!parse_number(arguments[0], &limit)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  char *text = join_words(arguments, num_arguments);
+  if (text == NULL) {
+    write_error(context, out, "falha na alocação da consulta");
+    return;
+  }
+  query_words(context, name, text, phrase, limit, out);
+  free(text);
+}
+
+static void handle_and(QueryContext *context, char **arguments,
+                       int num_arguments, FILE *out) {
+  handle_words(context, "and", false, arguments, num_arguments, out);
+}
+
+static void handle_phrase(QueryContext *context, char **arguments,
+                          int num_arguments, FILE *out) {
+  handle_words(context, "phrase", true, arguments, num_arguments, out);
+}
+
+static void handle_relevant(QueryContext *context, char **arguments,
+                            int num_arguments, FILE *out) {
+  unsigned int limit;
+  if (!parse_number(arguments[0], &limit)) {
+    write_error(context, out, "quantidade inválida");
+    return;
+  }
+  char *text = join_words(arguments, num_arguments);
+  if (text == NULL) {
+    write_error(context, out, "falha na alocação da consulta");
+    return;
+  }
+  query_relevant(context, text, limit, out);
+  free(text);
+}
+
+static void handle_stats(QueryContext *context, char **arguments,
+                         int num_arguments, FILE *out) {
+  query_stats(context, out);
+}
+
+#define MAX_QUERY_ARGUMENTS 17
+
+// Consultas reconhecidas, com o número mínimo e máximo de argumentos.
+static const struct {
+  const char *name;
+  int min_arguments;
+  int max_arguments;
+  QueryHandler handler;
+} query_commands[] = {{"lookup", 1, 1, handle_lookup},
+                      {"frequency", 1, 1, handle_frequency},
+                      {"top", 1, 1, handle_top},
+                      {"rank", 1, 1, handle_rank},
+                      {"select", 1, 1, handle_select},
+                      {"range", 2, 2, handle_range},
+                      {"count", 2, 2, handle_count},
+                      {"page", 2, 3, handle_page},
+                      {"prefix", 2, 2, handle_prefix},
+                      {"complete", 2, 2, handle_complete},
+                      {"songs", 2, 2, handle_songs},
+                      {"and", 2, MAX_QUERY_ARGUMENTS, handle_and},
+                      {"phrase", 2, MAX_QUERY_ARGUMENTS, handle_phrase},
+                      {"relevant", 2, MAX_QUERY_ARGUMENTS, handle_relevant},
+                      {"stats", 0, 0, handle_stats}};
+
+void execute_query(QueryContext *context, char *line, FILE *out) {
+  char *save_ptr;
+  char *command = strtok_r(line, " \t\r", &save_ptr);
+  if (command == NULL || command[0] == '#') {
+    return;
+  }
+  char *arguments[MAX_QUERY_ARGUMENTS + 1];
+  int num_arguments = 0;
+  while (num_arguments <= MAX_QUERY_ARGUMENTS &&
+         (arguments[num_arguments] = strtok_r(NULL, " \t\r", &save_ptr)) !=
+             NULL) {
+    num_arguments++;
+  }
+  context->num_queries++;
+
+  for (size_t i = 0; i < sizeof(query_commands) / sizeof(query_commands[0]);
+       i++) {
+    if (strcmp(command, query_commands[i].name) != 0)
+      continue;
+    if (num_arguments < query_commands[i].min_arguments ||
+        num_arguments > query_commands[i].max_arguments) {
+      write_error(context, out, "número de argumentos inválido");
+      return;
+    }
+    query_commands[i].handler(context, arguments, num_arguments, out);
+    return;
+  }
+  write_error(context, out, "consulta desconhecida");
+}
+
+void run_query_stream(QueryContext *context, FILE *in, FILE *out) {
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  while ((length = getline(&line, &capacity, in)) > 0) {
+    if (line[length - 1] == '\n') {
+      line[length - 1] = '\0';
+    }
+    execute_query(context, line, out);
+  }
+  free(line);
+}
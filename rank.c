@@ -0,0 +1,273 @@
+/**
+ * @file rank.c
+ * @brief Ranqueamento BM25 com o algoritmo max-score.
+ */
+
+#include "include/rank.h"
+#include "include/tokenize.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Identificador dos cursores que já chegaram ao fim da lista. */
+#define EXHAUSTED UINT32_MAX
+
+/**
+ * @struct ScoredTerm
+ * @brief Uma palavra durante o ranqueamento.
+ */
+typedef struct {
+  PostingCursor *cursor; /**< Cursor da lista (de RankTerm). */
+  double weight;         /**< idf vezes as repetições na consulta. */
+  double bound;          /**< Limite superior da contribuição. */
+  uint32_t current;      /**< Música atual do cursor, ou EXHAUSTED. */
+} ScoredTerm;
+
+static void *allocate_or_exit(size_t size) {
+  void *memory = malloc(size > 0 ? size : 1);
+  if (memory == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para a consulta.\n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+static inline double term_score(const ScoredTerm *term, unsigned int count,
+                                double normalization) {
+  return term->weight * count * (BM25_K1 + 1) / (count + normalization);
+}
+
+static inline void advance(ScoredTerm *term) {
+  term->current =
+      posting_cursor_next(term->cursor) ? term->cursor->song_id : EXHAUSTED;
+}
+
+/**
+ * @brief Indica se a música a é pior que b no resultado: menos relevante
+ * ou, no empate, com identificador maior.
+ */
+static inline bool worse(const RankedSong *a, const RankedSong *b) {
+  return a->score < b->score ||
+         (a->score == b->score && a->song_id > b->song_id);
+}
+
+/**
+ * @brief Desce a posição i de um heap de mínimo (a pior música na raiz).
+ */
+static void sift_down(RankedSong *heap, size_t size, size_t i) {
+  for (;;) {
+    size_t smallest = i, left = 2 * i + 1, right = left + 1;
+    if (left < size && worse(&heap[left], &heap[smallest]))
+      smallest = left;
+    if (right < size && worse(&heap[right], &heap[smallest]))
+      smallest = right;
+    if (smallest == i)
+      return;
+    RankedSong swap = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = swap;
+    i = smallest;
+  }
+}
+
+static void sift_up(RankedSong *heap, size_t i) {
+  while (i > 0 && worse(&heap[i], &heap[(i - 1) / 2])) {
+    RankedSong swap = heap[i];
+    heap[i] = heap[(i - 1) / 2];
+    heap[(i - 1) / 2] = swap;
+    i = (i - 1) / 2;
+  }
+}
+
+size_t rank_terms(RankTerm *terms, size_t num_terms, const RankCorpus *corpus,
+                  size_t k, RankedSong *out) {
+  if (k == 0 || num_terms == 0)
+    return 0;
+
+  // Pesos e limites, em ordem crescente de limite; bounds[i] é a soma dos
+  // limites das palavras 0 a i.
+  ScoredTerm *scored =
+      (ScoredTerm *)allocate_or_exit(num_terms * sizeof(ScoredTerm));
+  double *bounds = (double *)allocate_or_exit(num_terms * sizeof(double));
+  double num_songs = corpus->num_songs;
+  for (size_t i = 0; i < num_terms; i++) {
+    double n = terms[i].cursor.num_songs;
+    if (n > num_songs)
+      n = num_songs;
+    double idf = log(1 + (num_songs - n + 0.5) / (n + 0.5));
+    // O limite usa a maior contagem e a normalização de uma música de
+    // tamanho zero.
+    ScoredTerm term = {&terms[i].cursor, idf * terms[i].repeats, 0, 0};
+    term.bound = term_score(&term, terms[i].max_count, BM25_K1 * (1 - BM25_B));
+    size_t j = i;
+    while (j > 0 && scored[j - 1].bound > term.bound) {
+      scored[j] = scored[j - 1];
+      j--;
+    }
+    scored[j] = term;
+  }
+  double sum = 0;
+  for (size_t i = 0; i < num_terms; i++) {
+    sum += scored[i].bound;
+    bounds[i] = sum;
+    advance(&scored[i]);
+  }
+
+  // As palavras antes de essential só são consultadas nas candidatas
+  // geradas pelas demais: sozinhas, não alcançam o limiar.
+  size_t essential = 0, size = 0;
+  double threshold = 0;
+  for (;;) {
+    uint32_t song_id = EXHAUSTED;
+    for (size_t i = essential; i < num_terms; i++) {
+      if (scored[i].current < song_id)
+        song_id = scored[i].current;
+    }
+    if (song_id == EXHAUSTED)
+      break;
+
+    // Uma música fora do catálogo só aparece em um índice corrompido.
+    bool known = song_id < corpus->num_songs;
+    double normalization = 0, score = 0;
+    if (known) {
+      double relative = corpus->lengths[song_id] / corpus->average_length;
+      normalization = BM25_K1 * (1 - BM25_B + BM25_B * relative);
+    }
+    for (size_t i = essential; i < num_terms; i++) {
+      if (scored[i].current == song_id) {
+        score += term_score(&scored[i], scored[i].cursor->count,
+                            normalization);
+        advance(&scored[i]);
+      }
+    }
+    if (!known)
+      continue;
+    for (size_t i = essential; i-- > 0;) {
+      if (size == k && score + bounds[i] <= threshold)
+        break;
+      PostingCursor *cursor = scored[i].cursor;
+      if (posting_cursor_seek(cursor, song_id) && cursor->song_id == song_id)
+        score += term_score(&scored[i], cursor->count, normalization);
+    }
+
+    // As músicas chegam em ordem crescente, de modo que um empate com o
+    // limiar perde para as que já estão no resultado.
+    RankedSong song = {song_id, score};
+    if (size < k) {
+      out[size] = song;
+      sift_up(out, size++);
+    } else if (worse(&out[0], &song)) {
+      out[0] = song;
+      sift_down(out, size, 0);
+    } else {
+      continue;
+    }
+    if (size == k) {
+      threshold = out[0].score;
+      while (essential < num_terms && bounds[essential] <= threshold)
+        essential++;
+    }
+  }
+  free(bounds);
+  free(scored);
+
+  // Ordena o heap retirando a pior música para o fim.
+  for (size_t end = size; end > 1; end--) {
+    RankedSong swap = out[0];
+    out[0] = out[end - 1];
+    out[end - 1] = swap;
+    sift_down(out, end - 1, 0);
+  }
+  return size;
+}
+
+void repository_rank_corpus(const Repository *repo, RankCorpus *corpus) {
+  corpus->lengths = repo->song_lengths;
+  corpus->num_songs = (unsigned int)repo->num_songs;
+  corpus->average_length =
+      repo->num_songs > 0 ? (double)repo->total_length / repo->num_songs : 0;
+  if (corpus->average_length <= 0)
+    corpus->average_length = 1;
+}
+
+void snapshot_rank_corpus(const Snapshot *snapshot, RankCorpus *corpus) {
+  corpus->lengths = snapshot->song_lengths;
+  corpus->num_songs = snapshot->num_songs;
+  corpus->average_length =
+      snapshot->num_songs > 0
+          ? (double)snapshot->total_length / snapshot->num_songs
+          : 0;
+  if (corpus->average_length <= 0)
+    corpus->average_length = 1;
+}
+
+bool rank_repository_term(const void *index, const char *word,
+                          RankTerm *term) {
+  const Repository *repo = (const Repository *)index;
+  const WordEntry *entry = find_word(&repo->dictionary, word);
+  if (entry == NULL)
+    return false;
+  open_posting_list(&term->cursor, word_postings(&repo->dictionary, entry));
+  term->max_count = entry->best_song_occurrence.word_count_in_song;
+  return true;
+}
+
+bool rank_snapshot_term(const void *index, const char *word, RankTerm *term) {
+  const Snapshot *snapshot = (const Snapshot *)index;
+  const SnapshotWord *found = snapshot_find_word(snapshot, word);
+  if (found == NULL)
+    return false;
+  snapshot_word_cursor(snapshot, found, &term->cursor);
+  term->max_count = found->word_count_in_song;
+  return true;
+}
+
+size_t rank_text(const char *text, RankLookup lookup, const void *index,
+                 const RankCorpus *corpus, size_t k, RankedSong **songs,
+                 size_t *num_terms) {
+  size_t length = strlen(text);
+  char *normalized = (char *)allocate_or_exit(length + TOKENIZE_PADDING);
+  TokenSpan *tokens =
+      (TokenSpan *)allocate_or_exit((length / 2 + 1) * sizeof(TokenSpan));
+  size_t num_tokens = tokenize_line(text, length, normalized, tokens);
+  RankTerm *terms =
+      (RankTerm *)allocate_or_exit((num_tokens + 1) * sizeof(RankTerm));
+  const char **words =
+      (const char **)allocate_or_exit((num_tokens + 1) * sizeof(char *));
+
+  // Cada token termina antes do início do seguinte, de modo que o '\0'
+  // pode ser escrito logo após ele. Uma palavra repetida abre uma só lista.
+  size_t num_found = 0;
+  *num_terms = 0;
+  for (size_t t = 0; t < num_tokens; t++) {
+    if (tokens[t].length < 3)
+      continue;
+    char *word = normalized + tokens[t].offset;
+    word[tokens[t].length] = '\0';
+    (*num_terms)++;
+    size_t i = 0;
+    while (i < num_found && strcmp(words[i], word) != 0)
+      i++;
+    if (i < num_found) {
+      terms[i].repeats++;
+    } else if (lookup(index, word, &terms[num_found])) {
+      terms[num_found].repeats = 1;
+      words[num_found++] = word;
+    }
+  }
+
+  // Só as músicas do catálogo entram no resultado: um k maior, vindo da
+  // consulta, não aumenta a alocação.
+  if (k > corpus->num_songs)
+    k = corpus->num_songs;
+  size_t num_songs = 0;
+  *songs = (RankedSong *)malloc((k + 1) * sizeof(RankedSong));
+  if (*songs != NULL)
+    num_songs = rank_terms(terms, num_found, corpus, k, *songs);
+  free(words);
+  free(terms);
+  free(tokens);
+  free(normalized);
+  return num_songs;
+}
@@ -6,27 +6,116 @@
  * e metadados de arquivos de texto de músicas.
  */
 
+#include "include/prefix.h"
 #include "include/repository.h"
+#include "include/tokenize.h"
 #include <ctype.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Repository *song_repository = NULL;
+
+Repository *create_repository() {
+  Repository *repo = (Repository *)calloc(1, sizeof(Repository));
+  if (repo == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para Repository.\n");
+    exit(EXIT_FAILURE);
+  }
+  arena_init(&repo->strings, 0);
+  init_dictionary(&repo->dictionary);
+  arena_init(&repo->nodes, 0);
+  arena_init(&repo->frequency_nodes, 0);
+  return repo;
+}
 
 /**
- * @brief Converte uma string para minúsculas.
- * @param s A string a ser convertida.
+ * @brief Garante espaço para mais count músicas no catálogo.
  */
+static void reserve_songs(Repository *repo, int count) {
+  if (repo->num_songs + count <= repo->songs_capacity) {
+    return;
+  }
+  int capacity = repo->songs_capacity ? repo->songs_capacity : 16;
+  while (capacity < repo->num_songs + count) {
+    capacity *= 2;
+  }
+  repo->songs = (Song *)realloc(repo->songs, capacity * sizeof(Song));
+  repo->song_lengths = (uint32_t *)realloc(repo->song_lengths,
+                                           capacity * sizeof(uint32_t));
+  if (repo->songs == NULL || repo->song_lengths == NULL) {
+    fprintf(stderr, "Falha no realloc do catálogo de músicas.\n");
+    exit(EXIT_FAILURE);
+  }
+  repo->songs_capacity = capacity;
+}
+
+unsigned int add_song(Repository *repo, char *title, char *author,
+                      char **lines, int number_of_lines, unsigned int length) {
+  reserve_songs(repo, 1);
+  Song *song = &repo->songs[repo->num_songs];
+  song->title = title;
+  song->author = author;
+  song->number_of_lines = number_of_lines;
+  song->lyrics_lines = NULL;
+  if (number_of_lines > 0) {
+    song->lyrics_lines = (char **)arena_alloc(
+        &repo->strings, number_of_lines * sizeof(char *));
+    memcpy(song->lyrics_lines, lines, number_of_lines * sizeof(char *));
+  }
+  repo->song_lengths[repo->num_songs] = length;
+  repo->total_length += length;
+  return (unsigned int)repo->num_songs++;
+}
+
+unsigned int move_songs(Repository *destination, Repository *source) {
+  unsigned int offset = (unsigned int)destination->num_songs;
+  reserve_songs(destination, source->num_songs);
+  memcpy(destination->songs + destination->num_songs, source->songs,
+         source->num_songs * sizeof(Song));
+  memcpy(destination->song_lengths + destination->num_songs,
+         source->song_lengths, source->num_songs * sizeof(uint32_t));
+  destination->num_songs += source->num_songs;
+  destination->total_length += source->total_length;
+  arena_adopt(&destination->strings, &source->strings);
+
+  free(source->songs);
+  free(source->song_lengths);
+  source->songs = NULL;
+  source->song_lengths = NULL;
+  source->total_length = 0;
+  source->num_songs = 0;
+  source->songs_capacity = 0;
+  return offset;
+}
+
+const Song *get_song(const Repository *repo, unsigned int song_id) {
+  return &repo->songs[song_id];
+}
+
+void free_repository(Repository *repo) {
+  if (repo == NULL)
+    return;
+  free(repo->songs);
+  free(repo->song_lengths);
+  arena_free(&repo->strings);
+  free_dictionary(&repo->dictionary);
+  arena_free(&repo->nodes);
+  arena_free(&repo->frequency_nodes);
+  free(repo);
+}
+
 void to_lowercase(char *s) {
   for (char *p = s; *p; p++) {
     *p = tolower(*p);
   }
 }
 
-/**
- * @brief Remove a pontuação de uma string.
- * @param s A string da qual a pontuação será removida.
- */
 void remove_punctuation(char *s) {
   char *p = s, *q = s;
   while (*q) {
@@ -38,148 +127,405 @@ void remove_punctuation(char *s) {
   *p = '\0';
 }
 
-WordCount *find_or_create_word_count(WordCount **head, const char *word) {
-  WordCount *current = *head;
-  while (current != NULL) {
-    if (strcmp(current->word, word) == 0) {
-      return current;
-    }
-    current = current->next;
+/**
+ * @brief Dobra a tabela hash de um contador e reinsere as posições ocupadas.
+ * @param counter O contador.
+ */
+static void grow_word_counter_slots(WordCounter *counter) {
+  size_t new_capacity = counter->slot_capacity * 2;
+  WordCountSlot *new_slots =
+      (WordCountSlot *)calloc(new_capacity, sizeof(WordCountSlot));
+  if (new_slots == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para WordCounter.\n");
+    exit(EXIT_FAILURE);
   }
 
-  WordCount *new_count = (WordCount *)malloc(sizeof(WordCount));
-  if (new_count == NULL) {
-    fprintf(stderr, "Falha na alocação de memória para WordCount.\n");
-    exit(EXIT_FAILURE);
+  size_t mask = new_capacity - 1;
+  for (size_t i = 0; i < counter->slot_capacity; i++) {
+    WordCountSlot slot = counter->slots[i];
+    if (slot.entry == 0) {
+      continue;
+    }
+    size_t position = slot.hash & mask;
+    while (new_slots[position].entry != 0) {
+      position = (position + 1) & mask;
+    }
+    new_slots[position] = slot;
   }
 
-  new_count->word = strdup(word);
-  new_count->count = 0;
-  new_count->next = *head;
-  *head = new_count;
-  return new_count;
+  free(counter->slots);
+  counter->slots = new_slots;
+  counter->slot_capacity = new_capacity;
 }
 
-void free_word_count_list(WordCount *head) {
-  while (head != NULL) {
-    WordCount *temp = head;
-    head = head->next;
-    free(temp->word);
-    free(temp);
+void init_word_counter(WordCounter *counter) {
+  counter->slot_capacity = 64;
+  counter->slots =
+      (WordCountSlot *)calloc(counter->slot_capacity, sizeof(WordCountSlot));
+  counter->entry_capacity = 32;
+  counter->entries =
+      (WordCount *)malloc(counter->entry_capacity * sizeof(WordCount));
+  if (counter->slots == NULL || counter->entries == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para WordCounter.\n");
+    exit(EXIT_FAILURE);
   }
+  counter->size = 0;
+  arena_init(&counter->words, 0);
 }
 
-char *find_verse_snippet(FILE *file, const char *word, char *snippet_buffer,
-                         size_t buffer_size) {
-  char line[256];
-  long current_pos = ftell(file);
-
-  fseek(file, 0, SEEK_SET);
-  fgets(line, sizeof(line), file);
-  fgets(line, sizeof(line), file);
-
-  while (fgets(line, sizeof(line), file) != NULL) {
-    char line_copy[256];
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+WordCount *find_or_create_word_count(WordCounter *counter, const char *word) {
+  return find_or_create_word_count_span(counter, word, strlen(word));
+}
 
-    char *token = strtok(line_copy, " \t\n\r");
-    while (token != NULL) {
-      char word_copy[256];
-      strncpy(word_copy, token, sizeof(word_copy) - 1);
-      word_copy[sizeof(word_copy) - 1] = '\0';
-      remove_punctuation(word_copy);
-      to_lowercase(word_copy);
+WordCount *find_or_create_word_count_span(WordCounter *counter,
+                                          const char *word, size_t length) {
+  unsigned int hash = hash_word(word, length);
+  size_t mask = counter->slot_capacity - 1;
+  size_t position = hash & mask;
 
-      if (strcmp(word_copy, word) == 0) {
-        line[strcspn(line, "\n")] = '\0';
-        strncpy(snippet_buffer, line, buffer_size - 1);
-        snippet_buffer[buffer_size - 1] = '\0';
-        fseek(file, current_pos, SEEK_SET);
-        return snippet_buffer;
+  while (counter->slots[position].entry != 0) {
+    WordCountSlot slot = counter->slots[position];
+    if (slot.hash == hash) {
+      WordCount *candidate = &counter->entries[slot.entry - 1];
+      if (memcmp(candidate->word, word, length) == 0 &&
+          candidate->word[length] == '\0') {
+        return candidate;
       }
-      token = strtok(NULL, " \t\n\r");
+    }
+    position = (position + 1) & mask;
+  }
+
+  if (counter->size == counter->entry_capacity) {
+    counter->entry_capacity *= 2;
+    counter->entries = (WordCount *)realloc(
+        counter->entries, counter->entry_capacity * sizeof(WordCount));
+    if (counter->entries == NULL) {
+      fprintf(stderr, "Falha no realloc de WordCounter.\n");
+      exit(EXIT_FAILURE);
     }
   }
 
-  fseek(file, current_pos, SEEK_SET);
-  strncpy(snippet_buffer, "Verso não encontrado", buffer_size - 1);
-  snippet_buffer[buffer_size - 1] = '\0';
-  return snippet_buffer;
+  WordCount *new_count = &counter->entries[counter->size++];
+  new_count->word = arena_strndup(&counter->words, word, length);
+  new_count->count = 0;
+  new_count->verse_line = 0;
+
+  counter->slots[position].hash = hash;
+  counter->slots[position].entry = (unsigned int)counter->size;
+
+  // Mantém o fator de carga abaixo de 3/4.
+  if (counter->size * 4 > counter->slot_capacity * 3) {
+    grow_word_counter_slots(counter);
+  }
+  return new_count;
 }
 
-void process_music_file_for_word_count(const char *filepath, const char *title,
-                                       const char *author) {
-  FILE *file = fopen(filepath, "r");
-  if (file == NULL) {
+void free_word_counter(WordCounter *counter) {
+  free(counter->slots);
+  free(counter->entries);
+  arena_free(&counter->words);
+  counter->slots = NULL;
+  counter->entries = NULL;
+  counter->size = 0;
+}
+
+/**
+ * @brief Mapeia um arquivo inteiro em memória para leitura.
+ * @param filepath O caminho do arquivo.
+ * @param size Recebe o tamanho do arquivo.
+ * @return O início do mapeamento, "" para arquivos vazios ou NULL em caso de
+ * erro.
+ */
+static const char *map_music_file(const char *filepath, size_t *size) {
+  int fd = open(filepath, O_RDONLY);
+  if (fd < 0) {
     perror("Erro ao abrir o arquivo");
-    return;
+    return NULL;
   }
 
-  char line_buffer[256];
-  char song_title[256] = "";
-  char song_author[256] = "";
-  WordCount *word_counts = NULL;
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    perror("Erro ao abrir o arquivo");
+    close(fd);
+    return NULL;
+  }
 
-  if (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
-    line_buffer[strcspn(line_buffer, "\n")] = '\0';
-    strncpy(song_title, line_buffer, sizeof(song_title) - 1);
-    song_title[sizeof(song_title) - 1] = '\0';
+  *size = (size_t)info.st_size;
+  if (*size == 0) {
+    close(fd);
+    return "";
   }
 
-  if (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
-    line_buffer[strcspn(line_buffer, "\n")] = '\0';
-    strncpy(song_author, line_buffer, sizeof(song_author) - 1);
-    song_author[sizeof(song_author) - 1] = '\0';
+  void *data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    perror("Erro ao mapear o arquivo");
+    return NULL;
   }
+  madvise(data, *size, MADV_SEQUENTIAL);
+  return (const char *)data;
+}
 
-  while (fgets(line_buffer, sizeof(line_buffer), file) != NULL) {
-    char *line_copy = strdup(line_buffer);
-    if (line_copy == NULL) {
-      fprintf(stderr, "Erro de alocação de memória.\n");
-      exit(EXIT_FAILURE);
+/**
+ * @brief Retorna o fim da linha que começa em line (o '\n' ou o fim do
+ * arquivo).
+ */
+static const char *find_line_end(const char *line, const char *end) {
+  const char *newline = memchr(line, '\n', (size_t)(end - line));
+  return newline != NULL ? newline : end;
+}
+
+/**
+ * @struct WordPosition
+ * @brief Ocorrência de uma palavra indexada durante a leitura de uma música.
+ */
+typedef struct {
+  uint32_t word;     /**< Índice da palavra no WordCounter. */
+  uint32_t position; /**< Índice da ocorrência entre as palavras da música. */
+} WordPosition;
+
+bool scan_music_file(const char *filepath, Repository *repo,
+                     SongWordHandler handler, void *context) {
+  size_t size;
+  const char *data = map_music_file(filepath, &size);
+  if (data == NULL) {
+    return false;
+  }
+
+  const char *end = data + size;
+  const char *line = data;
+  WordCounter word_counts;
+  init_word_counter(&word_counts);
+
+  // As duas primeiras linhas são o título e o autor.
+  const char *line_end = find_line_end(line, end);
+  char *song_title =
+      arena_strndup(&repo->strings, line, (size_t)(line_end - line));
+  line = line_end < end ? line_end + 1 : end;
+
+  line_end = find_line_end(line, end);
+  char *song_author =
+      arena_strndup(&repo->strings, line, (size_t)(line_end - line));
+  line = line_end < end ? line_end + 1 : end;
+
+  // Buffers do tokenizador, dimensionados para o maior verso visto.
+  size_t line_capacity = 0;
+  char *normalized = NULL;
+  TokenSpan *tokens = NULL;
+
+  char **verses = NULL;
+  int num_verses = 0, verses_capacity = 0;
+
+  // Ocorrências indexadas, na ordem do texto; as palavras curtas demais
+  // também contam para as posições, mas não os tokens só de pontuação, que
+  // ficam vazios depois de normalizados.
+  WordPosition *occurrences = NULL;
+  size_t num_occurrences = 0, occurrences_capacity = 0;
+  uint32_t position = 0;
+
+  while (line < end) {
+    line_end = find_line_end(line, end);
+
+    size_t line_length = (size_t)(line_end - line);
+    if (line_length > line_capacity) {
+      line_capacity = line_length;
+      normalized = (char *)realloc(normalized,
+                                   line_capacity + TOKENIZE_PADDING);
+      tokens = (TokenSpan *)realloc(tokens, (line_capacity / 2 + 1) *
+                                                sizeof(TokenSpan));
+      if (normalized == NULL || tokens == NULL) {
+        fprintf(stderr, "Erro de alocação de memória.\n");
+        exit(EXIT_FAILURE);
+      }
     }
-    char *token = strtok(line_copy, " \t\n\r");
-    while (token != NULL) {
-      char word_copy[256];
-      strncpy(word_copy, token, sizeof(word_copy) - 1);
-      word_copy[sizeof(word_copy) - 1] = '\0';
-      remove_punctuation(word_copy);
-      to_lowercase(word_copy);
-
-      if (strlen(word_copy) >= 3) {
-        WordCount *wc = find_or_create_word_count(&word_counts, word_copy);
+    size_t num_tokens = tokenize_line(line, line_length, normalized, tokens);
+
+    // O verso só é guardado se alguma palavra aparecer nele pela primeira
+    // vez.
+    bool verse_saved = false;
+    for (size_t t = 0; t < num_tokens; t++) {
+      size_t length = tokens[t].length;
+      if (length >= 3) {
+        WordCount *wc = find_or_create_word_count_span(
+            &word_counts, normalized + tokens[t].offset, length);
+        if (wc->count == 0) {
+          if (!verse_saved) {
+            if (num_verses == verses_capacity) {
+              verses_capacity = verses_capacity ? verses_capacity * 2 : 16;
+              verses = (char **)realloc(verses,
+                                        verses_capacity * sizeof(char *));
+              if (verses == NULL) {
+                fprintf(stderr, "Erro de alocação de memória.\n");
+                exit(EXIT_FAILURE);
+              }
+            }
+            verses[num_verses++] = arena_strndup(&repo->strings, line,
+                                                 (size_t)(line_end - line));
+            verse_saved = true;
+          }
+          wc->verse_line = (unsigned int)(num_verses - 1);
+        }
         wc->count++;
+
+        if (num_occurrences == occurrences_capacity) {
+          occurrences_capacity =
+              occurrences_capacity ? occurrences_capacity * 2 : 256;
+          occurrences = (WordPosition *)realloc(
+              occurrences, occurrences_capacity * sizeof(WordPosition));
+          if (occurrences == NULL) {
+            fprintf(stderr, "Erro de alocação de memória.\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        occurrences[num_occurrences].word =
+            (uint32_t)(wc - word_counts.entries);
+        occurrences[num_occurrences++].position = position;
       }
-      token = strtok(NULL, " \t\n\r");
+      if (length > 0)
+        position++;
     }
-    free(line_copy);
+    line = line_end + 1;
   }
+  free(normalized);
+  free(tokens);
 
-  WordCount *current = word_counts;
-  while (current != NULL) {
-    char verse_snippet[256];
-    find_verse_snippet(file, current->word, verse_snippet,
-                       sizeof(verse_snippet));
+  unsigned int song_id =
+      add_song(repo, song_title, song_author, verses, num_verses,
+               (unsigned int)num_occurrences);
+  free(verses);
 
-    Node *bst_node = create_node(current->word);
-    if (bst_node != NULL) {
-      bst_node->best_song_occurrence = create_song_occurrence(
-          song_title, song_author, verse_snippet, current->count);
-      bst_node->total_word_count = current->count;
-      insert_node(bst_node);
-    }
+  // Agrupa as posições por palavra (ordenação por contagem, estável): ao
+  // final, ends[i] é o fim das posições da palavra i.
+  uint32_t *ends =
+      (uint32_t *)malloc((word_counts.size + 1) * sizeof(uint32_t));
+  uint32_t *positions =
+      (uint32_t *)malloc((num_occurrences + 1) * sizeof(uint32_t));
+  if (ends == NULL || positions == NULL) {
+    fprintf(stderr, "Erro de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  uint32_t start = 0;
+  for (size_t i = 0; i < word_counts.size; i++) {
+    ends[i] = start;
+    start += word_counts.entries[i].count;
+  }
+  for (size_t k = 0; k < num_occurrences; k++) {
+    positions[ends[occurrences[k].word]++] = occurrences[k].position;
+  }
+  free(occurrences);
+
+  for (size_t i = 0; i < word_counts.size; i++) {
+    WordCount *current = &word_counts.entries[i];
+    handler(current->word, current->count,
+            positions + ends[i] - current->count, song_id,
+            current->verse_line, context);
+  }
 
-    Node *avl_node = create_node(current->word);
-    if (avl_node != NULL) {
-      avl_node->best_song_occurrence = create_song_occurrence(
-          song_title, song_author, verse_snippet, current->count);
-      avl_node->total_word_count = current->count;
-      insert_node_avl(avl_node);
+  free(ends);
+  free(positions);
+  free_word_counter(&word_counts);
+  if (size > 0) {
+    munmap((void *)data, size);
+  }
+  return true;
+}
+
+/**
+ * @brief Soma uma palavra da música ao dicionário global, acrescenta a
+ * música à sua lista de ocorrências e, se ela for nova, indexa seu registro
+ * nas árvores globais (BST e AVL).
+ * @param context O repositório global (Repository *).
+ */
+static void insert_into_global_trees(const char *word, unsigned int count,
+                                     const uint32_t *positions,
+                                     unsigned int song_id,
+                                     unsigned int verse_line, void *context) {
+  Repository *repo = (Repository *)context;
+  SongOccurrence occurrence = {song_id, verse_line, count};
+  bool created;
+
+  WordEntry *entry = add_word_occurrence(&repo->dictionary, word, count,
+                                         &occurrence, &created);
+  add_posting(word_postings(&repo->dictionary, entry),
+              &repo->dictionary.posting_blocks, song_id, count,
+              positions);
+  if (created) {
+    insert_word(&repo->nodes, entry);
+    insert_word_avl(&repo->nodes, entry);
+  }
+}
+
+/**
+ * @brief Soma uma palavra da música ao dicionário de um repositório privado
+ * e acrescenta a música à sua lista de ocorrências.
+ * @param context O repositório privado (Repository *).
+ */
+static void insert_into_private_dictionary(const char *word,
+                                           unsigned int count,
+                                           const uint32_t *positions,
+                                           unsigned int song_id,
+                                           unsigned int verse_line,
+                                           void *context) {
+  Repository *repo = (Repository *)context;
+  SongOccurrence occurrence = {song_id, verse_line, count};
+
+  WordEntry *entry =
+      add_word_occurrence(&repo->dictionary, word, count, &occurrence, NULL);
+  add_posting(word_postings(&repo->dictionary, entry),
+              &repo->dictionary.posting_blocks, song_id, count,
+              positions);
+}
+
+void process_music_file_for_word_count(const char *filepath, const char *title,
+                                       const char *author) {
+  (void)title;
+  (void)author;
+  if (song_repository == NULL) {
+    song_repository = create_repository();
+  }
+  scan_music_file(filepath, song_repository, insert_into_global_trees,
+                  song_repository);
+}
+
+void process_music_file_into_repository(const char *filepath,
+                                        Repository *repo) {
+  scan_music_file(filepath, repo, insert_into_private_dictionary, repo);
+}
+
+void update_search_structures(Repository *repo) {
+  Dictionary *dictionary = &repo->dictionary;
+  if (sorted_word_array == NULL) {
+    sorted_word_array = create_word_array();
+  }
+
+  WordArray *new_words = create_word_array();
+  bool counts_changed = false;
+  for (size_t i = 0; i < dictionary->num_changed; i++) {
+    WordEntry *entry = dictionary->changed[i];
+    if (entry->indexed_count == entry->total_word_count) {
+      continue;
+    }
+    if (entry->indexed_count == 0) {
+      add_entry_to_array(new_words, entry);
     }
-    current = current->next;
+    reindex_frequency_entry(&repo->frequency_nodes, entry);
+    counts_changed = true;
   }
+  dictionary->num_changed = 0;
 
-  free_word_count_list(word_counts);
-  fclose(file);
+  // As contagens do CountIndex são copiadas na montagem; qualquer mudança o
+  // invalida.
+  if (counts_changed) {
+    free_count_index(count_index);
+    count_index = NULL;
+  }
+
+  // A cópia em ordem de Eytzinger é congelada: palavras novas a invalidam e
+  // ela é remontada na próxima busca. Mudanças de contagem não a afetam.
+  if (new_words->size > 0) {
+    free_eytzinger_array(eytzinger_array);
+    eytzinger_array = NULL;
+  }
+  merge_into_word_array(sorted_word_array, new_words);
+  free_word_array(new_words);
 }
@@ -0,0 +1,646 @@
+/**
+ * @file server.c
+ * @brief Servidor local de consultas: laço de eventos (epoll) e threads de
+ * trabalho.
+ */
+
+#include "include/server.h"
+#include "include/ingest.h"
+#include "include/live.h"
+#include "include/query.h"
+#include "include/repository.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/** Bytes lidos de uma conexão por vez. */
+#define SERVER_READ_SIZE (64 * 1024)
+
+/** Maior linha de consulta aceita. */
+#define SERVER_MAX_LINE (64 * 1024)
+
+/** Conexões pendentes na fila de aceitação. */
+#define SERVER_BACKLOG 128
+
+/** Linhas executadas por lote; o resto fica para o lote seguinte. */
+#define SERVER_MAX_BATCH 1024
+
+/** Eventos tratados por chamada a epoll_wait. */
+#define SERVER_MAX_EVENTS 64
+
+/**
+ * @struct Connection
+ * @brief Estado de uma conexão, usado só pela thread que a atende.
+ */
+typedef struct Connection {
+  int fd;                   /**< O socket. */
+  char *input;              /**< Bytes recebidos e ainda não executados. */
+  size_t input_used;        /**< Bytes em input. */
+  size_t input_capacity;    /**< Capacidade de input. */
+  char *output;             /**< Respostas do último lote. */
+  size_t output_size;       /**< Bytes em output. */
+  size_t output_sent;       /**< Bytes de output já enviados. */
+  bool closing;             /**< Se o cliente encerrou o envio. */
+  bool discarding;          /**< Se descarta uma linha longa demais. */
+  struct Connection *ready; /**< Próxima na fila de trabalho. */
+  struct Connection *prev;  /**< Anterior na lista de conexões. */
+  struct Connection *next;  /**< Próxima na lista de conexões. */
+} Connection;
+
+/**
+ * @struct Server
+ * @brief Estado compartilhado pelas threads do servidor.
+ */
+typedef struct {
+  const ServerOptions *options; /**< A configuração. */
+  int epoll_fd;                 /**< O epoll das conexões. */
+  LiveIndex *index;             /**< As versões do índice. */
+  pthread_mutex_t lock;         /**< Protege os campos abaixo. */
+  pthread_cond_t has_work;      /**< Sinaliza a fila de trabalho. */
+  Connection *first_ready;      /**< Início da fila de trabalho. */
+  Connection *last_ready;       /**< Fim da fila de trabalho. */
+  Connection *connections;      /**< Todas as conexões abertas. */
+  bool stopping;                /**< Se o servidor está sendo encerrado. */
+  size_t num_connections;       /**< Conexões aceitas. */
+  size_t num_batches;           /**< Lotes executados. */
+  size_t num_queries;           /**< Consultas executadas. */
+  size_t num_errors;            /**< Consultas inválidas. */
+} Server;
+
+/** Marcas de data.ptr dos descritores que não são conexões. */
+static char listen_tag, signal_tag;
+
+/**
+ * @union ServerAddress
+ * @brief Endereço de um socket Unix ou TCP.
+ */
+typedef union {
+  struct sockaddr generic;  /**< Endereço genérico. */
+  struct sockaddr_in inet;  /**< TCP (IPv4). */
+  struct sockaddr_un local; /**< Domínio Unix. */
+} ServerAddress;
+
+static bool is_tcp_address(const char *address) {
+  return strchr(address, ':') != NULL;
+}
+
+static bool parse_address(const char *address, ServerAddress *out,
+                          socklen_t *length) {
+  memset(out, 0, sizeof(*out));
+  if (!is_tcp_address(address)) {
+    if (strlen(address) >= sizeof(out->local.sun_path)) {
+      fprintf(stderr, "Caminho do socket muito longo: %s\n", address);
+      return false;
+    }
+    out->local.sun_family = AF_UNIX;
+    strcpy(out->local.sun_path, address);
+    *length = sizeof(out->local);
+    return true;
+  }
+
+  const char *colon = strrchr(address, ':');
+  char host[INET_ADDRSTRLEN] = "127.0.0.1";
+  size_t host_length = (size_t)(colon - address);
+  if (host_length >= sizeof(host)) {
+    fprintf(stderr, "Endereço inválido: %s\n", address);
+    return false;
+  }
+  if (host_length > 0) {
+    memcpy(host, address, host_length);
+    host[host_length] = '\0';
+  }
+  char *end;
+  unsigned long port = strtoul(colon + 1, &end, 10);
+  if (colon[1] == '\0' || *end != '\0' || port > 65535) {
+    fprintf(stderr, "Porta inválida: %s\n", address);
+    return false;
+  }
+  if (inet_pton(AF_INET, host, &out->inet.sin_addr) != 1) {
+    fprintf(stderr, "Endereço inválido: %s\n", address);
+    return false;
+  }
+  if (ntohl(out->inet.sin_addr.s_addr) >> 24 != 127) {
+    fprintf(stderr, "Só endereços de loopback (127.0.0.0/8) são aceitos: "
+                    "%s\n",
+            address);
+    return false;
+  }
+  out->inet.sin_family = AF_INET;
+  out->inet.sin_port = htons((uint16_t)port);
+  *length = sizeof(out->inet);
+  return true;
+}
+
+int server_listen(const char *address) {
+  ServerAddress target;
+  socklen_t length;
+  if (!parse_address(address, &target, &length))
+    return -1;
+  int fd = socket(target.generic.sa_family,
+                  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("Erro ao criar o socket");
+    return -1;
+  }
+  if (target.generic.sa_family == AF_INET) {
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  } else {
+    // Só um socket é substituído, nunca um arquivo comum.
+    struct stat info;
+    if (stat(address, &info) == 0 && S_ISSOCK(info.st_mode))
+      unlink(address);
+  }
+  if (bind(fd, &target.generic, length) != 0 ||
+      listen(fd, SERVER_BACKLOG) != 0) {
+    perror(address);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int server_connect(const char *address) {
+  ServerAddress target;
+  socklen_t length;
+  if (!parse_address(address, &target, &length))
+    return -1;
+  int fd = socket(target.generic.sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("Erro ao criar o socket");
+    return -1;
+  }
+  if (connect(fd, &target.generic, length) != 0) {
+    perror(address);
+    close(fd);
+    return -1;
+  }
+  if (target.generic.sa_family == AF_INET) {
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  }
+  return fd;
+}
+
+static void *allocate_or_exit(size_t size) {
+  void *memory = malloc(size);
+  if (memory == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para o servidor.\n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+/**
+ * @brief Rearma uma conexão no epoll para um único evento.
+ */
+static void rearm(Server *server, Connection *connection, uint32_t events) {
+  struct epoll_event event = {events | EPOLLONESHOT, {.ptr = connection}};
+  if (epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) !=
+      0)
+    perror("Erro ao rearmar a conexão");
+}
+
+static void close_connection(Server *server, Connection *connection) {
+  pthread_mutex_lock(&server->lock);
+  if (connection->prev != NULL)
+    connection->prev->next = connection->next;
+  else
+    server->connections = connection->next;
+  if (connection->next != NULL)
+    connection->next->prev = connection->prev;
+  pthread_mutex_unlock(&server->lock);
+
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+  close(connection->fd);
+  free(connection->input);
+  free(connection->output);
+  free(connection);
+}
+
+/**
+ * @brief Aceita as conexões pendentes e as registra para leitura.
+ */
+static void accept_connections(Server *server, int listen_fd) {
+  for (;;) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+          errno != ECONNABORTED)
+        perror("Erro ao aceitar a conexão");
+      return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (is_tcp_address(server->options->address)) {
+      int enable = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    Connection *connection =
+        (Connection *)allocate_or_exit(sizeof(Connection));
+    memset(connection, 0, sizeof(Connection));
+    connection->fd = fd;
+    connection->input_capacity = SERVER_READ_SIZE + 1;
+    connection->input = (char *)allocate_or_exit(connection->input_capacity);
+
+    pthread_mutex_lock(&server->lock);
+    connection->next = server->connections;
+    if (server->connections != NULL)
+      server->connections->prev = connection;
+    server->connections = connection;
+    server->num_connections++;
+    pthread_mutex_unlock(&server->lock);
+
+    struct epoll_event event = {EPOLLIN | EPOLLONESHOT, {.ptr = connection}};
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      perror("Erro ao registrar a conexão");
+      close_connection(server, connection);
+    }
+  }
+}
+
+static void enqueue(Server *server, Connection *connection) {
+  pthread_mutex_lock(&server->lock);
+  connection->ready = NULL;
+  if (server->last_ready != NULL)
+    server->last_ready->ready = connection;
+  else
+    server->first_ready = connection;
+  server->last_ready = connection;
+  pthread_cond_signal(&server->has_work);
+  pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * @brief Retira a próxima conexão da fila, esperando se preciso.
+ * @return A conexão, ou NULL se o servidor está sendo encerrado.
+ */
+static Connection *dequeue(Server *server) {
+  pthread_mutex_lock(&server->lock);
+  while (server->first_ready == NULL && !server->stopping)
+    pthread_cond_wait(&server->has_work, &server->lock);
+  Connection *connection = NULL;
+  if (!server->stopping) {
+    connection = server->first_ready;
+    server->first_ready = connection->ready;
+    if (server->first_ready == NULL)
+      server->last_ready = NULL;
+  }
+  pthread_mutex_unlock(&server->lock);
+  return connection;
+}
+
+/**
+ * @brief Envia o que for possível das respostas pendentes.
+ * @return false se a conexão falhou.
+ */
+static bool flush_output(Connection *connection) {
+  while (connection->output_sent < connection->output_size) {
+    ssize_t sent = send(connection->fd,
+                        connection->output + connection->output_sent,
+                        connection->output_size - connection->output_sent,
+                        MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    connection->output_sent += (size_t)sent;
+  }
+  return true;
+}
+
+/**
+ * @brief Executa as linhas completas recebidas como um lote, na mesma
+ * versão do índice, e guarda as respostas em output (que estava vazio).
+ *
+ * Executa até SERVER_MAX_BATCH linhas. Com o fim da entrada, o resto sem
+ * '\n' também é uma linha. Uma linha maior que SERVER_MAX_LINE recebe um
+ * erro e é descartada até o '\n'.
+ */
+static void execute_batch(Server *server, LiveReader *reader,
+                          QueryContext *context, Connection *connection) {
+  char *start = connection->input;
+  char *end = start + connection->input_used;
+  if (connection->discarding) {
+    char *newline = (char *)memchr(start, '\n', (size_t)(end - start));
+    if (newline == NULL) {
+      connection->input_used = 0;
+      return;
+    }
+    start = newline + 1;
+    connection->discarding = false;
+  }
+  bool has_line = memchr(start, '\n', (size_t)(end - start)) != NULL ||
+                  (connection->closing && start < end);
+  if (!has_line && (size_t)(end - start) <= SERVER_MAX_LINE) {
+    connection->input_used = (size_t)(end - start);
+    memmove(connection->input, start, connection->input_used);
+    return;
+  }
+
+  char *responses = NULL;
+  size_t responses_size = 0;
+  FILE *out = open_memstream(&responses, &responses_size);
+  if (out == NULL) {
+    perror("Erro ao criar o buffer das respostas");
+    exit(EXIT_FAILURE);
+  }
+  if (has_line) {
+    const LiveVersion *version = live_index_begin(server->index, reader);
+    context->snapshot = version->snapshot;
+    context->snapshot_counts = version->counts;
+    for (size_t n = 0; start < end && n < SERVER_MAX_BATCH; n++) {
+      char *newline = (char *)memchr(start, '\n', (size_t)(end - start));
+      if (newline == NULL) {
+        if (!connection->closing)
+          break;
+        newline = end; // input tem um byte livre depois dos dados.
+      }
+      *newline = '\0';
+      execute_query(context, start, out);
+      putc('\n', out);
+      start = newline < end ? newline + 1 : end;
+    }
+    live_index_end(reader);
+    context->snapshot = NULL;
+    context->snapshot_counts = NULL;
+  }
+  if ((size_t)(end - start) > SERVER_MAX_LINE &&
+      memchr(start, '\n', (size_t)(end - start)) == NULL) {
+    fputs("error\tlinha muito longa\n\n", out);
+    context->num_queries++;
+    context->num_errors++;
+    connection->discarding = true;
+    start = end;
+  }
+  fclose(out);
+
+  free(connection->output);
+  connection->output = responses;
+  connection->output_size = responses_size;
+  connection->output_sent = 0;
+  connection->input_used = (size_t)(end - start);
+  memmove(connection->input, start, connection->input_used);
+}
+
+static bool has_complete_line(const Connection *connection) {
+  return connection->input_used > 0 &&
+         memchr(connection->input, '\n', connection->input_used) != NULL;
+}
+
+/**
+ * @brief Atende uma conexão com evento: envia as respostas pendentes, lê,
+ * executa as linhas completas, envia as respostas e rearma a conexão.
+ * @return true se um lote foi executado.
+ */
+static bool serve_connection(Server *server, LiveReader *reader,
+                             QueryContext *context, Connection *connection) {
+  if (!flush_output(connection)) {
+    close_connection(server, connection);
+    return false;
+  }
+  if (connection->output_sent < connection->output_size) {
+    rearm(server, connection, EPOLLOUT);
+    return false;
+  }
+
+  // Enquanto houver linhas completas sem executar, nada é lido: o resto
+  // fica no socket e o controle de fluxo do TCP freia o cliente, de modo
+  // que input não passa de SERVER_MAX_LINE + SERVER_READ_SIZE bytes.
+  if (!connection->closing && !has_complete_line(connection)) {
+    size_t needed = connection->input_used + SERVER_READ_SIZE + 1;
+    if (needed > connection->input_capacity) {
+      char *input = (char *)realloc(connection->input, needed);
+      if (input == NULL) {
+        fprintf(stderr, "Falha na alocação de memória para o servidor.\n");
+        exit(EXIT_FAILURE);
+      }
+      connection->input = input;
+      connection->input_capacity = needed;
+    }
+    ssize_t received =
+        recv(connection->fd, connection->input + connection->input_used,
+             SERVER_READ_SIZE, 0);
+    if (received > 0) {
+      connection->input_used += (size_t)received;
+    } else if (received == 0) {
+      connection->closing = true;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      close_connection(server, connection);
+      return false;
+    }
+  }
+
+  size_t queries = context->num_queries;
+  execute_batch(server, reader, context, connection);
+  bool executed = context->num_queries != queries;
+  // Linhas que passaram do limite do lote não geram novos eventos.
+  bool pending = has_complete_line(connection) ||
+                 (connection->closing && connection->input_used > 0);
+  if (!flush_output(connection)) {
+    close_connection(server, connection);
+  } else if (connection->output_sent < connection->output_size) {
+    rearm(server, connection, EPOLLOUT);
+  } else if (pending) {
+    enqueue(server, connection);
+  } else if (connection->closing) {
+    close_connection(server, connection);
+  } else {
+    rearm(server, connection, EPOLLIN);
+  }
+  return executed;
+}
+
+static void *worker_run(void *argument) {
+  Server *server = (Server *)argument;
+  LiveReader *reader = live_index_register(server->index);
+  QueryContext context = {QUERY_ENGINE_SNAPSHOT, NULL, NULL, 0, 0};
+  size_t batches = 0;
+  Connection *connection;
+  while ((connection = dequeue(server)) != NULL) {
+    if (serve_connection(server, reader, &context, connection))
+      batches++;
+  }
+  live_index_unregister(reader);
+
+  pthread_mutex_lock(&server->lock);
+  server->num_batches += batches;
+  server->num_queries += context.num_queries;
+  server->num_errors += context.num_errors;
+  pthread_mutex_unlock(&server->lock);
+  return NULL;
+}
+
+static bool is_stopping(Server *server) {
+  pthread_mutex_lock(&server->lock);
+  bool stopping = server->stopping;
+  pthread_mutex_unlock(&server->lock);
+  return stopping;
+}
+
+/**
+ * @brief Thread escritora: carrega os caminhos de --load e publica uma
+ * versão depois de cada um.
+ */
+static void *writer_run(void *argument) {
+  Server *server = (Server *)argument;
+  const ServerOptions *options = server->options;
+  // O índice inicial continua publicado enquanto é copiado: só esta
+  // thread pode substituí-lo.
+  if (options->snapshot != NULL) {
+    if (song_repository == NULL)
+      song_repository = create_repository();
+    if (!restore_snapshot(options->snapshot, song_repository))
+      return NULL;
+  }
+  for (int i = 0; i < options->num_load_paths && !is_stopping(server); i++) {
+    if (!load_music_path(options->load_paths[i]) ||
+        !live_index_refresh(server->index))
+      continue;
+    const Snapshot *snapshot = server->index->current->snapshot;
+    fprintf(stderr, "Carregado: %s (versão %llu, %u música(s), %u "
+                    "palavra(s)).\n",
+            options->load_paths[i],
+            (unsigned long long)server->index->num_published,
+            snapshot->num_songs, snapshot->num_words);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Trata os eventos até receber SIGINT ou SIGTERM.
+ */
+static void run_event_loop(Server *server, int listen_fd) {
+  struct epoll_event events[SERVER_MAX_EVENTS];
+  for (;;) {
+    int num_events =
+        epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, -1);
+    if (num_events < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("Erro no laço de eventos");
+      return;
+    }
+    for (int i = 0; i < num_events; i++) {
+      void *tag = events[i].data.ptr;
+      if (tag == &signal_tag)
+        return;
+      if (tag == &listen_tag)
+        accept_connections(server, listen_fd);
+      else
+        enqueue(server, (Connection *)tag);
+    }
+  }
+}
+
+int run_server(const ServerOptions *options) {
+  // Os sinais de encerramento chegam pelo epoll; as threads criadas
+  // depois herdam o bloqueio.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  int listen_fd = server_listen(options->address);
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (signal_fd < 0 || listen_fd < 0 || epoll_fd < 0) {
+    if (signal_fd < 0 || epoll_fd < 0)
+      perror("Erro ao iniciar o servidor");
+    if (listen_fd >= 0)
+      close(listen_fd);
+    if (signal_fd >= 0)
+      close(signal_fd);
+    if (epoll_fd >= 0)
+      close(epoll_fd);
+    free_snapshot(options->snapshot);
+    return 1;
+  }
+
+  Server server;
+  memset(&server, 0, sizeof(server));
+  server.options = options;
+  server.epoll_fd = epoll_fd;
+  pthread_mutex_init(&server.lock, NULL);
+  pthread_cond_init(&server.has_work, NULL);
+  server.index = create_live_index();
+  if (server.index == NULL) {
+    fprintf(stderr, "Falha ao publicar o índice.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (options->snapshot != NULL)
+    live_index_publish(server.index, options->snapshot);
+
+  struct epoll_event event = {EPOLLIN, {.ptr = &listen_tag}};
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+  event.data.ptr = &signal_tag;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &event);
+
+  int num_workers = options->num_workers;
+  if (num_workers <= 0)
+    num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_workers < 1)
+    num_workers = 1;
+  if (num_workers > LIVE_MAX_READERS)
+    num_workers = LIVE_MAX_READERS;
+  pthread_t *workers =
+      (pthread_t *)allocate_or_exit(num_workers * sizeof(pthread_t));
+  for (int t = 0; t < num_workers; t++) {
+    if (pthread_create(&workers[t], NULL, worker_run, &server) != 0) {
+      perror("Erro ao criar a thread de trabalho");
+      exit(EXIT_FAILURE);
+    }
+  }
+  pthread_t writer;
+  bool has_writer = options->num_load_paths > 0;
+  if (has_writer && pthread_create(&writer, NULL, writer_run, &server) != 0) {
+    perror("Erro ao criar a thread de carga");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stderr, "Servidor em %s com %d thread(s) de trabalho.\n",
+          options->address, num_workers);
+
+  run_event_loop(&server, listen_fd);
+
+  pthread_mutex_lock(&server.lock);
+  server.stopping = true;
+  pthread_cond_broadcast(&server.has_work);
+  pthread_mutex_unlock(&server.lock);
+  for (int t = 0; t < num_workers; t++)
+    pthread_join(workers[t], NULL);
+  if (has_writer)
+    pthread_join(writer, NULL);
+  free(workers);
+
+  while (server.connections != NULL)
+    close_connection(&server, server.connections);
+  close(listen_fd);
+  close(signal_fd);
+  close(epoll_fd);
+  if (!is_tcp_address(options->address))
+    unlink(options->address);
+
+  fprintf(stderr, "%zu conexão(ões), %zu consulta(s) (%zu inválida(s)) em "
+                  "%zu lote(s).\n",
+          server.num_connections, server.num_queries, server.num_errors,
+          server.num_batches);
+  free_live_index(server.index);
+  pthread_cond_destroy(&server.has_work);
+  pthread_mutex_destroy(&server.lock);
+  return 0;
+}
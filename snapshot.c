@@ -0,0 +1,763 @@
+/**
+ * @file snapshot.c
+ * @brief Gravação, carga e consulta do índice salvo em arquivo.
+ */
+
+#include "include/snapshot.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_ALIGNMENT 64
+
+static size_t align_section(size_t offset) {
+  return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(size_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Soma de verificação FNV-1a de 64 bits, aplicada a palavras de 8
+ * bytes (e byte a byte no final).
+ */
+static uint64_t snapshot_checksum(const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static uint64_t header_checksum(const SnapshotHeader *header) {
+  return snapshot_checksum(header,
+                           offsetof(SnapshotHeader, header_checksum));
+}
+
+/**
+ * @struct SnapshotWriter
+ * @brief Estado da montagem da imagem do arquivo em memória.
+ */
+typedef struct {
+  unsigned char *image;  /**< A imagem do arquivo. */
+  SnapshotHeader header; /**< Cabeçalho em montagem. */
+  size_t strings_used;   /**< Bytes já usados em STRINGS. */
+} SnapshotWriter;
+
+static void *section_start(SnapshotWriter *writer, int section) {
+  return writer->image + writer->header.sections[section].offset;
+}
+
+/**
+ * @brief Copia um texto para STRINGS.
+ * @return O deslocamento do texto (0, a string vazia, para NULL).
+ */
+static uint64_t write_string(SnapshotWriter *writer, const char *s) {
+  if (s == NULL || *s == '\0')
+    return 0;
+  size_t length = strlen(s) + 1;
+  uint64_t offset = writer->strings_used;
+  memcpy((char *)section_start(writer, SNAPSHOT_STRINGS) + offset, s, length);
+  writer->strings_used += length;
+  return offset;
+}
+
+static size_t string_size(const char *s) {
+  return s == NULL || *s == '\0' ? 0 : strlen(s) + 1;
+}
+
+/**
+ * @brief Índice de um registro no array ordenado (busca binária).
+ */
+static uint32_t sorted_index(const WordArray *sorted, const WordEntry *entry) {
+  int low = 0, high = sorted->size - 1;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (strcmp(sorted->entries[mid]->word, entry->word) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return (uint32_t)low;
+}
+
+/**
+ * @brief Preenche PREFIXES e LOOKUP em ordem de Eytzinger (em-ordem sobre
+ * as posições implícitas, como em build_eytzinger_array).
+ * @return O índice do próximo registro do array ordenado.
+ */
+static uint32_t fill_lookup(uint64_t *prefixes, uint32_t *lookup,
+                            const WordArray *sorted, uint32_t next, size_t k) {
+  if (k > (size_t)sorted->size)
+    return next;
+  next = fill_lookup(prefixes, lookup, sorted, next, 2 * k);
+  prefixes[k] = word_prefix(sorted->entries[next]->word);
+  lookup[k] = next++;
+  return fill_lookup(prefixes, lookup, sorted, next, 2 * k + 1);
+}
+
+/**
+ * @brief Monta a imagem do arquivo do índice em memória anônima.
+ *
+ * @param size Recebe o tamanho da imagem.
+ * @return A imagem, liberada com munmap, ou NULL se as estruturas estiverem
+ * desatualizadas.
+ */
+static unsigned char *build_image(const Repository *repo,
+                                  const WordArray *sorted,
+                                  Node *frequency_root, size_t *size) {
+  if (repo->dictionary.num_changed != 0) {
+    fprintf(stderr, "Índice desatualizado: chame update_search_structures "
+                    "antes de salvar.\n");
+    return NULL;
+  }
+
+  SnapshotWriter writer;
+  memset(&writer, 0, sizeof(writer));
+  SnapshotHeader *header = &writer.header;
+  uint32_t num_words = (uint32_t)sorted->size;
+  uint32_t num_songs = (uint32_t)repo->num_songs;
+
+  // Tamanho dos textos: o '\0' inicial é a string vazia.
+  size_t strings_size = 1, num_lines = 0, postings_size = 0, num_skips = 0;
+  for (uint32_t i = 0; i < num_words; i++) {
+    const PostingList *list =
+        word_postings(&repo->dictionary, sorted->entries[i]);
+    strings_size += string_size(sorted->entries[i]->word);
+    postings_size += posting_list_size(list);
+    num_skips += posting_skip_count(list->num_songs);
+  }
+  for (uint32_t s = 0; s < num_songs; s++) {
+    const Song *song = &repo->songs[s];
+    strings_size += string_size(song->title) + string_size(song->author);
+    for (int l = 0; l < song->number_of_lines; l++)
+      strings_size += string_size(song->lyrics_lines[l]);
+    num_lines += (size_t)song->number_of_lines;
+  }
+
+  size_t sizes[SNAPSHOT_NUM_SECTIONS] = {
+      [SNAPSHOT_STRINGS] = strings_size,
+      [SNAPSHOT_SONGS] = num_songs * sizeof(SnapshotSong),
+      [SNAPSHOT_LENGTHS] = num_songs * sizeof(uint32_t),
+      [SNAPSHOT_LINES] = num_lines * sizeof(uint64_t),
+      [SNAPSHOT_WORDS] = num_words * sizeof(SnapshotWord),
+      [SNAPSHOT_PREFIXES] = (num_words + 1) * sizeof(uint64_t),
+      [SNAPSHOT_LOOKUP] = (num_words + 1) * sizeof(uint32_t),
+      [SNAPSHOT_FREQUENCY] = num_words * sizeof(uint32_t),
+      [SNAPSHOT_POSTINGS] = postings_size,
+      [SNAPSHOT_SKIPS] = num_skips * sizeof(PostingByteSkip),
+  };
+  size_t offset = align_section(sizeof(SnapshotHeader));
+  for (int i = 0; i < SNAPSHOT_NUM_SECTIONS; i++) {
+    header->sections[i].offset = offset;
+    header->sections[i].size = sizes[i];
+    offset = align_section(offset + sizes[i]);
+  }
+
+  memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+  header->version = SNAPSHOT_VERSION;
+  header->byte_order = SNAPSHOT_BYTE_ORDER;
+  header->file_size = offset;
+  header->num_songs = num_songs;
+  header->num_lines = (uint32_t)num_lines;
+  header->num_words = num_words;
+  header->total_length = repo->total_length;
+
+  // Como um arquivo mapeado, a imagem é liberada com munmap.
+  void *image = mmap(NULL, offset, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (image == MAP_FAILED) {
+    fprintf(stderr, "Falha na alocação de memória para o índice.\n");
+    exit(EXIT_FAILURE);
+  }
+  writer.image = (unsigned char *)image;
+  writer.strings_used = 1;
+
+  // Catálogo de músicas.
+  SnapshotSong *songs = section_start(&writer, SNAPSHOT_SONGS);
+  uint64_t *lines = section_start(&writer, SNAPSHOT_LINES);
+  uint32_t line = 0;
+  if (num_songs > 0)
+    memcpy(section_start(&writer, SNAPSHOT_LENGTHS), repo->song_lengths,
+           num_songs * sizeof(uint32_t));
+  for (uint32_t s = 0; s < num_songs; s++) {
+    const Song *song = &repo->songs[s];
+    songs[s].title = write_string(&writer, song->title);
+    songs[s].author = write_string(&writer, song->author);
+    songs[s].first_line = line;
+    songs[s].num_lines = (uint32_t)song->number_of_lines;
+    for (int l = 0; l < song->number_of_lines; l++)
+      lines[line++] = write_string(&writer, song->lyrics_lines[l]);
+  }
+
+  // Registros em ordem alfabética, com as listas de ocorrências e os pontos
+  // de salto na mesma ordem, e a cópia em ordem de Eytzinger.
+  SnapshotWord *words = section_start(&writer, SNAPSHOT_WORDS);
+  unsigned char *postings = section_start(&writer, SNAPSHOT_POSTINGS);
+  PostingByteSkip *skips = section_start(&writer, SNAPSHOT_SKIPS);
+  uint64_t postings_used = 0, skips_used = 0;
+  for (uint32_t i = 0; i < num_words; i++) {
+    const WordEntry *entry = sorted->entries[i];
+    words[i].word = write_string(&writer, entry->word);
+    words[i].total_word_count = entry->total_word_count;
+    words[i].song_id = entry->best_song_occurrence.song_id;
+    words[i].verse_line = entry->best_song_occurrence.verse_line;
+    words[i].word_count_in_song =
+        entry->best_song_occurrence.word_count_in_song;
+    const PostingList *list = word_postings(&repo->dictionary, entry);
+    words[i].postings = postings_used;
+    words[i].postings_size =
+        (uint32_t)copy_posting_bytes(list, postings + postings_used);
+    words[i].num_songs = list->num_songs;
+    words[i].skips = skips_used;
+    postings_used += words[i].postings_size;
+    skips_used += copy_posting_skips(list, skips + skips_used);
+  }
+  fill_lookup(section_start(&writer, SNAPSHOT_PREFIXES),
+              section_start(&writer, SNAPSHOT_LOOKUP), sorted, 0, 1);
+
+  // Ordem de frequência: percurso em ordem da árvore de frequência.
+  WordArray *by_frequency = create_word_array();
+  populate_array_from_tree(frequency_root, by_frequency);
+  if ((uint32_t)by_frequency->size != num_words) {
+    fprintf(stderr, "Índice desatualizado: a árvore de frequência tem %d "
+                    "palavras e o array ordenado, %u.\n",
+            by_frequency->size, num_words);
+    free_word_array(by_frequency);
+    munmap(writer.image, offset);
+    return NULL;
+  }
+  uint32_t *frequency = section_start(&writer, SNAPSHOT_FREQUENCY);
+  for (uint32_t i = 0; i < num_words; i++)
+    frequency[i] = sorted_index(sorted, by_frequency->entries[i]);
+  free_word_array(by_frequency);
+
+  size_t header_size = sizeof(SnapshotHeader);
+  header->body_checksum =
+      snapshot_checksum(writer.image + header_size, offset - header_size);
+  header->header_checksum = header_checksum(header);
+  memcpy(writer.image, header, header_size);
+  *size = offset;
+  return writer.image;
+}
+
+bool save_snapshot(const char *path, const Repository *repo,
+                   const WordArray *sorted, Node *frequency_root) {
+  size_t size;
+  unsigned char *image = build_image(repo, sorted, frequency_root, &size);
+  if (image == NULL)
+    return false;
+
+  size_t temporary_length = strlen(path) + 5;
+  char *temporary = (char *)malloc(temporary_length);
+  if (temporary == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para o caminho.\n");
+    exit(EXIT_FAILURE);
+  }
+  snprintf(temporary, temporary_length, "%s.tmp", path);
+
+  bool saved = false;
+  FILE *file = fopen(temporary, "wb");
+  if (file == NULL) {
+    perror("Erro ao criar o arquivo do índice");
+  } else {
+    bool written = fwrite(image, 1, size, file) == size &&
+                   fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0)
+      written = false;
+    if (!written) {
+      perror("Erro ao gravar o arquivo do índice");
+    } else if (rename(temporary, path) != 0) {
+      perror("Erro ao renomear o arquivo do índice");
+    } else {
+      saved = true;
+    }
+    if (!saved)
+      unlink(temporary);
+  }
+  free(temporary);
+  munmap(image, size);
+  return saved;
+}
+
+/**
+ * @brief Informa por que um arquivo de índice foi recusado.
+ * @return NULL, para ser repassado pelo chamador.
+ */
+static Snapshot *reject_snapshot(const char *path, const char *reason,
+                                 void *data, size_t size) {
+  fprintf(stderr, "Índice inválido (%s): %s.\n", path, reason);
+  if (data != NULL)
+    munmap(data, size);
+  return NULL;
+}
+
+/**
+ * @brief Confere o cabeçalho e as seções de uma imagem do índice e monta o
+ * Snapshot que aponta para ela.
+ *
+ * @param path O nome da imagem nas mensagens de erro.
+ * @param data A imagem, que é liberada com munmap se for recusada.
+ * @param size O tamanho da imagem.
+ * @param verify Se verdadeiro, também confere a soma do corpo.
+ * @return O índice, ou NULL se a imagem for inválida.
+ */
+static Snapshot *open_image(const char *path, void *data, size_t size,
+                            bool verify) {
+  const SnapshotHeader *header = (const SnapshotHeader *)data;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+    return reject_snapshot(path, "número mágico incorreto", data, size);
+  if (header->byte_order != SNAPSHOT_BYTE_ORDER)
+    return reject_snapshot(path, "ordem de bytes diferente", data, size);
+  if (header->version != SNAPSHOT_VERSION)
+    return reject_snapshot(path, "versão não suportada", data, size);
+  if (header->header_checksum != header_checksum(header))
+    return reject_snapshot(path, "cabeçalho corrompido", data, size);
+  if (header->file_size != size)
+    return reject_snapshot(path, "tamanho incorreto", data, size);
+
+  uint64_t num_words = header->num_words;
+  uint64_t expected[SNAPSHOT_NUM_SECTIONS] = {
+      [SNAPSHOT_STRINGS] = header->sections[SNAPSHOT_STRINGS].size,
+      [SNAPSHOT_SONGS] = header->num_songs * (uint64_t)sizeof(SnapshotSong),
+      [SNAPSHOT_LENGTHS] = header->num_songs * (uint64_t)sizeof(uint32_t),
+      [SNAPSHOT_LINES] = header->num_lines * (uint64_t)sizeof(uint64_t),
+      [SNAPSHOT_WORDS] = num_words * sizeof(SnapshotWord),
+      [SNAPSHOT_PREFIXES] = (num_words + 1) * sizeof(uint64_t),
+      [SNAPSHOT_LOOKUP] = (num_words + 1) * sizeof(uint32_t),
+      [SNAPSHOT_FREQUENCY] = num_words * sizeof(uint32_t),
+      [SNAPSHOT_POSTINGS] = header->sections[SNAPSHOT_POSTINGS].size,
+      [SNAPSHOT_SKIPS] = header->sections[SNAPSHOT_SKIPS].size,
+  };
+  for (int i = 0; i < SNAPSHOT_NUM_SECTIONS; i++) {
+    SnapshotSection section = header->sections[i];
+    if (section.offset % SNAPSHOT_ALIGNMENT != 0 || section.offset > size ||
+        section.size > size - section.offset || section.size != expected[i])
+      return reject_snapshot(path, "seção fora do arquivo", data, size);
+  }
+  if (header->sections[SNAPSHOT_SKIPS].size % sizeof(PostingByteSkip) != 0)
+    return reject_snapshot(path, "pontos de salto incompletos", data, size);
+  const char *strings =
+      (const char *)data + header->sections[SNAPSHOT_STRINGS].offset;
+  size_t strings_size = header->sections[SNAPSHOT_STRINGS].size;
+  // Com o '\0' no início e no fim, nenhum texto passa do fim da seção.
+  if (strings_size == 0 || strings[0] != '\0' ||
+      strings[strings_size - 1] != '\0')
+    return reject_snapshot(path, "textos sem terminador", data, size);
+
+  if (verify) {
+    const unsigned char *body = (const unsigned char *)data;
+    if (header->body_checksum !=
+        snapshot_checksum(body + sizeof(SnapshotHeader),
+                          size - sizeof(SnapshotHeader)))
+      return reject_snapshot(path, "soma de verificação incorreta", data,
+                             size);
+  }
+
+  Snapshot *snapshot = (Snapshot *)malloc(sizeof(Snapshot));
+  if (snapshot == NULL) {
+    fprintf(stderr, "Falha na alocação de memória para Snapshot.\n");
+    exit(EXIT_FAILURE);
+  }
+  const unsigned char *bytes = (const unsigned char *)data;
+  snapshot->data = bytes;
+  snapshot->size = size;
+  snapshot->strings = strings;
+  snapshot->strings_size = strings_size;
+  snapshot->songs = (const SnapshotSong *)(bytes +
+                                           header->sections[SNAPSHOT_SONGS]
+                                               .offset);
+  snapshot->song_lengths =
+      (const uint32_t *)(bytes + header->sections[SNAPSHOT_LENGTHS].offset);
+  snapshot->lines =
+      (const uint64_t *)(bytes + header->sections[SNAPSHOT_LINES].offset);
+  snapshot->words =
+      (const SnapshotWord *)(bytes + header->sections[SNAPSHOT_WORDS].offset);
+  snapshot->prefixes =
+      (const uint64_t *)(bytes + header->sections[SNAPSHOT_PREFIXES].offset);
+  snapshot->lookup =
+      (const uint32_t *)(bytes + header->sections[SNAPSHOT_LOOKUP].offset);
+  snapshot->frequency =
+      (const uint32_t *)(bytes + header->sections[SNAPSHOT_FREQUENCY].offset);
+  snapshot->postings = bytes + header->sections[SNAPSHOT_POSTINGS].offset;
+  snapshot->postings_size = header->sections[SNAPSHOT_POSTINGS].size;
+  snapshot->skips =
+      (const PostingByteSkip *)(bytes +
+                                header->sections[SNAPSHOT_SKIPS].offset);
+  snapshot->num_skips =
+      header->sections[SNAPSHOT_SKIPS].size / sizeof(PostingByteSkip);
+  snapshot->total_length = header->total_length;
+  snapshot->num_songs = header->num_songs;
+  snapshot->num_lines = header->num_lines;
+  snapshot->num_words = header->num_words;
+  return snapshot;
+}
+
+Snapshot *load_snapshot(const char *path, bool verify) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("Erro ao abrir o arquivo do índice");
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    perror("Erro ao abrir o arquivo do índice");
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t)info.st_size;
+  if (size < sizeof(SnapshotHeader)) {
+    close(fd);
+    return reject_snapshot(path, "arquivo menor que o cabeçalho", NULL, 0);
+  }
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    perror("Erro ao mapear o arquivo do índice");
+    return NULL;
+  }
+  return open_image(path, data, size, verify);
+}
+
+Snapshot *build_snapshot(const Repository *repo, const WordArray *sorted,
+                         Node *frequency_root) {
+  size_t size;
+  unsigned char *image = build_image(repo, sorted, frequency_root, &size);
+  if (image == NULL)
+    return NULL;
+  // A partir daqui, a imagem não muda mais.
+  mprotect(image, size, PROT_READ);
+  return open_image("memória", image, size, false);
+}
+
+void free_snapshot(Snapshot *snapshot) {
+  if (snapshot == NULL)
+    return;
+  munmap((void *)snapshot->data, snapshot->size);
+  free(snapshot);
+}
+
+/**
+ * @brief Retorna o texto em um deslocamento de STRINGS, ou "" se o
+ * deslocamento for inválido.
+ */
+static const char *snapshot_string(const Snapshot *snapshot, uint64_t offset) {
+  return offset < snapshot->strings_size ? snapshot->strings + offset : "";
+}
+
+/**
+ * @brief Retorna o registro na posição k da ordem de Eytzinger, ou NULL se
+ * o índice gravado for inválido.
+ */
+static const SnapshotWord *lookup_word(const Snapshot *snapshot, size_t k) {
+  uint32_t index = snapshot->lookup[k];
+  return index < snapshot->num_words ? &snapshot->words[index] : NULL;
+}
+
+/**
+ * @brief Compara uma palavra com a posição k da ordem de Eytzinger, como
+ * compare_eytzinger.
+ */
+static inline int compare_lookup(const Snapshot *snapshot, size_t k,
+                                 const char *word, uint64_t prefix) {
+  if (prefix != snapshot->prefixes[k])
+    return prefix < snapshot->prefixes[k] ? -1 : 1;
+  if ((prefix & 0xFF) == 0)
+    return 0;
+  const SnapshotWord *candidate = lookup_word(snapshot, k);
+  if (candidate == NULL)
+    return 1;
+  const char *text = snapshot_string(snapshot, candidate->word);
+  // Um texto corrompido mais curto que o prefixo não é lido além do '\0'.
+  if (strnlen(text, 8) < 8)
+    return 1;
+  return strcmp(word + 8, text + 8);
+}
+
+const SnapshotWord *snapshot_find_word(const Snapshot *snapshot,
+                                       const char *word) {
+  uint64_t prefix = word_prefix(word);
+  size_t k = 1;
+  while (k <= snapshot->num_words) {
+    __builtin_prefetch(snapshot->prefixes + 8 * k);
+    k = 2 * k + (compare_lookup(snapshot, k, word, prefix) > 0);
+  }
+  k >>= __builtin_ffsll(~k);
+  if (k == 0 || compare_lookup(snapshot, k, word, prefix) != 0)
+    return NULL;
+  return lookup_word(snapshot, k);
+}
+
+size_t snapshot_prefix_range(const Snapshot *snapshot, const char *prefix,
+                             size_t *first) {
+  size_t length = strlen(prefix);
+  size_t low = 0, high = snapshot->num_words;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (strcmp(snapshot_string(snapshot, snapshot->words[mid].word), prefix) <
+        0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  *first = low;
+  high = snapshot->num_words;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (strncmp(snapshot_string(snapshot, snapshot->words[mid].word), prefix,
+                length) <= 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low - *first;
+}
+
+const SnapshotWord *snapshot_frequency_word(const Snapshot *snapshot,
+                                            size_t position) {
+  if (position >= snapshot->num_words)
+    return NULL;
+  uint32_t index = snapshot->frequency[position];
+  return index < snapshot->num_words ? &snapshot->words[index] : NULL;
+}
+
+size_t snapshot_frequency_lower_bound(const Snapshot *snapshot,
+                                      unsigned int frequency) {
+  size_t low = 0, high = snapshot->num_words;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    const SnapshotWord *word = snapshot_frequency_word(snapshot, mid);
+    if (word != NULL && word->total_word_count < frequency)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+size_t snapshot_frequency_after(const Snapshot *snapshot, unsigned int count,
+                                const char *word) {
+  size_t low = 0, high = snapshot->num_words;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    const SnapshotWord *other = snapshot_frequency_word(snapshot, mid);
+    if (other != NULL &&
+        (other->total_word_count < count ||
+         (other->total_word_count == count &&
+          strcmp(snapshot_string(snapshot, other->word), word) <= 0)))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+size_t snapshot_frequency_range(const Snapshot *snapshot,
+                                unsigned int min_frequency,
+                                unsigned int max_frequency, size_t *first) {
+  *first = snapshot_frequency_lower_bound(snapshot, min_frequency);
+  if (min_frequency > max_frequency)
+    return 0;
+  size_t end = snapshot->num_words;
+  if (max_frequency < UINT32_MAX)
+    end = snapshot_frequency_lower_bound(snapshot, max_frequency + 1);
+  return end > *first ? end - *first : 0;
+}
+
+size_t snapshot_frequency_position(const Snapshot *snapshot,
+                                   const SnapshotWord *word) {
+  // As palavras de mesma contagem ficam em ordem alfabética, que é a ordem
+  // de WORDS.
+  uint32_t index = (uint32_t)(word - snapshot->words);
+  size_t low = 0, high = snapshot->num_words;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    const SnapshotWord *other = snapshot_frequency_word(snapshot, mid);
+    if (other != NULL &&
+        (other->total_word_count < word->total_word_count ||
+         (other->total_word_count == word->total_word_count &&
+          snapshot->frequency[mid] < index)))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low < snapshot->num_words && snapshot->frequency[low] == index)
+    return low;
+  return snapshot->num_words;
+}
+
+/**
+ * @brief Confere se a lista de ocorrências de um registro está dentro da
+ * seção POSTINGS.
+ */
+static bool postings_in_section(const Snapshot *snapshot,
+                                const SnapshotWord *word) {
+  return word->postings <= snapshot->postings_size &&
+         word->postings_size <= snapshot->postings_size - word->postings;
+}
+
+size_t snapshot_word_postings(const Snapshot *snapshot,
+                              const SnapshotWord *word, Posting *postings,
+                              size_t max) {
+  if (!postings_in_section(snapshot, word))
+    return 0;
+  return decode_posting_bytes(snapshot->postings + word->postings,
+                              word->postings_size, word->num_songs, postings,
+                              max);
+}
+
+void snapshot_word_cursor(const Snapshot *snapshot, const SnapshotWord *word,
+                          PostingCursor *cursor) {
+  if (!postings_in_section(snapshot, word)) {
+    open_posting_bytes(cursor, snapshot->postings, 0, 0, NULL);
+    return;
+  }
+  const PostingByteSkip *skips = NULL;
+  uint64_t num_skips = posting_skip_count(word->num_songs);
+  if (word->skips <= snapshot->num_skips &&
+      num_skips <= snapshot->num_skips - word->skips)
+    skips = snapshot->skips + word->skips;
+  open_posting_bytes(cursor, snapshot->postings + word->postings,
+                     word->postings_size, word->num_songs, skips);
+}
+
+SnapshotWordText snapshot_word_text(const Snapshot *snapshot,
+                                    const SnapshotWord *word) {
+  SnapshotWordText text = {snapshot_string(snapshot, word->word), "", "", ""};
+  if (word->song_id < snapshot->num_songs) {
+    const SnapshotSong *song = &snapshot->songs[word->song_id];
+    text.title = snapshot_string(snapshot, song->title);
+    text.author = snapshot_string(snapshot, song->author);
+    uint64_t line = (uint64_t)song->first_line + word->verse_line;
+    if (word->verse_line < song->num_lines && line < snapshot->num_lines)
+      text.verse = snapshot_string(snapshot, snapshot->lines[line]);
+  }
+  return text;
+}
+
+/**
+ * @brief Confere se a lista de ocorrências de um registro tem num_songs
+ * músicas do catálogo em ordem estritamente crescente, cada uma com todas
+ * as suas posições e com contagem até a da melhor ocorrência (que limita a
+ * relevância da palavra no ranqueamento).
+ * @param positions Buffer das posições, realocado quando necessário.
+ * @param capacity Capacidade de *positions.
+ */
+static bool valid_postings(const Snapshot *snapshot, const SnapshotWord *word,
+                           uint32_t **positions, size_t *capacity) {
+  if (word->num_songs > snapshot->num_songs ||
+      !postings_in_section(snapshot, word))
+    return false;
+  PostingCursor cursor;
+  open_posting_bytes(&cursor, snapshot->postings + word->postings,
+                     word->postings_size, word->num_songs, NULL);
+  unsigned int previous = 0;
+  while (posting_cursor_next(&cursor)) {
+    if (cursor.song_id >= snapshot->num_songs ||
+        (cursor.index > 1 && cursor.song_id <= previous) ||
+        cursor.count > word->word_count_in_song)
+      return false;
+    previous = cursor.song_id;
+    if (cursor.count > *capacity) {
+      *capacity = cursor.count;
+      *positions = (uint32_t *)realloc(*positions,
+                                       *capacity * sizeof(uint32_t));
+      if (*positions == NULL) {
+        fprintf(stderr, "Falha na alocação de memória para as posições.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (posting_cursor_positions(&cursor, *positions) != cursor.count)
+      return false;
+  }
+  return !cursor.truncated && cursor.index == word->num_songs;
+}
+
+void snapshot_song_text(const Snapshot *snapshot, unsigned int song_id,
+                        const char **title, const char **author) {
+  *title = "";
+  *author = "";
+  if (song_id < snapshot->num_songs) {
+    *title = snapshot_string(snapshot, snapshot->songs[song_id].title);
+    *author = snapshot_string(snapshot, snapshot->songs[song_id].author);
+  }
+}
+
+bool restore_snapshot(const Snapshot *snapshot, Repository *repo) {
+  uint32_t *positions = NULL;
+  size_t positions_capacity = 0;
+
+  // Confere todas as referências antes de alterar o repositório.
+  for (uint32_t s = 0; s < snapshot->num_songs; s++) {
+    const SnapshotSong *song = &snapshot->songs[s];
+    if ((uint64_t)song->first_line + song->num_lines > snapshot->num_lines) {
+      fprintf(stderr, "Índice inválido: versos fora do catálogo.\n");
+      return false;
+    }
+  }
+  for (size_t k = 1; k <= snapshot->num_words; k++) {
+    const SnapshotWord *word = lookup_word(snapshot, k);
+    if (word == NULL || word->song_id >= snapshot->num_songs ||
+        word->verse_line >= snapshot->songs[word->song_id].num_lines ||
+        *snapshot_string(snapshot, word->word) == '\0' ||
+        !valid_postings(snapshot, word, &positions, &positions_capacity)) {
+      fprintf(stderr, "Índice inválido: registro de palavra corrompido.\n");
+      free(positions);
+      return false;
+    }
+  }
+  free(positions);
+
+  unsigned int song_offset = (unsigned int)repo->num_songs;
+  char **verses = NULL;
+  for (uint32_t s = 0; s < snapshot->num_songs; s++) {
+    const SnapshotSong *song = &snapshot->songs[s];
+    const char *title = snapshot_string(snapshot, song->title);
+    const char *author = snapshot_string(snapshot, song->author);
+    verses = (char **)realloc(verses, (song->num_lines + 1) * sizeof(char *));
+    if (verses == NULL) {
+      fprintf(stderr, "Erro de alocação de memória.\n");
+      exit(EXIT_FAILURE);
+    }
+    for (uint32_t l = 0; l < song->num_lines; l++) {
+      const char *verse =
+          snapshot_string(snapshot, snapshot->lines[song->first_line + l]);
+      verses[l] = arena_strndup(&repo->strings, verse, strlen(verse));
+    }
+    add_song(repo, arena_strndup(&repo->strings, title, strlen(title)),
+             arena_strndup(&repo->strings, author, strlen(author)), verses,
+             (int)song->num_lines, snapshot->song_lengths[s]);
+  }
+  free(verses);
+
+  // A ordem de Eytzinger é a de uma busca em largura numa árvore
+  // balanceada, de modo que a BST sem balanceamento também fica balanceada.
+  for (size_t k = 1; k <= snapshot->num_words; k++) {
+    const SnapshotWord *word = lookup_word(snapshot, k);
+    SongOccurrence occurrence = {song_offset + word->song_id,
+                                 word->verse_line, word->word_count_in_song};
+    bool created;
+    WordEntry *entry = add_word_occurrence(
+        &repo->dictionary, snapshot_string(snapshot, word->word),
+        word->total_word_count, &occurrence, &created);
+    PostingCursor cursor;
+    snapshot_word_cursor(snapshot, word, &cursor);
+    append_posting_cursor(word_postings(&repo->dictionary, entry),
+                          &repo->dictionary.posting_blocks, &cursor,
+                          song_offset);
+    if (created) {
+      insert_word(&repo->nodes, entry);
+      insert_word_avl(&repo->nodes, entry);
+    }
+  }
+  return true;
+}
@@ -1,4 +1,5 @@
 #include "include/structures.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,40 +8,42 @@ Tree *bin_tree = NULL;
 Tree *avl_tree = NULL;
 WordArray *sorted_word_array = NULL;
 Tree *avl_frequency_tree = NULL;
+EytzingerArray *eytzinger_array = NULL;
+bool bst_treap_mode = false;
+
+// Estado do gerador das prioridades da treap (xorshift64*). A semente fixa
+// torna o formato da árvore reproduzível entre execuções.
+static unsigned long long treap_random_state = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Sorteia a prioridade de um nó da treap.
+ */
+static unsigned int next_treap_priority(void) {
+  treap_random_state ^= treap_random_state >> 12;
+  treap_random_state ^= treap_random_state << 25;
+  treap_random_state ^= treap_random_state >> 27;
+  return (unsigned int)((treap_random_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
 
-Node *create_node(const char *word) {
-  Node *new_node = (Node *)malloc(sizeof(Node));
-  if (new_node == NULL) {
-    fprintf(stderr, "Falha na alocação de memória para o Nó.\n");
-    exit(EXIT_FAILURE);
-  }
-  new_node->word = strdup(word);
-  if (new_node->word == NULL) {
-    fprintf(stderr, "Falha na alocação de memória para a palavra.\n");
-    exit(EXIT_FAILURE);
-  }
-  new_node->total_word_count = 1;
+Node *create_node(Arena *arena, WordEntry *entry) {
+  Node *new_node = (Node *)arena_alloc(arena, sizeof(Node));
+  new_node->entry = entry;
+  new_node->key_prefix = word_prefix(entry->word);
+  new_node->key_length = (unsigned int)strlen(entry->word);
   new_node->height = 1;
-  new_node->best_song_occurrence = NULL;
+  new_node->priority = 0;
+  new_node->size = 1;
   new_node->left = NULL;
   new_node->right = NULL;
   return new_node;
 }
 
-SongOccurrence *create_song_occurrence(const char *title, const char *author,
-                                       const char *verse_snippet,
-                                       unsigned int word_count_in_song) {
-  SongOccurrence *new_occurrence =
-      (SongOccurrence *)malloc(sizeof(SongOccurrence));
-  if (new_occurrence == NULL) {
-    fprintf(stderr, "Falha na alocação de memória para SongOccurrence.\n");
-    exit(EXIT_FAILURE);
-  }
-  new_occurrence->title = strdup(title);
-  new_occurrence->author = strdup(author);
-  new_occurrence->verse_snippet = strdup(verse_snippet);
-  new_occurrence->word_count_in_song = word_count_in_song;
-  return new_occurrence;
+/**
+ * @brief Chave de busca de um nó, a partir dos campos já calculados.
+ */
+static inline WordKey node_key(const Node *node) {
+  WordKey key = {node->key_prefix, node->key_length, node->entry->word};
+  return key;
 }
 
 Node *right_rotate(Node *y) {
@@ -81,6 +84,8 @@ Node *right_rotate_frequency(Node *y) {
 
   y->height = max(height_node(y->left), height_node(y->right)) + 1;
   x->height = max(height_node(x->left), height_node(x->right)) + 1;
+  x->size = y->size;
+  y->size = 1 + size_node(y->left) + size_node(y->right);
   return x;
 }
 
@@ -97,106 +102,54 @@ Node *left_rotate_frequency(Node *x) {
 
   x->height = max(height_node(x->left), height_node(x->right)) + 1;
   y->height = max(height_node(y->left), height_node(y->right)) + 1;
+  y->size = x->size;
+  x->size = 1 + size_node(x->left) + size_node(x->right);
   return y;
 }
 
-// Modificar a função insert_node_recursive em tree.c
-void insert_node_recursive(Node *current, Node *new_node) {
-  int comparison = strcmp(new_node->word, current->word);
+void insert_node_bst(Node **root, Node *new_node) {
+  WordKey key = node_key(new_node);
+  Node **link = root;
+  while (*link != NULL) {
+    int comparison = compare_word_key(&key, *link);
+    if (comparison == 0)
+      return;
+    link = comparison < 0 ? &(*link)->left : &(*link)->right;
+  }
+  *link = new_node;
+}
+
+Node *insert_node_treap_recursive(Node *current, Node *new_node) {
+  if (current == NULL)
+    return new_node;
 
+  WordKey key = node_key(new_node);
+  int comparison = compare_word_key(&key, current);
   if (comparison < 0) {
-    if (current->left == NULL) {
-      current->left = new_node;
-    } else {
-      insert_node_recursive(current->left, new_node);
-    }
+    current->left = insert_node_treap_recursive(current->left, new_node);
+    if (current->left->priority > current->priority)
+      return right_rotate(current);
   } else if (comparison > 0) {
-    if (current->right == NULL) {
-      current->right = new_node;
-    } else {
-      insert_node_recursive(current->right, new_node);
-    }
-  } else {
-    // Palavra já existe - incrementar contagem total pelo número de ocorrências
-    // na música
-    if (new_node->best_song_occurrence != NULL) {
-      current->total_word_count +=
-          new_node->best_song_occurrence->word_count_in_song;
-    } else {
-      current->total_word_count++;
-    }
-
-    // Verificar se esta nova ocorrência tem mais aparições na música
-    if (new_node->best_song_occurrence != NULL &&
-        (current->best_song_occurrence == NULL ||
-         new_node->best_song_occurrence->word_count_in_song >
-             current->best_song_occurrence->word_count_in_song)) {
-      // Substituir com a nova ocorrência (tem mais aparições)
-      if (current->best_song_occurrence != NULL) {
-        free(current->best_song_occurrence->title);
-        free(current->best_song_occurrence->author);
-        free(current->best_song_occurrence->verse_snippet);
-        free(current->best_song_occurrence);
-      }
-      current->best_song_occurrence = new_node->best_song_occurrence;
-      new_node->best_song_occurrence = NULL;
-    } else if (new_node->best_song_occurrence != NULL) {
-      // Liberar a nova ocorrência (tem menos aparições)
-      free(new_node->best_song_occurrence->title);
-      free(new_node->best_song_occurrence->author);
-      free(new_node->best_song_occurrence->verse_snippet);
-      free(new_node->best_song_occurrence);
-    }
-    free(new_node->word);
-    free(new_node);
+    current->right = insert_node_treap_recursive(current->right, new_node);
+    if (current->right->priority > current->priority)
+      return left_rotate(current);
   }
+  return current;
 }
 
-// Modificar também insert_node_avl_recursive com a mesma lógica
 Node *insert_node_avl_recursive(Node *current, Node *new_node) {
   if (current == NULL) {
     return new_node;
   }
 
-  int comparison = strcmp(new_node->word, current->word);
+  WordKey key = node_key(new_node);
+  int comparison = compare_word_key(&key, current);
 
   if (comparison < 0) {
     current->left = insert_node_avl_recursive(current->left, new_node);
   } else if (comparison > 0) {
     current->right = insert_node_avl_recursive(current->right, new_node);
   } else {
-    // Palavra já existe - incrementar contagem total pelo número de ocorrências
-    // na música
-    if (new_node->best_song_occurrence != NULL) {
-      current->total_word_count +=
-          new_node->best_song_occurrence->word_count_in_song;
-    } else {
-      current->total_word_count++;
-    }
-
-    // Verificar se esta nova ocorrência tem mais aparições na música
-    if (new_node->best_song_occurrence != NULL &&
-        (current->best_song_occurrence == NULL ||
-         new_node->best_song_occurrence->word_count_in_song >
-             current->best_song_occurrence->word_count_in_song)) {
-      // Substituir com a nova ocorrência (tem mais aparições)
-      if (current->best_song_occurrence != NULL) {
-        free(current->best_song_occurrence->title);
-        free(current->best_song_occurrence->author);
-        free(current->best_song_occurrence->verse_snippet);
-        free(current->best_song_occurrence);
-      }
-      current->best_song_occurrence = new_node->best_song_occurrence;
-      new_node->best_song_occurrence = NULL;
-    } else if (new_node->best_song_occurrence != NULL) {
-      // Liberar a nova ocorrência (tem menos aparições)
-      free(new_node->best_song_occurrence->title);
-      free(new_node->best_song_occurrence->author);
-      free(new_node->best_song_occurrence->verse_snippet);
-      free(new_node->best_song_occurrence);
-    }
-    free(new_node->word);
-    free(new_node);
     return current;
   }
 
@@ -205,20 +158,20 @@ Node *insert_node_avl_recursive(Node *current, Node *new_node) {
   int balance = get_balance(current);
 
   // Caso Esquerda-Esquerda
-  if (balance > 1 && strcmp(new_node->word, current->left->word) < 0) {
+  if (balance > 1 && compare_word_key(&key, current->left) < 0) {
     return right_rotate(current);
   }
   // Caso Direita-Direita
-  if (balance < -1 && strcmp(new_node->word, current->right->word) > 0) {
+  if (balance < -1 && compare_word_key(&key, current->right) > 0) {
     return left_rotate(current);
   }
   // Caso Esquerda-Direita
-  if (balance > 1 && strcmp(new_node->word, current->left->word) > 0) {
+  if (balance > 1 && compare_word_key(&key, current->left) > 0) {
     current->left = left_rotate(current->left);
     return right_rotate(current);
   }
   // Caso Direita-Esquerda
-  if (balance < -1 && strcmp(new_node->word, current->right->word) < 0) {
+  if (balance < -1 && compare_word_key(&key, current->right) < 0) {
     current->right = right_rotate(current->right);
     return left_rotate(current);
   }
@@ -226,116 +179,174 @@ Node *insert_node_avl_recursive(Node *current, Node *new_node) {
   return current;
 }
 
+/**
+ * @brief Compara uma chave (contagem, palavra) com a chave de um nó da árvore
+ * de frequência.
+ */
+static int compare_frequency_key(unsigned int count, const WordKey *key,
+                                 const Node *node) {
+  if (count != node->entry->indexed_count)
+    return count < node->entry->indexed_count ? -1 : 1;
+  // Mesma frequência, compara por palavra para manter a unicidade
+  return compare_word_key(key, node);
+}
+
+/**
+ * @brief Atualiza a altura e o tamanho de um nó da árvore de frequência e o
+ * rebalanceia.
+ * @return A nova raiz da subárvore.
+ */
+static Node *rebalance_frequency(Node *node) {
+  node->height = 1 + max(height_node(node->left), height_node(node->right));
+  node->size = 1 + size_node(node->left) + size_node(node->right);
+  int balance = get_balance(node);
+
+  if (balance > 1) {
+    // Caso Esquerda-Direita
+    int left_balance = get_balance(node->left);
+    if (left_balance < 0) {
+      node->left = left_rotate_frequency(node->left);
+    }
+    return right_rotate_frequency(node);
+  }
+  if (balance < -1) {
+    // Caso Direita-Esquerda
+    int right_balance = get_balance(node->right);
+    if (right_balance > 0) {
+      node->right = right_rotate_frequency(node->right);
+    }
+    return left_rotate_frequency(node);
+  }
+  return node;
+}
+
 Node *insert_node_avl_frequency_recursive(Node *current, Node *new_node) {
   if (current == NULL)
     return new_node;
 
-  if (new_node->total_word_count < current->total_word_count) {
+  WordKey key = node_key(new_node);
+  int cmp =
+      compare_frequency_key(new_node->entry->indexed_count, &key, current);
+  if (cmp < 0) {
     current->left =
         insert_node_avl_frequency_recursive(current->left, new_node);
-  } else if (new_node->total_word_count > current->total_word_count) {
+  } else if (cmp > 0) {
     current->right =
         insert_node_avl_frequency_recursive(current->right, new_node);
   } else {
-    // Mesma frequência, compara por palavra para manter a unicidade
-    if (new_node->word == NULL || current->word == NULL) {
-      free(new_node->word);
-      free(new_node);
-      return current;
-    }
-
-    int cmp = strcmp(new_node->word, current->word);
-    if (cmp < 0) {
-      current->left =
-          insert_node_avl_frequency_recursive(current->left, new_node);
-    } else if (cmp > 0) {
-      current->right =
-          insert_node_avl_frequency_recursive(current->right, new_node);
-    } else {
-      free(new_node->word);
-      free(new_node);
-      return current;
-    }
+    return current;
   }
 
-  current->height =
-      1 + max(height_node(current->left), height_node(current->right));
-  int balance = get_balance(current);
+  return rebalance_frequency(current);
+}
 
-  // Realiza rotações com base na comparação de frequência
-  // Caso Esquerda-Esquerda
-  if (balance > 1 && current->left != NULL &&
-      new_node->total_word_count < current->left->total_word_count) {
-    return right_rotate_frequency(current);
+/**
+ * @brief Desliga o nó de menor chave de uma subárvore de frequência.
+ * @param current A raiz da subárvore.
+ * @param minimum Recebe o nó desligado.
+ * @return A nova raiz da subárvore.
+ */
+static Node *detach_minimum_frequency(Node *current, Node **minimum) {
+  if (current->left == NULL) {
+    *minimum = current;
+    return current->right;
   }
+  current->left = detach_minimum_frequency(current->left, minimum);
+  return rebalance_frequency(current);
+}
 
-  // Caso Direita-Direita
-  if (balance < -1 && current->right != NULL &&
-      new_node->total_word_count > current->right->total_word_count) {
-    return left_rotate_frequency(current);
-  }
+Node *remove_node_avl_frequency_recursive(Node *current, unsigned int count,
+                                          const char *word, Node **removed) {
+  if (current == NULL)
+    return NULL;
 
-  // Caso Esquerda-Direita
-  if (balance > 1 && current->left != NULL &&
-      new_node->total_word_count > current->left->total_word_count) {
-    current->left = left_rotate_frequency(current->left);
-    return right_rotate_frequency(current);
+  WordKey key = make_word_key(word);
+  int cmp = compare_frequency_key(count, &key, current);
+  if (cmp < 0) {
+    current->left = remove_node_avl_frequency_recursive(current->left, count,
+                                                        word, removed);
+  } else if (cmp > 0) {
+    current->right = remove_node_avl_frequency_recursive(current->right, count,
+                                                         word, removed);
+  } else {
+    *removed = current;
+    if (current->left == NULL)
+      return current->right;
+    if (current->right == NULL)
+      return current->left;
+
+    // Dois filhos: o sucessor ocupa o lugar do nó removido.
+    Node *successor;
+    Node *right = detach_minimum_frequency(current->right, &successor);
+    successor->left = current->left;
+    successor->right = right;
+    current = successor;
   }
 
-  // Caso Direita-Esquerda
-  if (balance < -1 && current->right != NULL &&
-      new_node->total_word_count < current->right->total_word_count) {
-    current->right = right_rotate_frequency(current->right);
-    return left_rotate_frequency(current);
+  return rebalance_frequency(current);
+}
+
+void reindex_frequency_entry(Arena *arena, WordEntry *entry) {
+  if (avl_frequency_tree == NULL)
+    initialize_tree(avl_frequency_tree);
+
+  Node *node = NULL;
+  if (entry->indexed_count != 0) {
+    avl_frequency_tree->root = remove_node_avl_frequency_recursive(
+        avl_frequency_tree->root, entry->indexed_count, entry->word, &node);
+  }
+  if (node == NULL) {
+    node = create_node(arena, entry);
   }
 
-  return current;
+  // O nó removido é reaproveitado com a nova chave.
+  node->height = 1;
+  node->size = 1;
+  node->left = NULL;
+  node->right = NULL;
+  entry->indexed_count = entry->total_word_count;
+  avl_frequency_tree->root =
+      insert_node_avl_frequency_recursive(avl_frequency_tree->root, node);
 }
 
-void insert_node(Node *new_node) {
+void insert_word(Arena *arena, WordEntry *entry) {
   if (bin_tree == NULL)
     initialize_tree(bin_tree);
-  if (bin_tree->root == NULL)
-    bin_tree->root = new_node;
-  else
-    insert_node_recursive(bin_tree->root, new_node);
+  Node *new_node = create_node(arena, entry);
+  if (bst_treap_mode) {
+    new_node->priority = next_treap_priority();
+    bin_tree->root = insert_node_treap_recursive(bin_tree->root, new_node);
+  } else {
+    insert_node_bst(&bin_tree->root, new_node);
+  }
 }
-void insert_node_avl(Node *new_node) {
+
+void insert_word_avl(Arena *arena, WordEntry *entry) {
   if (avl_tree == NULL)
     initialize_tree(avl_tree);
-  avl_tree->root = insert_node_avl_recursive(avl_tree->root, new_node);
+  avl_tree->root =
+      insert_node_avl_recursive(avl_tree->root, create_node(arena, entry));
 }
 
-Node *search_bst(Node *root, const char *word) {
-  if (root == NULL || strcmp(root->word, word) == 0)
-    return root;
-  if (strcmp(word, root->word) < 0)
-    return search_bst(root->left, word);
-  else
-    return search_bst(root->right, word);
-}
-Node *search_avl(Node *root, const char *word) {
-  if (root == NULL || strcmp(root->word, word) == 0)
-    return root;
-  if (strcmp(word, root->word) < 0)
-    return search_avl(root->left, word);
-  else
-    return search_avl(root->right, word);
+/**
+ * @brief Desce iterativamente por uma árvore ordenada por palavra.
+ */
+static WordEntry *search_word_tree(Node *root, const char *word) {
+  WordKey key = make_word_key(word);
+  while (root != NULL) {
+    int comparison = compare_word_key(&key, root);
+    if (comparison == 0)
+      return root->entry;
+    root = comparison < 0 ? root->left : root->right;
+  }
+  return NULL;
 }
 
-void free_tree(Node *node) {
-  if (node == NULL)
-    return;
-  free_tree(node->left);
-  free_tree(node->right);
-  if (node->best_song_occurrence != NULL) {
-    free(node->best_song_occurrence->title);
-    free(node->best_song_occurrence->author);
-    free(node->best_song_occurrence->verse_snippet);
-    free(node->best_song_occurrence);
-  }
-  free(node->word);
-  free(node);
+WordEntry *search_bst(Node *root, const char *word) {
+  return search_word_tree(root, word);
+}
+WordEntry *search_avl(Node *root, const char *word) {
+  return search_word_tree(root, word);
 }
 
 WordArray *create_word_array() {
@@ -346,39 +357,40 @@ WordArray *create_word_array() {
   }
   arr->size = 0;
   arr->capacity = 10;
-  arr->nodes = (Node **)malloc(arr->capacity * sizeof(Node *));
-  if (!arr->nodes) {
+  arr->entries = (WordEntry **)malloc(arr->capacity * sizeof(WordEntry *));
+  if (!arr->entries) {
     fprintf(stderr, "falha no malloc\n");
     exit(1);
   }
   return arr;
 }
-void add_node_to_array(WordArray *arr, Node *node) {
+void add_entry_to_array(WordArray *arr, WordEntry *entry) {
   if (arr->size == arr->capacity) {
     arr->capacity *= 2;
-    arr->nodes = (Node **)realloc(arr->nodes, arr->capacity * sizeof(Node *));
-    if (!arr->nodes) {
+    arr->entries = (WordEntry **)realloc(arr->entries,
+                                         arr->capacity * sizeof(WordEntry *));
+    if (!arr->entries) {
       fprintf(stderr, "falha no realloc\n");
       exit(1);
     }
   }
-  arr->nodes[arr->size++] = node;
+  arr->entries[arr->size++] = entry;
 }
-int compare_nodes(const void *a, const void *b) {
-  Node *node_a = *(Node **)a;
-  Node *node_b = *(Node **)b;
-  return strcmp(node_a->word, node_b->word);
+int compare_entries(const void *a, const void *b) {
+  WordEntry *entry_a = *(WordEntry **)a;
+  WordEntry *entry_b = *(WordEntry **)b;
+  return strcmp(entry_a->word, entry_b->word);
 }
 void sort_word_array(WordArray *arr) {
-  qsort(arr->nodes, arr->size, sizeof(Node *), compare_nodes);
+  qsort(arr->entries, arr->size, sizeof(WordEntry *), compare_entries);
 }
-Node *binary_search_array(WordArray *arr, const char *word) {
+WordEntry *binary_search_array(WordArray *arr, const char *word) {
   int low = 0, high = arr->size - 1;
   while (low <= high) {
     int mid = low + (high - low) / 2;
-    int cmp = strcmp(word, arr->nodes[mid]->word);
+    int cmp = strcmp(word, arr->entries[mid]->word);
     if (cmp == 0)
-      return arr->nodes[mid];
+      return arr->entries[mid];
     else if (cmp < 0)
       high = mid - 1;
     else
@@ -386,52 +398,183 @@ Node *binary_search_array(WordArray *arr, const char *word) {
   }
   return NULL;
 }
+void merge_into_word_array(WordArray *arr, WordArray *additions) {
+  if (additions->size == 0)
+    return;
+  sort_word_array(additions);
+
+  int total = arr->size + additions->size;
+  if (total > arr->capacity) {
+    while (arr->capacity < total)
+      arr->capacity *= 2;
+    arr->entries = (WordEntry **)realloc(arr->entries,
+                                         arr->capacity * sizeof(WordEntry *));
+    if (!arr->entries) {
+      fprintf(stderr, "falha no realloc\n");
+      exit(1);
+    }
+  }
+
+  // Intercala a partir do final: para cada acréscimo, do maior para o menor,
+  // uma busca binária encontra sua posição e o bloco de registros maiores é
+  // deslocado de uma vez. Os registros menores que o primeiro acréscimo não
+  // se movem.
+  int end = arr->size;
+  for (int j = additions->size - 1; j >= 0; j--) {
+    WordEntry *addition = additions->entries[j];
+    int low = 0, high = end;
+    while (low < high) {
+      int mid = low + (high - low) / 2;
+      if (strcmp(arr->entries[mid]->word, addition->word) < 0)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    memmove(&arr->entries[low + j + 1], &arr->entries[low],
+            (end - low) * sizeof(WordEntry *));
+    arr->entries[low + j] = addition;
+    end = low;
+  }
+  arr->size = total;
+}
 void free_word_array(WordArray *arr) {
   if (arr == NULL)
     return;
-  free(arr->nodes);
+  free(arr->entries);
   free(arr);
 }
 
-void populate_array_from_tree(Node *node, WordArray *arr) {
-  if (node == NULL)
-    return;
-  populate_array_from_tree(node->left, arr);
-  add_node_to_array(arr, node);
-  populate_array_from_tree(node->right, arr);
+uint64_t word_prefix(const char *word) {
+  uint64_t prefix = 0;
+  int i = 0;
+  for (; i < 8 && word[i] != '\0'; i++)
+    prefix = (prefix << 8) | (unsigned char)word[i];
+  // Deslocar 64 bits é indefinido: a palavra vazia tem prefixo 0.
+  if (i == 0)
+    return 0;
+  return prefix << (8 * (8 - i));
 }
 
-void free_frequency_tree(Node *node) {
-  if (node == NULL)
-    return;
-  free_frequency_tree(node->left);
-  free_frequency_tree(node->right);
+WordKey make_word_key(const char *word) {
+  WordKey key = {word_prefix(word), (unsigned int)strlen(word), word};
+  return key;
+}
+
+/**
+ * @brief Compara uma palavra com a posição k de um EytzingerArray.
+ *
+ * A string só é acessada quando os prefixos empatam e a palavra tem mais de
+ * 8 bytes (palavras mais curtas com o mesmo prefixo são iguais).
+ */
+static inline int compare_eytzinger(const EytzingerArray *layout, size_t k,
+                                    const char *word, uint64_t prefix) {
+  if (prefix != layout->prefixes[k])
+    return prefix < layout->prefixes[k] ? -1 : 1;
+  if ((prefix & 0xFF) == 0)
+    return 0;
+  return strcmp(word + 8, layout->entries[k]->word + 8);
+}
+
+/**
+ * @brief Copia o array ordenado para a ordem de Eytzinger (em-ordem sobre
+ * as posições implícitas).
+ * @return O índice do próximo registro do array ordenado.
+ */
+static int fill_eytzinger(EytzingerArray *layout, const WordArray *arr,
+                          int next, size_t k) {
+  if (k > layout->size)
+    return next;
+  next = fill_eytzinger(layout, arr, next, 2 * k);
+  layout->entries[k] = arr->entries[next];
+  layout->prefixes[k] = word_prefix(arr->entries[next]->word);
+  next++;
+  return fill_eytzinger(layout, arr, next, 2 * k + 1);
+}
+
+EytzingerArray *build_eytzinger_array(const WordArray *arr) {
+  EytzingerArray *layout = (EytzingerArray *)malloc(sizeof(EytzingerArray));
+  if (!layout) {
+    fprintf(stderr, "falha no malloc\n");
+    exit(1);
+  }
+  layout->size = arr->size;
+  // Alinhado a 64 bytes para que cada linha de cache contenha 8 prefixos
+  // consecutivos (os descendentes de um nó três níveis abaixo).
+  size_t prefix_bytes = ((layout->size + 1) * sizeof(uint64_t) + 63) & ~63;
+  layout->prefixes = (uint64_t *)aligned_alloc(64, prefix_bytes);
+  layout->entries =
+      (WordEntry **)malloc((layout->size + 1) * sizeof(WordEntry *));
+  if (!layout->prefixes || !layout->entries) {
+    fprintf(stderr, "falha no malloc\n");
+    exit(1);
+  }
+  layout->prefixes[0] = 0;
+  layout->entries[0] = NULL;
+  fill_eytzinger(layout, arr, 0, 1);
+  return layout;
+}
 
-  if (node->word != NULL) {
-    free(node->word);
+WordEntry *search_eytzinger(const EytzingerArray *layout, const char *word) {
+  uint64_t prefix = word_prefix(word);
+  size_t k = 1;
+  while (k <= layout->size) {
+    __builtin_prefetch(layout->prefixes + 8 * k);
+    k = 2 * k + (compare_eytzinger(layout, k, word, prefix) > 0);
   }
+  // Desfaz as descidas à direita finais: k passa a ser a posição do menor
+  // elemento >= palavra (0 se não houver).
+  k >>= __builtin_ffsll(~k);
+  if (k == 0 || compare_eytzinger(layout, k, word, prefix) != 0)
+    return NULL;
+  return layout->entries[k];
+}
+
+void free_eytzinger_array(EytzingerArray *layout) {
+  if (layout == NULL)
+    return;
+  free(layout->prefixes);
+  free(layout->entries);
+  free(layout);
+}
 
-  if (node->best_song_occurrence != NULL) {
-    free(node->best_song_occurrence->title);
-    free(node->best_song_occurrence->author);
-    free(node->best_song_occurrence->verse_snippet);
-    free(node->best_song_occurrence);
+void populate_array_from_tree(Node *node, WordArray *arr) {
+  int depth = 0, capacity = 64;
+  Node **stack = (Node **)malloc(capacity * sizeof(Node *));
+  if (!stack) {
+    fprintf(stderr, "falha no malloc\n");
+    exit(1);
   }
 
-  free(node);
+  while (node != NULL || depth > 0) {
+    // Desce pela esquerda empilhando os ancestrais.
+    while (node != NULL) {
+      if (depth == capacity) {
+        capacity *= 2;
+        stack = (Node **)realloc(stack, capacity * sizeof(Node *));
+        if (!stack) {
+          fprintf(stderr, "falha no realloc\n");
+          exit(1);
+        }
+      }
+      stack[depth++] = node;
+      node = node->left;
+    }
+    node = stack[--depth];
+    add_entry_to_array(arr, node->entry);
+    node = node->right;
+  }
+  free(stack);
 }
 
-void populate_frequency_avl_tree(Node *root) {
+void populate_frequency_avl_tree(Arena *arena, Node *root) {
   if (root == NULL)
     return;
 
-  populate_frequency_avl_tree(root->left);
+  populate_frequency_avl_tree(arena, root->left);
 
-  // Cria um novo nó para a árvore AVL de frequência, duplicando dados
-  // relevantes
-  Node *new_freq_node = create_node(root->word);
-  new_freq_node->total_word_count = root->total_word_count;
-  new_freq_node->best_song_occurrence = NULL;
+  // O nó de frequência aponta para o mesmo registro do nó principal.
+  Node *new_freq_node = create_node(arena, root->entry);
+  root->entry->indexed_count = root->entry->total_word_count;
 
   if (avl_frequency_tree == NULL) {
     avl_frequency_tree = (Tree *)malloc(sizeof(Tree));
@@ -446,42 +589,153 @@ void populate_frequency_avl_tree(Node *root) {
   avl_frequency_tree->root = insert_node_avl_frequency_recursive(
       avl_frequency_tree->root, new_freq_node);
 
-  populate_frequency_avl_tree(root->right);
+  populate_frequency_avl_tree(arena, root->right);
 }
 
-Node *search_avl_frequency(Node *root, unsigned int frequency) {
+WordEntry *search_avl_frequency(Node *root, unsigned int frequency) {
   if (root == NULL)
     return NULL;
 
-  if (frequency == root->total_word_count)
-    return root;
-  else if (frequency < root->total_word_count)
+  if (frequency == root->entry->indexed_count)
+    return root->entry;
+  else if (frequency < root->entry->indexed_count)
     return search_avl_frequency(root->left, frequency);
   else
     return search_avl_frequency(root->right, frequency);
 }
 
-void collect_words_by_frequency(Node *root, unsigned int frequency,
-                                WordArray *result) {
-  if (root == NULL) {
-    return;
+/**
+ * @brief Conta os registros com contagem menor que frequency (ou menor ou
+ * igual, se inclusive), somando os tamanhos das subárvores à esquerda da
+ * descida.
+ */
+static size_t count_below_frequency(Node *node, unsigned int frequency,
+                                    bool inclusive) {
+  size_t count = 0;
+  while (node != NULL) {
+    unsigned int node_count = node->entry->indexed_count;
+    if (node_count < frequency || (inclusive && node_count == frequency)) {
+      count += size_node(node->left) + 1;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
   }
+  return count;
+}
 
-  if (root->total_word_count < frequency) {
-    collect_words_by_frequency(root->right, frequency, result);
-  } else {
-    // Se a frequência for >=, procure na subárvore esquerda por mais resultados
-    // válidos.
-    collect_words_by_frequency(root->left, frequency, result);
-    // Adicione o nó atual ao resultado.
-    add_node_to_array(result, root);
-    // Todos os nós na subárvore direita também são válidos, adicione todos.
-    populate_array_from_tree(root->right, result);
-  }
+size_t count_frequency_range(Node *root, unsigned int min_frequency,
+                             unsigned int max_frequency) {
+  if (min_frequency > max_frequency)
+    return 0;
+  return count_below_frequency(root, max_frequency, true) -
+         count_below_frequency(root, min_frequency, false);
 }
 
 WordArray *search_all_by_frequency(Node *root, unsigned int frequency) {
   WordArray *results = create_word_array();
-  collect_words_by_frequency(root, frequency, results);
+  FrequencyCursor cursor;
+  frequency_cursor_start(&cursor, root, frequency, UINT_MAX);
+  for (WordEntry *entry; (entry = frequency_cursor_next(&cursor)) != NULL;)
+    add_entry_to_array(results, entry);
+  return results;
+}
+
+WordArray *search_top_frequency(Node *root, size_t k) {
+  WordArray *results = create_word_array();
+  Node *stack[FREQUENCY_STACK_DEPTH];
+  int depth = 0;
+  Node *node = root;
+
+  // Percurso em-ordem invertido: desce pela direita empilhando os
+  // ancestrais e para assim que k registros foram coletados.
+  while ((node != NULL || depth > 0) && (size_t)results->size < k) {
+    while (node != NULL) {
+      stack[depth++] = node;
+      node = node->right;
+    }
+    node = stack[--depth];
+    add_entry_to_array(results, node->entry);
+    node = node->left;
+  }
   return results;
 }
+
+WordEntry *select_frequency(Node *root, size_t position) {
+  while (root != NULL) {
+    size_t left = size_node(root->left);
+    if (position < left) {
+      root = root->left;
+    } else if (position == left) {
+      return root->entry;
+    } else {
+      position -= left + 1;
+      root = root->right;
+    }
+  }
+  return NULL;
+}
+
+size_t rank_frequency(Node *root, const WordEntry *entry) {
+  WordKey key = make_word_key(entry->word);
+  size_t rank = 0;
+  while (root != NULL) {
+    int cmp = compare_frequency_key(entry->indexed_count, &key, root);
+    if (cmp < 0) {
+      root = root->left;
+    } else if (cmp == 0) {
+      return rank + size_node(root->left);
+    } else {
+      rank += size_node(root->left) + 1;
+      root = root->right;
+    }
+  }
+  return rank;
+}
+
+void frequency_cursor_start(FrequencyCursor *cursor, Node *root,
+                            unsigned int min_frequency,
+                            unsigned int max_frequency) {
+  cursor->depth = 0;
+  cursor->max_frequency = max_frequency;
+  // Empilha os nós em que a descida vai para a esquerda: o topo é o menor
+  // nó com contagem >= min_frequency.
+  while (root != NULL) {
+    if (root->entry->indexed_count >= min_frequency) {
+      cursor->stack[cursor->depth++] = root;
+      root = root->left;
+    } else {
+      root = root->right;
+    }
+  }
+}
+
+void frequency_cursor_start_after(FrequencyCursor *cursor, Node *root,
+                                  unsigned int count, const char *word,
+                                  unsigned int max_frequency) {
+  WordKey key = make_word_key(word);
+  cursor->depth = 0;
+  cursor->max_frequency = max_frequency;
+  while (root != NULL) {
+    if (compare_frequency_key(count, &key, root) < 0) {
+      cursor->stack[cursor->depth++] = root;
+      root = root->left;
+    } else {
+      root = root->right;
+    }
+  }
+}
+
+WordEntry *frequency_cursor_next(FrequencyCursor *cursor) {
+  if (cursor->depth == 0)
+    return NULL;
+  Node *node = cursor->stack[--cursor->depth];
+  if (node->entry->indexed_count > cursor->max_frequency) {
+    cursor->depth = 0;
+    return NULL;
+  }
+  // O sucessor é o menor nó da subárvore direita, ou o próximo ancestral.
+  for (Node *child = node->right; child != NULL; child = child->left)
+    cursor->stack[cursor->depth++] = child;
+  return node->entry;
+}
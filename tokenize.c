@@ -0,0 +1,296 @@
+/**
+ * @file tokenize.c
+ * @brief Implementações escalar e vetoriais (SSE2 e AVX2) do tokenizador.
+ *
+ * As versões vetoriais classificam blocos de 64 bytes de uma vez: cada byte
+ * vira um bit em uma máscara de delimitadores e em uma máscara de bytes de
+ * palavra, e o bloco é copiado para o destino já em minúsculas. Os limites
+ * dos tokens saem das máscaras com ctz, sem percorrer os bytes; apenas os
+ * tokens que contêm pontuação são compactados byte a byte.
+ */
+
+#include "include/tokenize.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TOKENIZE_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Indica se um byte separa tokens (mesmos delimitadores do strtok
+ * original).
+ */
+static inline bool is_token_delimiter(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Indica se um byte é alfanumérico ASCII (isalnum no locale "C").
+ */
+static inline bool is_word_byte(char c) {
+  return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+static size_t tokenize_line_scalar(const char *line, size_t length, char *out,
+                                   TokenSpan *tokens) {
+  size_t num_tokens = 0, i = 0;
+  while (i < length) {
+    while (i < length && is_token_delimiter(line[i])) {
+      i++;
+    }
+    if (i == length) {
+      break;
+    }
+
+    size_t start = i, out_length = 0;
+    for (; i < length && !is_token_delimiter(line[i]); i++) {
+      char c = line[i];
+      if (is_word_byte(c)) {
+        out[start + out_length++] = c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+      }
+    }
+    tokens[num_tokens].offset = (uint32_t)start;
+    tokens[num_tokens].length = (uint32_t)out_length;
+    num_tokens++;
+  }
+  return num_tokens;
+}
+
+static bool always_supported(void) { return true; }
+
+#ifdef TOKENIZE_X86
+
+/**
+ * @struct BlockMasks
+ * @brief Classificação de um bloco de 64 bytes (bit i = byte i).
+ */
+typedef struct {
+  uint64_t delimiters; /**< Espaço, tabulação, '\n' ou '\r'. */
+  uint64_t word_bytes; /**< Bytes alfanuméricos ASCII. */
+} BlockMasks;
+
+/**
+ * @brief Remove a pontuação de um token já convertido para minúsculas.
+ * @return O comprimento do token compactado.
+ */
+static size_t compact_token(char *token, size_t length) {
+  size_t out_length = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (is_word_byte(token[i])) {
+      token[out_length++] = token[i];
+    }
+  }
+  return out_length;
+}
+
+/**
+ * @brief Percorre uma linha em blocos de 64 bytes e extrai os tokens das
+ * máscaras produzidas por classify.
+ *
+ * Os bits além do fim da linha são tratados como delimitadores. Um último
+ * bloco incompleto é copiado para um buffer local, pois ler além do fim da
+ * linha seria ler fora do objeto do chamador.
+ */
+static inline __attribute__((always_inline)) size_t
+tokenize_blocks(const char *line, size_t length, char *out, TokenSpan *tokens,
+                BlockMasks (*classify)(const char *block, char *out)) {
+  size_t num_tokens = 0, start = 0;
+  bool open = false, has_punctuation = false;
+  char tail[64];
+
+  for (size_t base = 0; base < length; base += 64) {
+    const char *block = line + base;
+    size_t remaining = length - base;
+    if (remaining < 64) {
+      memcpy(tail, block, remaining);
+      block = tail;
+    }
+    BlockMasks masks = classify(block, out + base);
+    uint64_t delimiters = masks.delimiters;
+    uint64_t word_bytes = masks.word_bytes;
+    if (remaining < 64) {
+      // Os bytes além da linha viram delimitadores.
+      delimiters |= ~0ULL << remaining;
+      word_bytes &= ~(~0ULL << remaining);
+    }
+    uint64_t punctuation = ~delimiters & ~word_bytes;
+
+    unsigned int position = 0;
+    for (;;) {
+      if (!open) {
+        uint64_t starts = ~delimiters & (~0ULL << position);
+        if (starts == 0) {
+          break;
+        }
+        position = (unsigned int)__builtin_ctzll(starts);
+        start = base + position;
+        open = true;
+        has_punctuation = false;
+      }
+
+      uint64_t ends = delimiters & (~0ULL << position);
+      if (ends == 0) {
+        // O token continua no próximo bloco.
+        has_punctuation |= (punctuation >> position) != 0;
+        break;
+      }
+      unsigned int end = (unsigned int)__builtin_ctzll(ends);
+      uint64_t inside = (~0ULL << position) & ((1ULL << end) - 1);
+      has_punctuation |= (punctuation & inside) != 0;
+
+      size_t token_length = base + end - start;
+      if (has_punctuation) {
+        token_length = compact_token(out + start, token_length);
+      }
+      tokens[num_tokens].offset = (uint32_t)start;
+      tokens[num_tokens].length = (uint32_t)token_length;
+      num_tokens++;
+      open = false;
+      position = end;
+    }
+  }
+
+  // Só acontece quando o comprimento é múltiplo de 64 e a linha termina no
+  // meio de um token.
+  if (open) {
+    size_t token_length = length - start;
+    if (has_punctuation) {
+      token_length = compact_token(out + start, token_length);
+    }
+    tokens[num_tokens].offset = (uint32_t)start;
+    tokens[num_tokens].length = (uint32_t)token_length;
+    num_tokens++;
+  }
+  return num_tokens;
+}
+
+// Classificação por comparações com sinal: somar (0x80 - primeiro) leva o
+// intervalo [primeiro, primeiro + n) para [-128, -128 + n).
+
+__attribute__((target("sse2"))) static inline BlockMasks
+classify_block_sse2(const char *block, char *out) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  const __m128i upper_shift = _mm_set1_epi8((char)(0x80 - 'A'));
+  const __m128i lower_shift = _mm_set1_epi8((char)(0x80 - 'a'));
+  const __m128i digit_shift = _mm_set1_epi8((char)(0x80 - '0'));
+  const __m128i letter_limit = _mm_set1_epi8(-128 + 26);
+  const __m128i digit_limit = _mm_set1_epi8(-128 + 10);
+
+  BlockMasks masks = {0, 0};
+  for (int i = 0; i < 4; i++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+    __m128i delimiters =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                  _mm_cmpeq_epi8(v, tab)),
+                     _mm_or_si128(_mm_cmpeq_epi8(v, newline),
+                                  _mm_cmpeq_epi8(v, carriage_return)));
+    __m128i upper =
+        _mm_cmplt_epi8(_mm_add_epi8(v, upper_shift), letter_limit);
+    __m128i letter = _mm_cmplt_epi8(
+        _mm_add_epi8(_mm_or_si128(v, case_bit), lower_shift), letter_limit);
+    __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, digit_shift), digit_limit);
+
+    _mm_storeu_si128((__m128i *)(out + 16 * i),
+                     _mm_add_epi8(v, _mm_and_si128(upper, case_bit)));
+    masks.delimiters |= (uint64_t)(uint16_t)_mm_movemask_epi8(delimiters)
+                        << (16 * i);
+    masks.word_bytes |=
+        (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(letter, digit))
+        << (16 * i);
+  }
+  return masks;
+}
+
+__attribute__((target("avx2"))) static inline BlockMasks
+classify_block_avx2(const char *block, char *out) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  const __m256i upper_shift = _mm256_set1_epi8((char)(0x80 - 'A'));
+  const __m256i lower_shift = _mm256_set1_epi8((char)(0x80 - 'a'));
+  const __m256i digit_shift = _mm256_set1_epi8((char)(0x80 - '0'));
+  const __m256i letter_limit = _mm256_set1_epi8(-128 + 26);
+  const __m256i digit_limit = _mm256_set1_epi8(-128 + 10);
+
+  BlockMasks masks = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(block + 32 * i));
+    __m256i delimiters = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                        _mm256_cmpeq_epi8(v, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, newline),
+                        _mm256_cmpeq_epi8(v, carriage_return)));
+    __m256i upper =
+        _mm256_cmpgt_epi8(letter_limit, _mm256_add_epi8(v, upper_shift));
+    __m256i letter = _mm256_cmpgt_epi8(
+        letter_limit,
+        _mm256_add_epi8(_mm256_or_si256(v, case_bit), lower_shift));
+    __m256i digit =
+        _mm256_cmpgt_epi8(digit_limit, _mm256_add_epi8(v, digit_shift));
+
+    _mm256_storeu_si256((__m256i *)(out + 32 * i),
+                        _mm256_add_epi8(v, _mm256_and_si256(upper, case_bit)));
+    masks.delimiters |= (uint64_t)(uint32_t)_mm256_movemask_epi8(delimiters)
+                        << (32 * i);
+    masks.word_bytes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                            _mm256_or_si256(letter, digit))
+                        << (32 * i);
+  }
+  return masks;
+}
+
+__attribute__((target("sse2"))) static size_t
+tokenize_line_sse2(const char *line, size_t length, char *out,
+                   TokenSpan *tokens) {
+  return tokenize_blocks(line, length, out, tokens, classify_block_sse2);
+}
+
+__attribute__((target("avx2"))) static size_t
+tokenize_line_avx2(const char *line, size_t length, char *out,
+                   TokenSpan *tokens) {
+  return tokenize_blocks(line, length, out, tokens, classify_block_avx2);
+}
+
+static bool sse2_supported(void) { return __builtin_cpu_supports("sse2"); }
+
+static bool avx2_supported(void) { return __builtin_cpu_supports("avx2"); }
+
+#endif // TOKENIZE_X86
+
+const TokenizerKernel tokenizer_kernels[] = {
+    {"escalar", tokenize_line_scalar, always_supported},
+#ifdef TOKENIZE_X86
+    {"sse2", tokenize_line_sse2, sse2_supported},
+    {"avx2", tokenize_line_avx2, avx2_supported},
+#endif
+};
+
+const size_t num_tokenizer_kernels =
+    sizeof(tokenizer_kernels) / sizeof(tokenizer_kernels[0]);
+
+// Implementação escolhida na primeira chamada. Threads que chegam juntas
+// fazem a mesma escolha, então a corrida é inofensiva.
+static TokenizeFunction selected_tokenizer = NULL;
+
+size_t tokenize_line(const char *line, size_t length, char *out,
+                     TokenSpan *tokens) {
+  TokenizeFunction tokenize =
+      __atomic_load_n(&selected_tokenizer, __ATOMIC_RELAXED);
+  if (tokenize == NULL) {
+    for (size_t i = num_tokenizer_kernels; i-- > 0;) {
+      if (tokenizer_kernels[i].supported()) {
+        tokenize = tokenizer_kernels[i].tokenize;
+        break;
+      }
+    }
+    __atomic_store_n(&selected_tokenizer, tokenize, __ATOMIC_RELAXED);
+  }
+  return tokenize(line, length, out, tokens);
+}